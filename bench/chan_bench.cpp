@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include <t_ut/chan.hpp>
+
+namespace
+{
+
+/// Round trip latency of one value sent to another thread and back
+void bm_chan_ping_pong(benchmark::State& state)
+{
+    t_ut::chan<int, 16> ping;
+    t_ut::chan<int, 16> pong;
+
+    std::thread echo([ping, pong]() mutable {
+        for(int value = ping.receive(); value >= 0; value = ping.receive())
+            pong.send(value);
+    });
+
+    int value = 0;
+    for(auto _ : state)
+    {
+        ping.send(value);
+        benchmark::DoNotOptimize(value = pong.receive());
+        ++value;
+    }
+
+    ping.send(-1);
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_chan_ping_pong)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include <t_ut/compile_time_bimap.hpp>
+#include <t_ut/compile_time_map.hpp>
+
+namespace
+{
+
+constexpr size_t map_size = 64;
+
+template <t_ut::lookup_strategy STRATEGY, size_t... Is>
+constexpr auto make_opcode_map(std::index_sequence<Is...>)
+{
+    return t_ut::compile_time_map<int, int, sizeof...(Is), STRATEGY>{std::pair<int, int>{static_cast<int>(Is * 3), static_cast<int>(Is)}...};
+}
+
+template <size_t SIZE, t_ut::lookup_strategy STRATEGY>
+constexpr auto opcodes = make_opcode_map<STRATEGY>(std::make_index_sequence<SIZE>{});
+
+template <typename MAP>
+void run_lookup(benchmark::State& state, const MAP& map, size_t size = map_size)
+{
+    int key = 0;
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(map.at(key));
+        key = (key + 3) % static_cast<int>(size * 3);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <size_t SIZE, t_ut::lookup_strategy STRATEGY>
+void bm_compile_time_map_lookup(benchmark::State& state)
+{
+    run_lookup(state, opcodes<SIZE, STRATEGY>, SIZE);
+}
+BENCHMARK(bm_compile_time_map_lookup<8, t_ut::lookup_strategy::linear>);
+BENCHMARK(bm_compile_time_map_lookup<8, t_ut::lookup_strategy::perfect_hash>);
+BENCHMARK(bm_compile_time_map_lookup<64, t_ut::lookup_strategy::linear>);
+BENCHMARK(bm_compile_time_map_lookup<64, t_ut::lookup_strategy::sorted>);
+BENCHMARK(bm_compile_time_map_lookup<64, t_ut::lookup_strategy::perfect_hash>);
+BENCHMARK(bm_compile_time_map_lookup<512, t_ut::lookup_strategy::linear>);
+BENCHMARK(bm_compile_time_map_lookup<512, t_ut::lookup_strategy::sorted>);
+BENCHMARK(bm_compile_time_map_lookup<512, t_ut::lookup_strategy::perfect_hash>);
+
+void bm_std_map_lookup(benchmark::State& state)
+{
+    std::map<int, int> map;
+    for(size_t i = 0; i < map_size; ++i)
+        map.emplace(static_cast<int>(i * 3), static_cast<int>(i));
+    run_lookup(state, map);
+}
+BENCHMARK(bm_std_map_lookup);
+
+void bm_std_unordered_map_lookup(benchmark::State& state)
+{
+    std::unordered_map<int, int> map;
+    for(size_t i = 0; i < map_size; ++i)
+        map.emplace(static_cast<int>(i * 3), static_cast<int>(i));
+    run_lookup(state, map);
+}
+BENCHMARK(bm_std_unordered_map_lookup);
+
+constexpr std::array<std::string_view, 32> header_names{
+    "accept", "accept-charset", "accept-encoding", "accept-language", "accept-ranges", "age", "allow",
+    "authorization", "cache-control", "connection", "content-disposition", "content-encoding", "content-language",
+    "content-length", "content-location", "content-range", "content-type", "cookie", "date", "etag", "expect",
+    "expires", "from", "host", "if-match", "if-modified-since", "if-none-match", "last-modified", "location",
+    "referer", "set-cookie", "user-agent"};
+
+template <t_ut::lookup_strategy STRATEGY, size_t... Is>
+constexpr auto make_header_map(std::index_sequence<Is...>)
+{
+    return t_ut::compile_time_map<std::string_view, int, sizeof...(Is), STRATEGY>{
+        std::pair<std::string_view, int>{header_names[Is], static_cast<int>(Is)}...};
+}
+
+template <t_ut::lookup_strategy STRATEGY>
+constexpr auto headers = make_header_map<STRATEGY>(std::make_index_sequence<header_names.size()>{});
+
+template <typename MAP>
+void run_header_lookup(benchmark::State& state, const MAP& map)
+{
+    size_t index = 0;
+    for(auto _ : state)
+    {
+        std::string_view name = header_names[index];
+        benchmark::DoNotOptimize(name);
+        benchmark::DoNotOptimize(map.find(name));
+        index = (index + 7) % header_names.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <t_ut::lookup_strategy STRATEGY>
+void bm_compile_time_map_header_lookup(benchmark::State& state)
+{
+    run_header_lookup(state, headers<STRATEGY>);
+}
+BENCHMARK(bm_compile_time_map_header_lookup<t_ut::lookup_strategy::linear>);
+BENCHMARK(bm_compile_time_map_header_lookup<t_ut::lookup_strategy::sorted>);
+BENCHMARK(bm_compile_time_map_header_lookup<t_ut::lookup_strategy::perfect_hash>);
+
+void bm_std_unordered_map_header_lookup(benchmark::State& state)
+{
+    std::unordered_map<std::string_view, int> map;
+    for(size_t i = 0; i < header_names.size(); ++i)
+        map.emplace(header_names[i], static_cast<int>(i));
+    run_header_lookup(state, map);
+}
+BENCHMARK(bm_std_unordered_map_header_lookup);
+
+enum class header : uint8_t
+{};
+
+template <size_t... Is>
+constexpr auto make_header_bimap(std::index_sequence<Is...>)
+{
+    return t_ut::compile_time_bimap<header, std::string_view, sizeof...(Is)>{
+        std::pair<header, std::string_view>{static_cast<header>(Is), header_names[Is]}...};
+}
+
+constexpr auto header_bimap = make_header_bimap(std::make_index_sequence<header_names.size()>{});
+
+/// Hand written table as the bimap replaces it
+constexpr std::string_view header_name_scan(header value)
+{
+    for(size_t i = 0; i < header_names.size(); ++i)
+    {
+        if(static_cast<header>(i) == value)
+            return header_names[i];
+    }
+    return {};
+}
+
+constexpr header header_value_scan(std::string_view name)
+{
+    for(size_t i = 0; i < header_names.size(); ++i)
+    {
+        if(header_names[i] == name)
+            return static_cast<header>(i);
+    }
+    return {};
+}
+
+template <typename FUNC>
+void run_header_to_name(benchmark::State& state, FUNC&& func)
+{
+    size_t index = 0;
+    for(auto _ : state)
+    {
+        auto value = static_cast<header>(index);
+        benchmark::DoNotOptimize(value);
+        benchmark::DoNotOptimize(func(value));
+        index = (index + 7) % header_names.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bm_bimap_enum_to_name(benchmark::State& state)
+{
+    run_header_to_name(state, [](header value) { return *header_bimap.left().find(value); });
+}
+BENCHMARK(bm_bimap_enum_to_name);
+
+void bm_scan_enum_to_name(benchmark::State& state)
+{
+    run_header_to_name(state, header_name_scan);
+}
+BENCHMARK(bm_scan_enum_to_name);
+
+void bm_bimap_name_to_enum(benchmark::State& state)
+{
+    run_header_lookup(state, header_bimap.right());
+}
+BENCHMARK(bm_bimap_name_to_enum);
+
+void bm_scan_name_to_enum(benchmark::State& state)
+{
+    size_t index = 0;
+    for(auto _ : state)
+    {
+        std::string_view name = header_names[index];
+        benchmark::DoNotOptimize(name);
+        benchmark::DoNotOptimize(header_value_scan(name));
+        index = (index + 7) % header_names.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_scan_name_to_enum);
+
+} // namespace
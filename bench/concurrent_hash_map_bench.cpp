@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <t_ut/concurrent_hash_map.hpp>
+
+namespace
+{
+
+struct session
+{
+    uint64_t user;
+    std::array<uint32_t, 6> flags;
+};
+
+constexpr uint64_t key_count = 1 << 16;
+constexpr uint64_t lookups = 256;
+
+/// Every thread looks up random existing keys, one in 16 lookups is replaced by an update when write is set
+template <typename MAP>
+void session_cache(benchmark::State& state, MAP& map, bool write)
+{
+    uint64_t key = static_cast<uint64_t>(state.thread_index()) * 0x9E3779B97F4A7C15ULL;
+    for(auto _ : state)
+    {
+        for(uint64_t i = 0; i < lookups; ++i)
+        {
+            key = key * 6364136223846793005ULL + 1442695040888963407ULL;
+            const uint64_t k = (key >> 32) % key_count;
+            if(write && i % 16 == 0)
+                map.insert_or_assign(k, session{k, {}});
+            else
+                benchmark::DoNotOptimize(map.find(k));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(lookups));
+}
+
+/// unordered_map behind a shared_mutex, the usual way to share a map today
+class locked_map
+{
+public:
+    std::optional<session> find(uint64_t key) const
+    {
+        const std::shared_lock<std::shared_mutex> lock{m_mutex};
+        if(auto it = m_map.find(key); it != m_map.end())
+            return it->second;
+        return std::nullopt;
+    }
+
+    void insert_or_assign(uint64_t key, const session& value)
+    {
+        const std::lock_guard<std::shared_mutex> lock{m_mutex};
+        m_map.insert_or_assign(key, value);
+    }
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint64_t, session> m_map;
+};
+
+/// Never destroyed, the benchmark threads may still retire nodes of the concurrent map into the global domain
+template <typename MAP>
+MAP& filled()
+{
+    static auto* map = []() {
+        auto* m = new MAP;
+        for(uint64_t k = 0; k < key_count; ++k)
+            m->insert_or_assign(k, session{k, {}});
+        return m;
+    }();
+    return *map;
+}
+
+void bm_map_find_locked(benchmark::State& state)
+{
+    session_cache(state, filled<locked_map>(), false);
+}
+BENCHMARK(bm_map_find_locked)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_map_find_concurrent(benchmark::State& state)
+{
+    session_cache(state, filled<t_ut::concurrent_hash_map<uint64_t, session>>(), false);
+}
+BENCHMARK(bm_map_find_concurrent)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_map_mixed_locked(benchmark::State& state)
+{
+    session_cache(state, filled<locked_map>(), true);
+}
+BENCHMARK(bm_map_mixed_locked)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_map_mixed_concurrent(benchmark::State& state)
+{
+    session_cache(state, filled<t_ut::concurrent_hash_map<uint64_t, session>>(), true);
+}
+BENCHMARK(bm_map_mixed_concurrent)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+} // namespace
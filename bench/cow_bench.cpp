@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include <t_ut/cow.hpp>
+
+namespace
+{
+
+/// Stand-in for a config snapshot that is handed to every worker
+std::vector<std::string> make_config(size_t entries)
+{
+    std::vector<std::string> config;
+    for(size_t i = 0; i < entries; ++i)
+        config.push_back("some.config.key." + std::to_string(i) + " = a value that does not fit into SSO");
+    return config;
+}
+
+template <typename COW>
+void bm_cow_copy(benchmark::State& state)
+{
+    const COW config{std::in_place, make_config(static_cast<size_t>(state.range(0)))};
+    for(auto _ : state)
+    {
+        COW copy = config;
+        benchmark::DoNotOptimize(copy.ref().data());
+    }
+}
+BENCHMARK(bm_cow_copy<t_ut::cow<std::vector<std::string>>>)->Arg(16)->Arg(256);
+BENCHMARK(bm_cow_copy<t_ut::local_cow<std::vector<std::string>>>)->Arg(16)->Arg(256);
+
+void bm_deep_copy(benchmark::State& state)
+{
+    const auto config = make_config(static_cast<size_t>(state.range(0)));
+    for(auto _ : state)
+    {
+        auto copy = config;
+        benchmark::DoNotOptimize(copy.data());
+    }
+}
+BENCHMARK(bm_deep_copy)->Arg(16)->Arg(256);
+
+} // namespace
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <t_ut/function_ref.hpp>
+#include <t_ut/move_only_function.hpp>
+
+namespace
+{
+
+std::vector<int> random_input(size_t count)
+{
+    std::mt19937 gen{42};
+    std::vector<int> values(count);
+    for(int& value : values)
+        value = static_cast<int>(gen());
+    return values;
+}
+
+template <typename COMPARE>
+void sort_with_template(std::vector<int>& values, COMPARE compare)
+{
+    std::sort(values.begin(), values.end(), compare);
+}
+
+void sort_with_function_ref(std::vector<int>& values, t_ut::function_ref<bool(int, int) const noexcept> compare)
+{
+    std::sort(values.begin(), values.end(), compare);
+}
+
+void sort_with_std_function(std::vector<int>& values, const std::function<bool(int, int)>& compare)
+{
+    std::sort(values.begin(), values.end(), compare);
+}
+
+void sort_with_move_only_function(std::vector<int>& values, const t_ut::move_only_function<bool(int, int)>& compare)
+{
+    std::sort(values.begin(), values.end(), std::cref(compare));
+}
+
+constexpr auto less = [](int lhs, int rhs) noexcept { return lhs < rhs; };
+
+template <typename SORT>
+void run_sort(benchmark::State& state, SORT sort)
+{
+    const auto input = random_input(static_cast<size_t>(state.range(0)));
+    std::vector<int> values;
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        values = input;
+        state.ResumeTiming();
+
+        sort(values);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void bm_sort_template(benchmark::State& state)
+{
+    run_sort(state, [](std::vector<int>& values) { sort_with_template(values, less); });
+}
+BENCHMARK(bm_sort_template)->Arg(1 << 10)->Arg(1 << 16);
+
+void bm_sort_function_ref(benchmark::State& state)
+{
+    run_sort(state, [](std::vector<int>& values) { sort_with_function_ref(values, less); });
+}
+BENCHMARK(bm_sort_function_ref)->Arg(1 << 10)->Arg(1 << 16);
+
+void bm_sort_std_function(benchmark::State& state)
+{
+    run_sort(state, [](std::vector<int>& values) { sort_with_std_function(values, less); });
+}
+BENCHMARK(bm_sort_std_function)->Arg(1 << 10)->Arg(1 << 16);
+
+void bm_sort_move_only_function(benchmark::State& state)
+{
+    run_sort(state, [](std::vector<int>& values) { sort_with_move_only_function(values, less); });
+}
+BENCHMARK(bm_sort_move_only_function)->Arg(1 << 10)->Arg(1 << 16);
+
+} // namespace
@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <list>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <t_ut/arena_resource.hpp>
+#include <t_ut/slab_pool_resource.hpp>
+
+namespace
+{
+
+/// Temporaries of a typical request: a list of strings and a list of small nodes, all freed at the end
+void handle_request(std::pmr::memory_resource* resource)
+{
+    std::pmr::vector<std::pmr::string> fields{resource};
+    std::pmr::list<int> ids{resource};
+    for(int i = 0; i < 256; ++i)
+    {
+        fields.emplace_back(static_cast<size_t>(32 + i % 32), 'x');
+        ids.push_back(i);
+    }
+    benchmark::DoNotOptimize(fields.data());
+    benchmark::DoNotOptimize(ids.back());
+}
+
+void bm_request_new_delete(benchmark::State& state)
+{
+    for(auto _ : state)
+        handle_request(std::pmr::new_delete_resource());
+}
+BENCHMARK(bm_request_new_delete);
+
+void bm_request_std_monotonic(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        std::pmr::monotonic_buffer_resource monotonic;
+        handle_request(&monotonic);
+    }
+}
+BENCHMARK(bm_request_std_monotonic);
+
+/// The arena is reset after every request and keeps its chunks, so only the first request allocates upstream
+void bm_request_arena(benchmark::State& state)
+{
+    t_ut::arena_resource arena;
+    for(auto _ : state)
+    {
+        handle_request(&arena);
+        arena.reset();
+    }
+}
+BENCHMARK(bm_request_arena);
+
+void bm_request_slab_pool(benchmark::State& state)
+{
+    t_ut::slab_pool_resource pool;
+    for(auto _ : state)
+        handle_request(&pool);
+}
+BENCHMARK(bm_request_slab_pool);
+
+/// Allocates and frees a batch of small blocks, from several threads to show contention on shared resources
+void alloc_free(benchmark::State& state, std::pmr::memory_resource* resource)
+{
+    std::array<void*, 64> blocks;
+    for(auto _ : state)
+    {
+        for(void*& block : blocks)
+            block = resource->allocate(48, 8);
+        benchmark::DoNotOptimize(blocks.data());
+        for(void* block : blocks)
+            resource->deallocate(block, 48, 8);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(blocks.size()));
+}
+
+void bm_alloc_free_new_delete(benchmark::State& state)
+{
+    alloc_free(state, std::pmr::new_delete_resource());
+}
+BENCHMARK(bm_alloc_free_new_delete)->Threads(1)->Threads(4);
+
+std::pmr::synchronized_pool_resource std_pool;
+
+void bm_alloc_free_std_synchronized_pool(benchmark::State& state)
+{
+    alloc_free(state, &std_pool);
+}
+BENCHMARK(bm_alloc_free_std_synchronized_pool)->Threads(1)->Threads(4);
+
+t_ut::slab_pool_resource slab_pool;
+
+void bm_alloc_free_slab_pool(benchmark::State& state)
+{
+    alloc_free(state, &slab_pool);
+}
+BENCHMARK(bm_alloc_free_slab_pool)->Threads(1)->Threads(4);
+
+} // namespace
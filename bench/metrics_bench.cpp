@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <t_ut/metrics.hpp>
+
+namespace
+{
+
+/// Every thread counts events, the baseline is the one shared atomic that sharding replaces
+void bm_count_shared_atomic(benchmark::State& state)
+{
+    static std::atomic<uint64_t> count = 0;
+    for(auto _ : state)
+        count.fetch_add(1, std::memory_order_relaxed);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_count_shared_atomic)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_count_counter(benchmark::State& state)
+{
+    static t_ut::counter count;
+    for(auto _ : state)
+        count.add();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_count_counter)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_histogram_record(benchmark::State& state)
+{
+    static t_ut::histogram latencies;
+    uint64_t value = 1000 + static_cast<uint64_t>(state.thread_index());
+    for(auto _ : state)
+    {
+        latencies.record(value);
+        value = value * 13 % 100003;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_histogram_record)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_histogram_snapshot(benchmark::State& state)
+{
+    t_ut::histogram latencies;
+    for(uint64_t v = 1; v < 100000; v += 7)
+        latencies.record(v);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(latencies.snapshot().percentile(99));
+}
+BENCHMARK(bm_histogram_snapshot);
+
+void bm_prometheus_export(benchmark::State& state)
+{
+    t_ut::metrics_registry registry;
+    for(int i = 0; i < 8; ++i)
+    {
+        const std::string labels = "shard=\"" + std::to_string(i) + "\"";
+        registry.get_counter("requests_total", "Requests", labels).add(static_cast<uint64_t>(i));
+        registry.get_histogram("latency_nanoseconds", "Latency", labels).record(static_cast<uint64_t>(1000 * i));
+    }
+    for(auto _ : state)
+        benchmark::DoNotOptimize(registry.to_prometheus());
+}
+BENCHMARK(bm_prometheus_export);
+
+} // namespace
@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+#include <t_ut/object_pool.hpp>
+#include <t_ut/slab_pool_resource.hpp>
+
+namespace
+{
+
+struct node
+{
+    std::array<uint64_t, 8> payload;
+};
+
+constexpr size_t batch = 64;
+
+/// Every thread creates a batch of nodes and destroys them again, with up to 32 threads contending for the allocator
+template <typename CREATE, typename DESTROY>
+void create_destroy(benchmark::State& state, CREATE create, DESTROY destroy)
+{
+    std::array<node*, batch> nodes;
+    for(auto _ : state)
+    {
+        for(node*& n : nodes)
+            n = create();
+        benchmark::DoNotOptimize(nodes.data());
+        for(node* n : nodes)
+            destroy(n);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+
+void bm_pool_malloc(benchmark::State& state)
+{
+    create_destroy(state, []() { return new node; }, [](node* n) { delete n; });
+}
+BENCHMARK(bm_pool_malloc)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+void bm_pool_object_pool(benchmark::State& state)
+{
+    auto& pool = t_ut::object_pool<node>::shared();
+    create_destroy(state, [&]() { return pool.create(); }, [&](node* n) { pool.destroy(n); });
+}
+BENCHMARK(bm_pool_object_pool)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+t_ut::slab_pool_resource slab_pool;
+
+void bm_pool_slab_pool(benchmark::State& state)
+{
+    std::pmr::polymorphic_allocator<node> alloc{&slab_pool};
+    create_destroy(state, [&]() { return alloc.new_object<node>(); }, [&](node* n) { alloc.delete_object(n); });
+}
+BENCHMARK(bm_pool_slab_pool)->Threads(1)->Threads(4)->Threads(32)->UseRealTime();
+
+/// Nodes are created on one thread and destroyed on another, like the jobs of a thread_pool
+template <typename CREATE, typename DESTROY>
+void hand_over(benchmark::State& state, CREATE create, DESTROY destroy)
+{
+    static std::array<std::atomic<node*>, batch> slots{};
+    const bool producer = state.thread_index() == 0;
+    for(auto _ : state)
+    {
+        for(auto& slot : slots)
+        {
+            if(producer)
+            {
+                node* n = create();
+                node* expected = nullptr;
+                if(!slot.compare_exchange_strong(expected, n, std::memory_order_acq_rel))
+                    destroy(n);
+            }
+            else if(node* n = slot.exchange(nullptr, std::memory_order_acq_rel))
+            {
+                destroy(n);
+            }
+        }
+    }
+    for(auto& slot : slots)
+    {
+        if(node* n = slot.exchange(nullptr, std::memory_order_acq_rel))
+            destroy(n);
+    }
+    if(producer)
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+
+void bm_hand_over_malloc(benchmark::State& state)
+{
+    hand_over(state, []() { return new node; }, [](node* n) { delete n; });
+}
+BENCHMARK(bm_hand_over_malloc)->Threads(2)->UseRealTime();
+
+void bm_hand_over_object_pool(benchmark::State& state)
+{
+    auto& pool = t_ut::object_pool<node>::shared();
+    hand_over(state, [&]() { return pool.create(); }, [&](node* n) { pool.destroy(n); });
+}
+BENCHMARK(bm_hand_over_object_pool)->Threads(2)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include <t_ut/in_out_ptr.hpp>
+#include <t_ut/out_ptr.hpp>
+
+namespace
+{
+
+/// Stand in for a C API, the handles come from a static array so only the cost of passing them around is measured
+struct handle
+{
+    int value;
+};
+
+handle handles[2];
+
+[[gnu::noinline]] int handle_create(handle** out, int value)
+{
+    handle* result = &handles[value & 1];
+    result->value = value;
+    *out = result;
+    return 0;
+}
+
+[[gnu::noinline]] int handle_create_void(void** out, int value)
+{
+    return handle_create(reinterpret_cast<handle**>(out), value);
+}
+
+[[gnu::noinline]] int handle_replace(handle** in_out)
+{
+    return handle_create(in_out, (*in_out)->value + 1);
+}
+
+[[gnu::noinline]] void handle_free(handle* h)
+{
+    benchmark::DoNotOptimize(h);
+}
+
+struct handle_deleter
+{
+    void operator()(handle* h) const noexcept
+    {
+        handle_free(h);
+    }
+};
+
+using unique_handle = std::unique_ptr<handle, handle_deleter>;
+
+void bm_unique_raw(benchmark::State& state)
+{
+    unique_handle h;
+    int value = 0;
+    for(auto _ : state)
+    {
+        h.reset();
+        handle* raw = nullptr;
+        handle_create(&raw, ++value);
+        h.reset(raw);
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_unique_raw);
+
+void bm_unique_out_ptr(benchmark::State& state)
+{
+    unique_handle h;
+    int value = 0;
+    for(auto _ : state)
+    {
+        handle_create(t_ut::out_ptr{h}, ++value);
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_unique_out_ptr);
+
+void bm_unique_out_ptr_void(benchmark::State& state)
+{
+    unique_handle h;
+    int value = 0;
+    for(auto _ : state)
+    {
+        handle_create_void(t_ut::out_ptr<unique_handle, void*>{h}, ++value);
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_unique_out_ptr_void);
+
+void bm_unique_in_out_raw(benchmark::State& state)
+{
+    unique_handle h;
+    handle_create(t_ut::out_ptr{h}, 0);
+    for(auto _ : state)
+    {
+        handle* raw = h.release();
+        handle_replace(&raw);
+        h.reset(raw);
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_unique_in_out_raw);
+
+void bm_unique_in_out_ptr(benchmark::State& state)
+{
+    unique_handle h;
+    handle_create(t_ut::out_ptr{h}, 0);
+    for(auto _ : state)
+    {
+        handle_replace(t_ut::in_out_ptr{h});
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_unique_in_out_ptr);
+
+/// Both shared_ptr variants allocate a control block for the deleter, out_ptr adds nothing on top of it
+void bm_shared_raw(benchmark::State& state)
+{
+    std::shared_ptr<handle> h;
+    int value = 0;
+    for(auto _ : state)
+    {
+        h.reset();
+        handle* raw = nullptr;
+        handle_create(&raw, ++value);
+        h.reset(raw, handle_deleter{});
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_shared_raw);
+
+void bm_shared_out_ptr(benchmark::State& state)
+{
+    std::shared_ptr<handle> h;
+    int value = 0;
+    for(auto _ : state)
+    {
+        handle_create(t_ut::out_ptr{h, handle_deleter{}}, ++value);
+        benchmark::DoNotOptimize(h.get());
+    }
+}
+BENCHMARK(bm_shared_out_ptr);
+
+} // namespace
@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+#include <t_ut/cow.hpp>
+#include <t_ut/persistent_map.hpp>
+#include <t_ut/persistent_vector.hpp>
+
+namespace
+{
+
+/// Stand-in for a routing table with state.range(0) routes
+t_ut::persistent_map<uint32_t, uint64_t> make_table(int64_t routes)
+{
+    t_ut::persistent_map<uint32_t, uint64_t> table;
+    for(uint32_t i = 0; i < routes; ++i)
+        table = table.set(i * 2654435761u, i);
+    return table;
+}
+
+void bm_persistent_map_set(benchmark::State& state)
+{
+    const auto table = make_table(state.range(0));
+    uint32_t key = 0;
+    for(auto _ : state)
+    {
+        auto updated = table.set(key++ * 2654435761u, 42);
+        benchmark::DoNotOptimize(updated);
+    }
+}
+BENCHMARK(bm_persistent_map_set)->Arg(1 << 10)->Arg(1 << 17);
+
+/// What an update costs if every version is a full copy
+void bm_unordered_map_copy_set(benchmark::State& state)
+{
+    std::unordered_map<uint32_t, uint64_t> table;
+    for(uint32_t i = 0; i < state.range(0); ++i)
+        table[i * 2654435761u] = i;
+    uint32_t key = 0;
+    for(auto _ : state)
+    {
+        auto updated = table;
+        updated[key++ * 2654435761u] = 42;
+        benchmark::DoNotOptimize(updated);
+    }
+}
+BENCHMARK(bm_unordered_map_copy_set)->Arg(1 << 10)->Arg(1 << 17);
+
+void bm_persistent_map_find(benchmark::State& state)
+{
+    const auto table = make_table(state.range(0));
+    uint32_t key = 0;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(table.find(static_cast<uint32_t>(key++ % state.range(0)) * 2654435761u));
+}
+BENCHMARK(bm_persistent_map_find)->Arg(1 << 10)->Arg(1 << 17);
+
+void bm_unordered_map_find(benchmark::State& state)
+{
+    std::unordered_map<uint32_t, uint64_t> table;
+    for(uint32_t i = 0; i < state.range(0); ++i)
+        table[i * 2654435761u] = i;
+    uint32_t key = 0;
+    for(auto _ : state)
+        benchmark::DoNotOptimize(table.find(static_cast<uint32_t>(key++ % state.range(0)) * 2654435761u));
+}
+BENCHMARK(bm_unordered_map_find)->Arg(1 << 10)->Arg(1 << 17);
+
+void bm_atomic_cow_load(benchmark::State& state)
+{
+    const t_ut::atomic_cow<t_ut::persistent_map<uint32_t, uint64_t>> table{std::in_place, make_table(1024)};
+    for(auto _ : state)
+    {
+        auto snapshot = table.load();
+        benchmark::DoNotOptimize(snapshot->size());
+    }
+}
+BENCHMARK(bm_atomic_cow_load);
+
+void bm_persistent_vector_set(benchmark::State& state)
+{
+    t_ut::persistent_vector<uint64_t> vec;
+    for(int64_t i = 0; i < state.range(0); ++i)
+        vec = vec.push_back(static_cast<uint64_t>(i));
+    size_t index = 0;
+    for(auto _ : state)
+    {
+        auto updated = vec.set(index++ % vec.size(), 42);
+        benchmark::DoNotOptimize(updated);
+    }
+}
+BENCHMARK(bm_persistent_vector_set)->Arg(1 << 10)->Arg(1 << 17);
+
+void bm_persistent_vector_iterate(benchmark::State& state)
+{
+    t_ut::persistent_vector<uint64_t> vec;
+    for(int64_t i = 0; i < state.range(0); ++i)
+        vec = vec.push_back(static_cast<uint64_t>(i));
+    for(auto _ : state)
+    {
+        uint64_t sum = 0;
+        for(uint64_t value : vec)
+            sum += value;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_persistent_vector_iterate)->Arg(1 << 10)->Arg(1 << 17);
+
+} // namespace
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include <t_ut/ebr.hpp>
+#include <t_ut/hazard_pointer.hpp>
+
+namespace
+{
+
+struct config
+{
+    uint64_t version;
+    uint64_t limit;
+};
+
+/// Read side of a pointer that a writer replaces now and then, as in every snapshot swapping structure
+void bm_read_shared_ptr(benchmark::State& state)
+{
+    static std::atomic<std::shared_ptr<const config>> shared{std::make_shared<config>(config{1, 64})};
+    for(auto _ : state)
+    {
+        const auto snapshot = shared.load(std::memory_order_acquire);
+        benchmark::DoNotOptimize(snapshot->limit);
+    }
+}
+BENCHMARK(bm_read_shared_ptr)->Threads(1)->Threads(4)->UseRealTime();
+
+std::atomic<config*> current{new config{1, 64}};
+
+void bm_read_ebr_guard(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        const t_ut::ebr_guard guard;
+        benchmark::DoNotOptimize(current.load(std::memory_order_acquire)->limit);
+    }
+}
+BENCHMARK(bm_read_ebr_guard)->Threads(1)->Threads(4)->UseRealTime();
+
+void bm_read_hazard_pointer(benchmark::State& state)
+{
+    for(auto _ : state)
+    {
+        t_ut::hazard_pointer hazard;
+        benchmark::DoNotOptimize(hazard.protect(current)->limit);
+    }
+}
+BENCHMARK(bm_read_hazard_pointer)->Threads(1)->Threads(4)->UseRealTime();
+
+/// Replacing the pointer and retiring the old object, which includes the amortized cost of reclamation
+template <typename DOMAIN>
+void retire(benchmark::State& state)
+{
+    static std::atomic<config*> replaced{new config{1, 64}};
+    uint64_t version = 1;
+    for(auto _ : state)
+    {
+        config* old = replaced.exchange(new config{++version, 64}, std::memory_order_acq_rel);
+        DOMAIN::global().retire(old);
+    }
+}
+
+void bm_retire_ebr(benchmark::State& state)
+{
+    retire<t_ut::ebr_domain>(state);
+}
+BENCHMARK(bm_retire_ebr);
+
+void bm_retire_hazard_pointer(benchmark::State& state)
+{
+    retire<t_ut::hazard_domain>(state);
+}
+BENCHMARK(bm_retire_hazard_pointer);
+
+} // namespace
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+#include <t_ut/result.hpp>
+
+namespace
+{
+
+enum class parse_error : uint8_t
+{
+    empty,
+    too_large
+};
+
+/// Packets with a length field, every 16th one is broken
+/// The parsers are not inlined, like a real parser would not be, so the compiler cannot fold them into the loop
+std::vector<uint32_t> make_packets()
+{
+    std::vector<uint32_t> packets(4096);
+    for(size_t i = 0; i < packets.size(); ++i)
+        packets[i] = i % 16 == 0 ? 0 : static_cast<uint32_t>(i % 1500 + 1);
+    return packets;
+}
+
+[[gnu::noinline]] t_ut::result<uint32_t, parse_error> parse_length(uint32_t packet)
+{
+    if(packet == 0)
+        return parse_error::empty;
+    if(packet > 1500)
+        return parse_error::too_large;
+    return packet;
+}
+
+[[gnu::noinline]] uint32_t parse_length_or_throw(uint32_t packet)
+{
+    if(packet == 0)
+        throw std::invalid_argument{""};
+    if(packet > 1500)
+        throw std::out_of_range{""};
+    return packet;
+}
+
+/// The previous result, a variant matched through std::function
+[[gnu::noinline]] std::variant<uint32_t, parse_error> parse_length_variant(uint32_t packet)
+{
+    if(packet == 0)
+        return parse_error::empty;
+    if(packet > 1500)
+        return parse_error::too_large;
+    return packet;
+}
+
+template <typename RET>
+RET match_std_function(const std::variant<uint32_t, parse_error>& value, const std::function<RET(const uint32_t&)>& ok_cb,
+    const std::function<RET(const parse_error&)>& err_cb)
+{
+    if(std::holds_alternative<uint32_t>(value))
+        return ok_cb(std::get<uint32_t>(value));
+    return err_cb(std::get<parse_error>(value));
+}
+
+template <typename FUNC>
+void run_packets(benchmark::State& state, FUNC&& func)
+{
+    const auto packets = make_packets();
+    for(auto _ : state)
+    {
+        uint64_t total = 0;
+        for(uint32_t packet : packets)
+            total += func(packet);
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(packets.size()));
+}
+
+void bm_result_match(benchmark::State& state)
+{
+    run_packets(state, [](uint32_t packet)
+    {
+        return parse_length(packet).match([](uint32_t length) { return length; }, [](parse_error) { return 0u; });
+    });
+}
+BENCHMARK(bm_result_match);
+
+void bm_result_map_value_or(benchmark::State& state)
+{
+    run_packets(state, [](uint32_t packet)
+    {
+        return parse_length(packet).map([](uint32_t length) { return length * 2; }).value_or(0u);
+    });
+}
+BENCHMARK(bm_result_map_value_or);
+
+void bm_variant_match_std_function(benchmark::State& state)
+{
+    run_packets(state, [](uint32_t packet)
+    {
+        return match_std_function<uint32_t>(parse_length_variant(packet), [](const uint32_t& length) { return length; },
+            [](const parse_error&) { return 0u; });
+    });
+}
+BENCHMARK(bm_variant_match_std_function);
+
+void bm_exception(benchmark::State& state)
+{
+    run_packets(state, [](uint32_t packet)
+    {
+        try
+        {
+            return parse_length_or_throw(packet);
+        }
+        catch(const std::exception&)
+        {
+            return 0u;
+        }
+    });
+}
+BENCHMARK(bm_exception);
+
+} // namespace
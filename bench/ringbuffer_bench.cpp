@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <queue>
+
+#include <t_ut/ringbuffer.hpp>
+
+namespace
+{
+
+constexpr size_t buffer_size = 1024;
+
+void bm_ringbuffer_push_pop(benchmark::State& state)
+{
+    const size_t batch = static_cast<size_t>(state.range(0));
+    t_ut::ringbuffer<int, buffer_size> buffer;
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < batch; ++i)
+            buffer.push(static_cast<int>(i));
+        for(size_t i = 0; i < batch; ++i)
+            benchmark::DoNotOptimize(buffer.pop_unchecked());
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bm_ringbuffer_push_pop)->Arg(16)->Arg(256)->Arg(buffer_size - 1);
+
+void bm_std_queue_push_pop(benchmark::State& state)
+{
+    const size_t batch = static_cast<size_t>(state.range(0));
+    std::queue<int, std::deque<int>> queue;
+
+    for(auto _ : state)
+    {
+        for(size_t i = 0; i < batch; ++i)
+            queue.push(static_cast<int>(i));
+        for(size_t i = 0; i < batch; ++i)
+        {
+            benchmark::DoNotOptimize(queue.front());
+            queue.pop();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bm_std_queue_push_pop)->Arg(16)->Arg(256)->Arg(buffer_size - 1);
+
+void bm_ringbuffer_push_or_override(benchmark::State& state)
+{
+    t_ut::ringbuffer<int, 64> buffer;
+    int value = 0;
+
+    for(auto _ : state)
+    {
+        buffer.push_or_override(value++);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_ringbuffer_push_or_override);
+
+} // namespace
@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <vector>
+
+#include <t_ut/small_vector.hpp>
+#include <t_ut/static_vector.hpp>
+
+namespace
+{
+
+constexpr size_t inline_capacity = 16;
+
+/// Builds a vector of the given size, sums it up and destroys it again
+template <typename VECTOR>
+void push_iterate_destroy(benchmark::State& state)
+{
+    const auto count = static_cast<size_t>(state.range(0));
+    for(auto _ : state)
+    {
+        VECTOR vec;
+        for(size_t i = 0; i < count; ++i)
+            vec.push_back(static_cast<int>(i));
+        benchmark::DoNotOptimize(std::accumulate(vec.begin(), vec.end(), 0));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+void bm_small_vector_push_iterate_destroy(benchmark::State& state)
+{
+    push_iterate_destroy<t_ut::small_vector<int, inline_capacity>>(state);
+}
+BENCHMARK(bm_small_vector_push_iterate_destroy)->Arg(4)->Arg(inline_capacity)->Arg(4 * inline_capacity);
+
+void bm_static_vector_push_iterate_destroy(benchmark::State& state)
+{
+    push_iterate_destroy<t_ut::static_vector<int, 4 * inline_capacity>>(state);
+}
+BENCHMARK(bm_static_vector_push_iterate_destroy)->Arg(4)->Arg(inline_capacity)->Arg(4 * inline_capacity);
+
+void bm_std_vector_push_iterate_destroy(benchmark::State& state)
+{
+    push_iterate_destroy<std::vector<int>>(state);
+}
+BENCHMARK(bm_std_vector_push_iterate_destroy)->Arg(4)->Arg(inline_capacity)->Arg(4 * inline_capacity);
+
+} // namespace
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+
+#include <t_ut/soa_vector.hpp>
+#include <t_ut/static_vector.hpp>
+
+namespace
+{
+
+constexpr size_t record_count = 1024;
+
+struct record
+{
+    double price;
+    int32_t quantity;
+    int64_t id;
+    char comment[40];
+};
+
+enum
+{
+    price,
+    quantity,
+    id,
+    comment
+};
+
+using comment_type = std::array<char, 40>;
+
+/// Scans one field of an array of structs, every cache line also brings in the unused fields
+void bm_static_vector_scan_field(benchmark::State& state)
+{
+    auto records = std::make_unique<t_ut::static_vector<record, record_count>>();
+    for(size_t i = 0; i < record_count; ++i)
+        records->push_back(record{static_cast<double>(i), static_cast<int32_t>(i), static_cast<int64_t>(i), {}});
+
+    for(auto _ : state)
+    {
+        int64_t sum = 0;
+        for(const record& rec : *records)
+            sum += rec.quantity;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * record_count);
+}
+BENCHMARK(bm_static_vector_scan_field);
+
+void bm_static_soa_vector_scan_field(benchmark::State& state)
+{
+    auto records =
+        std::make_unique<t_ut::static_soa_vector<record_count, double, int32_t, int64_t, comment_type>>();
+    for(size_t i = 0; i < record_count; ++i)
+        records->emplace_back(static_cast<double>(i), static_cast<int32_t>(i), static_cast<int64_t>(i), comment_type{});
+
+    for(auto _ : state)
+    {
+        const auto quantities = records->field<quantity>();
+        benchmark::DoNotOptimize(std::accumulate(quantities.begin(), quantities.end(), int64_t{0}));
+    }
+    state.SetItemsProcessed(state.iterations() * record_count);
+}
+BENCHMARK(bm_static_soa_vector_scan_field);
+
+void bm_soa_vector_scan_two_fields(benchmark::State& state)
+{
+    t_ut::soa_vector<double, int32_t, int64_t, comment_type> records;
+    for(size_t i = 0; i < record_count; ++i)
+        records.emplace_back(static_cast<double>(i), static_cast<int32_t>(i), static_cast<int64_t>(i), comment_type{});
+
+    for(auto _ : state)
+    {
+        const auto prices = records.field<price>();
+        const auto quantities = records.field<quantity>();
+        double notional = 0;
+        for(size_t i = 0; i < prices.size(); ++i)
+            notional += prices[i] * quantities[i];
+        benchmark::DoNotOptimize(notional);
+    }
+    state.SetItemsProcessed(state.iterations() * record_count);
+}
+BENCHMARK(bm_soa_vector_scan_two_fields);
+
+} // namespace
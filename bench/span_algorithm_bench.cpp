@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#include <t_ut/span_algorithm.hpp>
+
+namespace
+{
+
+constexpr int64_t min_bytes = 64;
+constexpr int64_t max_bytes = 64 << 20;
+
+/// Second argument of every benchmark is the simd_level, results are reported in bytes per second
+const std::vector<int64_t> levels = {static_cast<int64_t>(t_ut::simd_level::scalar),
+    static_cast<int64_t>(t_ut::simd_level::sse2), static_cast<int64_t>(t_ut::simd_level::avx2),
+    static_cast<int64_t>(t_ut::simd_level::avx512)};
+
+/// Shared buffers for all benchmarks, bytes never contain 0xFF so find has to scan everything
+const std::vector<uint8_t>& bytes()
+{
+    static const std::vector<uint8_t> buffer = [] {
+        std::vector<uint8_t> result(max_bytes);
+        for(size_t i = 0; i < result.size(); ++i)
+            result[i] = static_cast<uint8_t>(i % 251);
+        return result;
+    }();
+    return buffer;
+}
+
+const std::vector<float>& floats()
+{
+    static const std::vector<float> buffer = [] {
+        std::vector<float> result(max_bytes / sizeof(float));
+        for(size_t i = 0; i < result.size(); ++i)
+            result[i] = static_cast<float>(i % 1000) * 0.5f;
+        return result;
+    }();
+    return buffer;
+}
+
+t_ut::span<const uint8_t> byte_span(const benchmark::State& state)
+{
+    return {bytes().data(), static_cast<size_t>(state.range(0))};
+}
+
+t_ut::span<const float> float_span(const benchmark::State& state)
+{
+    return {floats().data(), static_cast<size_t>(state.range(0)) / sizeof(float)};
+}
+
+t_ut::simd_level level(benchmark::State& state)
+{
+    const auto requested = static_cast<t_ut::simd_level>(state.range(1));
+    if(requested > t_ut::supported_simd_level())
+        state.SkipWithError("instruction set not supported");
+    return requested;
+}
+
+void bm_find_bytes(benchmark::State& state)
+{
+    const auto data = byte_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::find(data, uint8_t{0xFF}, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_find_bytes)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+/// Reference for find on bytes
+void bm_memchr(benchmark::State& state)
+{
+    const auto data = byte_span(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(std::memchr(data.data(), 0xFF, data.size()));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_memchr)->RangeMultiplier(8)->Range(min_bytes, max_bytes);
+
+void bm_count_bytes(benchmark::State& state)
+{
+    const auto data = byte_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::count(data, uint8_t{7}, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_count_bytes)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+void bm_minmax_bytes(benchmark::State& state)
+{
+    const auto data = byte_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::minmax(data, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_minmax_bytes)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+void bm_equal_bytes(benchmark::State& state)
+{
+    const auto data = byte_span(state);
+    const std::vector<uint8_t> copy(data.begin(), data.end());
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::equal(data, copy, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_equal_bytes)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+void bm_find_floats(benchmark::State& state)
+{
+    const auto data = float_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::find(data, -1.0f, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_find_floats)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+void bm_minmax_floats(benchmark::State& state)
+{
+    const auto data = float_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::minmax(data, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_minmax_floats)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+void bm_sum_floats(benchmark::State& state)
+{
+    const auto data = float_span(state);
+    const auto simd = level(state);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(t_ut::sum(data, simd));
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_sum_floats)->ArgsProduct({benchmark::CreateRange(min_bytes, max_bytes, 8), levels});
+
+} // namespace
@@ -0,0 +1,132 @@
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <vector>
+
+#include <t_ut/static_vector.hpp>
+
+namespace
+{
+
+constexpr size_t capacity = 256;
+
+template <typename VECTOR>
+void fill(VECTOR& vec, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+        vec.push_back(static_cast<int>(i));
+}
+
+void bm_static_vector_push_back(benchmark::State& state)
+{
+    const size_t count = static_cast<size_t>(state.range(0));
+    for(auto _ : state)
+    {
+        t_ut::static_vector<int, capacity> vec;
+        fill(vec, count);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(bm_static_vector_push_back)->Arg(8)->Arg(64)->Arg(capacity);
+
+void bm_std_vector_push_back(benchmark::State& state)
+{
+    const size_t count = static_cast<size_t>(state.range(0));
+    for(auto _ : state)
+    {
+        std::vector<int> vec;
+        vec.reserve(capacity);
+        fill(vec, count);
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(bm_std_vector_push_back)->Arg(8)->Arg(64)->Arg(capacity);
+
+void bm_static_vector_iterate(benchmark::State& state)
+{
+    t_ut::static_vector<int, capacity> vec;
+    fill(vec, capacity);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(std::accumulate(vec.begin(), vec.end(), 0));
+    state.SetItemsProcessed(state.iterations() * capacity);
+}
+BENCHMARK(bm_static_vector_iterate);
+
+void bm_std_vector_iterate(benchmark::State& state)
+{
+    std::vector<int> vec;
+    fill(vec, capacity);
+    for(auto _ : state)
+        benchmark::DoNotOptimize(std::accumulate(vec.begin(), vec.end(), 0));
+    state.SetItemsProcessed(state.iterations() * capacity);
+}
+BENCHMARK(bm_std_vector_iterate);
+
+void bm_static_vector_insert_erase_front(benchmark::State& state)
+{
+    t_ut::static_vector<int, capacity> vec;
+    fill(vec, capacity / 2);
+    for(auto _ : state)
+    {
+        vec.insert(vec.begin(), 42);
+        vec.erase(vec.begin());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(bm_static_vector_insert_erase_front);
+
+void bm_std_vector_insert_erase_front(benchmark::State& state)
+{
+    std::vector<int> vec;
+    fill(vec, capacity / 2);
+    for(auto _ : state)
+    {
+        vec.insert(vec.begin(), 42);
+        vec.erase(vec.begin());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(bm_std_vector_insert_erase_front);
+
+/// Small fixed capacity vectors are copied around a lot, trivially copyable ones copy like a plain struct
+void bm_static_vector_copy(benchmark::State& state)
+{
+    t_ut::static_vector<int, 16> vec;
+    fill(vec, 12);
+    for(auto _ : state)
+    {
+        t_ut::static_vector<int, 16> copy = vec;
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_static_vector_copy);
+
+void bm_std_vector_copy(benchmark::State& state)
+{
+    std::vector<int> vec;
+    fill(vec, 12);
+    for(auto _ : state)
+    {
+        std::vector<int> copy = vec;
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(bm_std_vector_copy);
+
+void bm_static_vector_range_construct(benchmark::State& state)
+{
+    std::vector<int> source(capacity);
+    for(auto _ : state)
+    {
+        t_ut::static_vector<int, capacity> vec(source.begin(), source.end());
+        benchmark::DoNotOptimize(vec.data());
+    }
+    state.SetItemsProcessed(state.iterations() * capacity);
+}
+BENCHMARK(bm_static_vector_range_construct);
+
+} // namespace
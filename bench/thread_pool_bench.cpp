@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include <t_ut/thread_pool.hpp>
+
+namespace
+{
+
+constexpr size_t batch = 1024;
+
+/// Enqueues a batch of trivial jobs and waits until all of them ran
+void bm_thread_pool_enqueue(benchmark::State& state)
+{
+    t_ut::thread_pool pool{static_cast<size_t>(state.range(0))};
+    std::atomic<size_t> done = 0;
+
+    for(auto _ : state)
+    {
+        done.store(0, std::memory_order_relaxed);
+        for(size_t i = 0; i < batch; ++i)
+            pool.add_job([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+
+        while(done.load(std::memory_order_relaxed) != batch)
+            std::this_thread::yield();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bm_thread_pool_enqueue)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+/// Same as above but with a capture that does not fit into std::function's small buffer
+void bm_thread_pool_enqueue_large_capture(benchmark::State& state)
+{
+    t_ut::thread_pool pool{static_cast<size_t>(state.range(0))};
+    std::atomic<size_t> done = 0;
+    const std::array<size_t, 4> payload{1, 2, 3, 4};
+
+    for(auto _ : state)
+    {
+        done.store(0, std::memory_order_relaxed);
+        for(size_t i = 0; i < batch; ++i)
+            pool.add_job([&done, payload]() { done.fetch_add(payload[0], std::memory_order_relaxed); });
+
+        while(done.load(std::memory_order_relaxed) != batch)
+            std::this_thread::yield();
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(bm_thread_pool_enqueue_large_capture)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+} // namespace
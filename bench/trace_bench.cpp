@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include <t_ut/trace.hpp>
+
+namespace
+{
+
+void bm_trace_span_disabled(benchmark::State& state)
+{
+    t_ut::tracer::stop();
+    for(auto _ : state)
+    {
+        const t_ut::trace_span span{"disabled"};
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(bm_trace_span_disabled);
+
+/// The buffers are collected outside of the timing before they overflow, so every span is recorded
+template <typename RECORD>
+void recorded(benchmark::State& state, RECORD record)
+{
+    t_ut::tracer::start();
+    uint64_t events = 0;
+    for(auto _ : state)
+    {
+        record();
+        if(++events % 4096 == 0)
+        {
+            state.PauseTiming();
+            benchmark::DoNotOptimize(t_ut::tracer::collect_json());
+            state.ResumeTiming();
+        }
+    }
+    t_ut::tracer::stop();
+    benchmark::DoNotOptimize(t_ut::tracer::collect_json());
+}
+
+void bm_trace_span_enabled(benchmark::State& state)
+{
+    recorded(state, []() {
+        const t_ut::trace_span span{"enabled"};
+        benchmark::ClobberMemory();
+    });
+}
+BENCHMARK(bm_trace_span_enabled);
+
+void bm_trace_flow(benchmark::State& state)
+{
+    recorded(state, []() { t_ut::trace_flow::begin("flow").end(); });
+}
+BENCHMARK(bm_trace_flow);
+
+} // namespace
@@ -0,0 +1,67 @@
+# Compares functions of an object file disassembled with objdump:
+#     cmake -DOBJDUMP=<objdump> -DOBJECT=<object file> -DPAIRS=<reference>:<candidate>,... -DMAX_EXTRA=<count>
+#         -P compare_functions.cmake
+# Fails if a candidate calls or references a symbol its reference does not, or has more than MAX_EXTRA instructions
+#     more than it. Cold parts split off by the compiler, e.g. the unwinding of exceptions, are not counted
+
+execute_process(COMMAND ${OBJDUMP} -d -r --no-show-raw-insn ${OBJECT}
+    OUTPUT_VARIABLE dump
+    RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${OBJDUMP} failed on ${OBJECT}")
+endif()
+
+string(REPLACE ";" "\;" dump "${dump}")
+string(REPLACE "\n" ";" lines "${dump}")
+
+set(function "")
+foreach(line IN LISTS lines)
+    if(line MATCHES "^[0-9a-f]+ <([A-Za-z0-9_]+)>:$")
+        set(function ${CMAKE_MATCH_1})
+        set(count_${function} 0)
+        set(symbols_${function} "")
+        set(listing_${function} "")
+    elseif(line MATCHES "^[0-9a-f]+ <")
+        set(function "")
+    elseif(function AND line MATCHES "R_[A-Z0-9_]+[ \t]+([^.][^+ \t-]*)")
+        list(APPEND symbols_${function} ${CMAKE_MATCH_1})
+        string(APPEND listing_${function} "${line}\n")
+    elseif(function AND line MATCHES "^ *[0-9a-f]+:\t(.*)$")
+        if(NOT CMAKE_MATCH_1 MATCHES "nop|^xchg +%ax,%ax")
+            math(EXPR count_${function} "${count_${function}} + 1")
+        endif()
+        string(APPEND listing_${function} "${line}\n")
+    endif()
+endforeach()
+
+set(failed FALSE)
+string(REPLACE "," ";" pairs "${PAIRS}")
+foreach(pair IN LISTS pairs)
+    string(REPLACE ":" ";" pair "${pair}")
+    list(GET pair 0 reference)
+    list(GET pair 1 candidate)
+    if(NOT DEFINED count_${reference} OR NOT DEFINED count_${candidate})
+        message(SEND_ERROR "${reference} or ${candidate} is missing in ${OBJECT}")
+        set(failed TRUE)
+        continue()
+    endif()
+
+    set(extra_symbols ${symbols_${candidate}})
+    if(symbols_${reference})
+        list(REMOVE_ITEM extra_symbols ${symbols_${reference}})
+    endif()
+    math(EXPR extra "${count_${candidate}} - ${count_${reference}}")
+
+    message(STATUS "${candidate}: ${count_${candidate}} instructions, ${reference}: ${count_${reference}}")
+    if(extra_symbols OR extra GREATER MAX_EXTRA)
+        list(REMOVE_DUPLICATES extra_symbols)
+        message(SEND_ERROR "${candidate} has ${extra} more instructions than ${reference} (at most ${MAX_EXTRA}) "
+            "and references [${extra_symbols}] in addition\n"
+            "${reference}:\n${listing_${reference}}\n${candidate}:\n${listing_${candidate}}")
+        set(failed TRUE)
+    endif()
+endforeach()
+
+if(failed)
+    message(FATAL_ERROR "generated code differs more than allowed")
+endif()
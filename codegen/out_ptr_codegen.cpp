@@ -0,0 +1,74 @@
+#include <memory>
+
+#include <t_ut/in_out_ptr.hpp>
+#include <t_ut/out_ptr.hpp>
+
+// Every wrapped_* function does the same as the raw_* function before it, which puts the pointer into the smart
+//     pointer by hand. compare_functions.cmake checks that the wrapped ones call nothing else and are about as long.
+// The C API is only declared, the object file is disassembled and never linked.
+
+struct handle;
+
+extern "C" int handle_create(handle** out, int value);
+extern "C" int handle_create_void(void** out, int value);
+extern "C" int handle_replace(handle** in_out);
+extern "C" void handle_free(handle* h);
+
+namespace
+{
+
+struct handle_deleter
+{
+    void operator()(handle* h) const noexcept
+    {
+        handle_free(h);
+    }
+};
+
+using unique_handle = std::unique_ptr<handle, handle_deleter>;
+
+} // namespace
+
+extern "C" int raw_out(unique_handle& h, int value)
+{
+    h.reset();
+    handle* raw = nullptr;
+    const int result = handle_create(&raw, value);
+    if(raw)
+        h.reset(raw);
+    return result;
+}
+
+extern "C" int wrapped_out(unique_handle& h, int value)
+{
+    return handle_create(t_ut::out_ptr{h}, value);
+}
+
+extern "C" int raw_out_void(unique_handle& h, int value)
+{
+    h.reset();
+    void* raw = nullptr;
+    const int result = handle_create_void(&raw, value);
+    if(raw)
+        h.reset(static_cast<handle*>(raw));
+    return result;
+}
+
+extern "C" int wrapped_out_void(unique_handle& h, int value)
+{
+    return handle_create_void(t_ut::out_ptr<unique_handle, void*>{h}, value);
+}
+
+extern "C" int raw_in_out(unique_handle& h)
+{
+    handle* raw = h.release();
+    const int result = handle_replace(&raw);
+    if(raw)
+        h.reset(raw);
+    return result;
+}
+
+extern "C" int wrapped_in_out(unique_handle& h)
+{
+    return handle_replace(t_ut::in_out_ptr{h});
+}
@@ -0,0 +1,153 @@
+#ifndef CPP_UTILITY_ARENA_RESOURCE_HPP
+#define CPP_UTILITY_ARENA_RESOURCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace t_ut {
+
+/// Monotonic memory resource that bumps a pointer through chunks taken from an upstream resource
+/// deallocate() does nothing, reset() frees everything at once but keeps the chunks, so an arena that is reset after
+///     every request stops touching the upstream resource once it has grown to the size of a request
+/// An optional initial buffer, e.g. on the stack, is used before any chunk is allocated
+/// Not thread safe, use one arena per request or per thread, or only allocate from it under a lock
+class arena_resource final : public std::pmr::memory_resource
+{
+public:
+    explicit arena_resource(size_t initial_size = 4096,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+        : m_upstream{upstream}
+        , m_next_size{std::max(initial_size, min_chunk_size)}
+    {}
+
+    arena_resource(void* buffer, size_t size,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept
+        : m_upstream{upstream}
+        , m_buffer{static_cast<std::byte*>(buffer)}
+        , m_buffer_size{size}
+        , m_next_size{std::max(size * 2, min_chunk_size)}
+    {
+        reset();
+    }
+
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+
+    ~arena_resource() override
+    {
+        release();
+    }
+
+    /// Frees all allocations at once, the chunks are kept and handed out again from the start
+    void reset() noexcept
+    {
+        m_ptr = m_buffer;
+        m_end = m_buffer + m_buffer_size;
+        m_next = m_chunks;
+    }
+
+    /// Frees all allocations and returns the chunks to the upstream resource
+    void release() noexcept
+    {
+        while(m_chunks)
+        {
+            chunk* next = m_chunks->next;
+            m_upstream->deallocate(m_chunks, m_chunks->size, alignof(chunk));
+            m_chunks = next;
+        }
+        m_last = nullptr;
+        reset();
+    }
+
+    std::pmr::memory_resource* upstream_resource() const noexcept
+    {
+        return m_upstream;
+    }
+
+private:
+    /// Header at the start of every chunk, the chunks form a list in the order they were allocated
+    struct chunk
+    {
+        chunk* next;
+        size_t size;
+    };
+
+    static constexpr size_t min_chunk_size = 256;
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if(void* result = bump(bytes, alignment))
+            return result;
+        return allocate_slow(bytes, alignment);
+    }
+
+    void do_deallocate(void*, size_t, size_t) override
+    {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void* bump(size_t bytes, size_t alignment) noexcept
+    {
+        const auto address = reinterpret_cast<uintptr_t>(m_ptr);
+        const size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+        if(bytes + padding > static_cast<size_t>(m_end - m_ptr))
+            return nullptr;
+        std::byte* result = m_ptr + padding;
+        m_ptr = result + bytes;
+        return result;
+    }
+
+    /// Moves on to the next chunk that is kept from before a reset() or allocates a new one
+    void* allocate_slow(size_t bytes, size_t alignment)
+    {
+        while(m_next)
+        {
+            use(m_next);
+            m_next = m_next->next;
+            if(void* result = bump(bytes, alignment))
+                return result;
+        }
+
+        const size_t size = std::max(m_next_size, sizeof(chunk) + bytes + alignment);
+        auto* new_chunk = static_cast<chunk*>(m_upstream->allocate(size, alignof(chunk)));
+        *new_chunk = {nullptr, size};
+        if(m_last)
+            m_last->next = new_chunk;
+        else
+            m_chunks = new_chunk;
+        m_last = new_chunk;
+        m_next_size = size * 2;
+
+        use(new_chunk);
+        return bump(bytes, alignment);
+    }
+
+    void use(chunk* c) noexcept
+    {
+        m_ptr = reinterpret_cast<std::byte*>(c + 1);
+        m_end = reinterpret_cast<std::byte*>(c) + c->size;
+    }
+
+    std::pmr::memory_resource* m_upstream;
+
+    std::byte* m_buffer = nullptr;
+    size_t m_buffer_size = 0;
+
+    std::byte* m_ptr = nullptr;
+    std::byte* m_end = nullptr;
+
+    chunk* m_chunks = nullptr;
+    chunk* m_last = nullptr;
+    /// Chunk to continue with when the current one is used up, null if a new one has to be allocated
+    chunk* m_next = nullptr;
+    size_t m_next_size;
+};
+
+} // namespace t_ut
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef CPP_UTILITY_ASYMMETRIC_FENCE_HPP
+#define CPP_UTILITY_ASYMMETRIC_FENCE_HPP
+
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace t_ut {
+
+namespace internal {
+
+/// Pair of fences that together order a store before a later load of another thread, like two seq_cst fences would
+/// Where the kernel can fence all threads of the process on request, the light side is a compiler barrier and the
+///     heavy side a system call, so guards stay cheap and only the rare reclamation pays
+struct asymmetric_fence
+{
+    static void light() noexcept
+    {
+        if(process_wide())
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    static void heavy() noexcept
+    {
+#if defined(__linux__)
+        if(process_wide())
+        {
+            syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+            return;
+        }
+#endif
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+private:
+    static bool process_wide() noexcept
+    {
+#if defined(__linux__)
+        static const bool registered = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+        return registered;
+#else
+        return false;
+#endif
+    }
+};
+
+} // namespace internal
+
+} // namespace t_ut
+
+#endif
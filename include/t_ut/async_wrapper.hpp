@@ -1,50 +1,539 @@
 #ifndef CPP_UTILITY_ASYNC_WRAPPER_HPP
 #define CPP_UTILITY_ASYNC_WRAPPER_HPP
 
-#include <future>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <optional>
-#include <chrono>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "move_only_function.hpp"
+#include "thread_pool.hpp"
 
 namespace t_ut
 {
 
+template <typename RETURN, typename ... PARAMS>
+class async_wrapper;
+
+namespace internal
+{
+
+/// Value or exception a completed async_state hands to its continuation
+template <typename T>
+struct async_result
+{
+    /// Moves the value out or rethrows the stored exception
+    T take()
+    {
+        if(error)
+            std::rethrow_exception(std::exchange(error, nullptr));
+        T result = std::move(*value);
+        value.reset();
+        return result;
+    }
+
+    std::optional<T> value;
+    std::exception_ptr error;
+};
+
+/// Shared state between an async_wrapper and whoever produces its value
+/// The continuation is run exactly once by the thread that completes the state, or inline if it is already completed
+/// The state may live in a resource that is destroyed as soon as the value was taken, so the producer drops its
+///     reference before the state becomes ready and nothing of a completed state is touched afterwards
+template <typename T>
+class async_state
+{
+public:
+    using continuation_type = move_only_function<void(async_result<T>&&)>;
+
+    explicit async_state(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept
+        : m_resource{resource}
+    {}
+
+    /// Resource the state was allocated from, the states of continuations are allocated from it as well
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return m_resource;
+    }
+
+    /// Completes state and resets it, it is left untouched if moving the value throws
+    static void set_value(std::shared_ptr<async_state>& state, T&& value)
+    {
+        complete(state, [&](async_result<T>& result) { result.value.emplace(std::move(value)); });
+    }
+
+    static void set_exception(std::shared_ptr<async_state>& state, std::exception_ptr error)
+    {
+        complete(state, [&](async_result<T>& result) { result.error = std::move(error); });
+    }
+
+    bool ready() const
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        return m_ready;
+    }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_cv.wait(lock, [this]() { return m_ready; });
+    }
+
+    std::optional<T> try_take()
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if(!m_ready)
+            return std::nullopt;
+        if(m_result.error)
+            std::rethrow_exception(std::exchange(m_result.error, nullptr));
+        return std::exchange(m_result.value, std::nullopt);
+    }
+
+    /// Only called once the wrapper of the state was released, as the continuation takes the result
+    void on_ready(continuation_type continuation)
+    {
+        async_result<T> result;
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if(!m_ready)
+            {
+                m_continuation = std::move(continuation);
+                return;
+            }
+            result = std::move(m_result);
+        }
+        continuation(std::move(result));
+    }
+
+private:
+    template <typename SETTER>
+    static void complete(std::shared_ptr<async_state>& state, SETTER&& setter)
+    {
+        async_state& self = *state;
+        continuation_type continuation;
+        {
+            std::lock_guard<std::mutex> lock{self.m_mutex};
+            setter(self.m_result);
+            self.m_ready = true;
+            if(!self.m_continuation)
+            {
+                self.m_cv.notify_all();
+                // Whoever waits for the state holds a reference too and drops it only after taking the lock, so this
+                //     one is not the last and the unlock is the last touch
+                state.reset();
+                return;
+            }
+            continuation = std::move(self.m_continuation);
+        }
+
+        // Nobody can reach a state with a continuation anymore, so it is freed before the continuation completes the
+        //     next state and a resource the next state lives in may go away
+        async_result<T> result = std::move(self.m_result);
+        state.reset();
+        continuation(std::move(result));
+    }
+
+    std::pmr::memory_resource* m_resource;
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_cv;
+    bool m_ready = false;
+
+    async_result<T> m_result;
+    continuation_type m_continuation;
+};
+
+template <typename T>
+std::shared_ptr<async_state<T>> make_async_state(std::pmr::memory_resource* resource)
+{
+    return std::allocate_shared<async_state<T>>(std::pmr::polymorphic_allocator<async_state<T>>{resource}, resource);
+}
+
+/// Runs func and completes state with its result or the exception it threw, state is reset afterwards
+template <typename T, typename FUNC>
+void fulfill(std::shared_ptr<async_state<T>>& state, FUNC&& func)
+{
+    try
+    {
+        async_state<T>::set_value(state, std::invoke(std::forward<FUNC>(func)));
+    }
+    catch(...)
+    {
+        // Continuations do not throw, so the state was only completed if func or the move of its value threw
+        if(!state)
+            throw;
+        async_state<T>::set_exception(state, std::current_exception());
+    }
+}
+
+/// Gives the combinators access to the shared state of an async_wrapper
+struct async_access
+{
+    template <typename WRAPPER>
+    static auto release(WRAPPER& wrapper)
+    {
+        if(!wrapper.m_state)
+            throw std::invalid_argument{"async_wrapper has no state"};
+        return std::move(wrapper.m_state);
+    }
+
+    template <typename T>
+    static async_wrapper<T> make(std::shared_ptr<async_state<T>> state)
+    {
+        return async_wrapper<T>{std::move(state)};
+    }
+};
+
+} // namespace internal
+
+/// Runs a callback asynchronously on a thread_pool and hands out its result without blocking
+/// Results can be chained with then() and combined with when_all()/when_any(), the continuations run on the thread
+///     that produced the value so no polling or additional thread is needed
+/// Destroying a wrapper that still owns its state blocks until the value is produced, so a callback that waits for
+///     another wrapper of the same pool can starve it, the pool has to keep running until the callback ran
 template <typename RETURN, typename ... PARAMS>
 class async_wrapper
 {
+    static_assert(!std::is_void_v<RETURN>, "async_wrapper needs a non void return type");
+
 public:
     using return_type = RETURN;
 
-    async_wrapper(const std::function<return_type (PARAMS...)>& callback, PARAMS... params)
+    /// Runs the callback on thread_pool::shared()
+    async_wrapper(move_only_function<return_type (PARAMS...)> callback, PARAMS... params)
+        : async_wrapper{thread_pool::shared(), std::move(callback), std::move(params)...}
+    {}
+
+    async_wrapper(thread_pool& pool, move_only_function<return_type (PARAMS...)> callback, PARAMS... params)
+        : m_state{std::make_shared<state_type>()}
+    {
+        start(pool, std::move(callback), std::move(params)...);
+    }
+
+    /// Allocates the shared state, and those of continuations chained with then() and of combinators, from the
+    ///     resource of alloc
+    /// The resource has to be thread safe and outlive the wrappers, it may be destroyed as soon as the values were
+    ///     taken as the producing thread is done with it by then
+    async_wrapper(std::allocator_arg_t, std::pmr::polymorphic_allocator<> alloc,
+        move_only_function<return_type (PARAMS...)> callback, PARAMS... params)
+        : async_wrapper{std::allocator_arg, alloc, thread_pool::shared(), std::move(callback), std::move(params)...}
+    {}
+
+    async_wrapper(std::allocator_arg_t, std::pmr::polymorphic_allocator<> alloc, thread_pool& pool,
+        move_only_function<return_type (PARAMS...)> callback, PARAMS... params)
+        : m_state{internal::make_async_state<return_type>(alloc.resource())}
     {
-        m_fut = std::async(std::launch::async, callback, params...);
+        start(pool, std::move(callback), std::move(params)...);
     }
 
     async_wrapper(const async_wrapper&) = delete;
     async_wrapper& operator=(const async_wrapper&) = delete;
 
     async_wrapper(async_wrapper&&) noexcept = default;
-    async_wrapper& operator=(async_wrapper&&) noexcept = default;
+
+    async_wrapper& operator=(async_wrapper&& rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            if(m_state)
+                m_state->wait();
+            m_state = std::move(rhs.m_state);
+        }
+        return *this;
+    }
 
     ~async_wrapper()
     {
-        if(m_fut.valid())
-            m_fut.get();
+        if(m_state)
+            m_state->wait();
     }
 
-    std::optional<return_type> get()
+    /// False after the value was handed over to a continuation or combinator
+    bool valid() const
     {
-        using namespace std::chrono_literals;
+        return m_state != nullptr;
+    }
 
-        if(m_fut.valid() && m_fut.wait_for(0ms) == std::future_status::ready)
-            return m_fut.get();
-        else
+    bool ready() const
+    {
+        return m_state && m_state->ready();
+    }
+
+    void wait() const
+    {
+        if(m_state)
+            m_state->wait();
+    }
+
+    /// Returns the value if it is ready, rethrows if the callback threw
+    /// The value can only be taken once
+    std::optional<return_type> get()
+    {
+        if(!m_state)
             return std::nullopt;
+        return m_state->try_take();
+    }
+
+    /// Registers func to be called with the value as soon as it is ready and returns a wrapper for its result
+    /// Exceptions skip func and are forwarded to the returned wrapper, this wrapper is no longer valid afterwards
+    template <typename FUNC>
+    auto then(FUNC&& func) -> async_wrapper<std::invoke_result_t<FUNC, return_type>>
+    {
+        using next_type = std::invoke_result_t<FUNC, return_type>;
+
+        auto prev = internal::async_access::release(*this);
+        auto next = internal::make_async_state<next_type>(prev->resource());
+
+        prev->on_ready([next, func = std::forward<FUNC>(func)](internal::async_result<return_type>&& result) mutable {
+            internal::fulfill(next, [&]() { return std::invoke(func, result.take()); });
+        });
+
+        return internal::async_access::make(std::move(next));
     }
 
 private:
-    std::future<return_type> m_fut;
+    using state_type = internal::async_state<return_type>;
+
+    friend struct internal::async_access;
+
+    explicit async_wrapper(std::shared_ptr<state_type> state)
+        : m_state{std::move(state)}
+    {}
+
+    void start(thread_pool& pool, move_only_function<return_type (PARAMS...)> callback, PARAMS... params)
+    {
+        pool.add_job([state = m_state, callback = std::move(callback), params...]() mutable {
+            internal::fulfill(state, [&]() { return callback(std::move(params)...); });
+        });
+    }
+
+    std::shared_ptr<state_type> m_state;
+};
+
+namespace internal
+{
+
+/// State shared by the continuations of the inputs of when_all, it lives in the resource of the inputs
+/// remaining counts the inputs that did not arrive yet, the last one frees the join before it completes the combined
+///     state, as the resource may be destroyed as soon as the value was taken
+template <typename T>
+struct when_all_join
+{
+    when_all_join(std::pmr::memory_resource* resource, size_t count)
+        : state{make_async_state<T>(resource)}
+        , remaining{count}
+    {}
+
+    /// Called once per finished input after it stored its value, join must not be touched afterwards
+    template <typename JOIN, typename MAKE_RESULT>
+    static void arrive(JOIN* join, MAKE_RESULT&& make_result)
+    {
+        if(join->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+
+        auto done = std::move(join->state);
+        std::exception_ptr error = std::move(join->error);
+        std::optional<T> value;
+        if(!error)
+        {
+            try
+            {
+                value.emplace(make_result(*join));
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+        }
+        std::pmr::polymorphic_allocator<>{done->resource()}.delete_object(join);
+
+        if(value)
+            fulfill(done, [&]() { return std::move(*value); });
+        else
+            async_state<T>::set_exception(done, std::move(error));
+    }
+
+    void fail(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lock{error_mutex};
+        if(!error)
+            error = std::move(e);
+    }
+
+    std::shared_ptr<async_state<T>> state;
+    std::atomic<size_t> remaining;
+    std::mutex error_mutex;
+    std::exception_ptr error;
 };
 
+/// Combined state of a combinator without inputs, ready right away
+template <typename T>
+std::shared_ptr<async_state<T>> make_ready_state(T&& value)
+{
+    auto state = make_async_state<T>(std::pmr::get_default_resource());
+    auto result = state;
+    async_state<T>::set_value(state, std::move(value));
+    return result;
+}
+
+} // namespace internal
+
+/// Combines several wrappers into one that becomes ready when all of them are, the values are collected in a tuple
+/// If any input threw, the combined wrapper rethrows the first exception once all inputs are done
+/// The combined state lives in the resource of the first input, without inputs it is ready right away with an empty
+///     tuple
+template <typename ... WRAPPERS>
+auto when_all(WRAPPERS&& ... wrappers)
+    -> async_wrapper<std::tuple<typename std::decay_t<WRAPPERS>::return_type ...>>
+{
+    using result_type = std::tuple<typename std::decay_t<WRAPPERS>::return_type ...>;
+
+    // Without inputs nothing would ever arrive
+    if constexpr(sizeof...(WRAPPERS) == 0)
+    {
+        return internal::async_access::make(internal::make_ready_state(result_type{}));
+    }
+    else
+    {
+        struct join_type : internal::when_all_join<result_type>
+        {
+            using internal::when_all_join<result_type>::when_all_join;
+            std::tuple<std::optional<typename std::decay_t<WRAPPERS>::return_type> ...> values;
+        };
+
+        auto states = std::make_tuple(internal::async_access::release(wrappers) ...);
+        std::pmr::polymorphic_allocator<> alloc{std::get<0>(states)->resource()};
+        auto* join = alloc.new_object<join_type>(alloc.resource(), sizeof...(WRAPPERS));
+        auto result = join->state;
+
+        [&]<size_t ... Is>(std::index_sequence<Is ...>) {
+            (std::get<Is>(states)->on_ready([join](auto&& result) {
+                try
+                {
+                    std::get<Is>(join->values).emplace(result.take());
+                }
+                catch(...)
+                {
+                    join->fail(std::current_exception());
+                }
+                join_type::arrive(join, [](join_type& j) {
+                    return std::apply([](auto& ... values) { return result_type{std::move(*values) ...}; }, j.values);
+                });
+            }), ...);
+        }(std::index_sequence_for<WRAPPERS ...>{});
+
+        return internal::async_access::make(std::move(result));
+    }
+}
+
+/// Combines a range of wrappers of the same type into one that becomes ready when all of them are
+/// The combined state lives in the resource of the first wrapper
+template <typename RETURN, typename ... PARAMS>
+async_wrapper<std::vector<RETURN>> when_all(std::vector<async_wrapper<RETURN, PARAMS...>> wrappers)
+{
+    using result_type = std::vector<RETURN>;
+
+    struct join_type : internal::when_all_join<result_type>
+    {
+        join_type(std::pmr::memory_resource* resource, size_t count)
+            : internal::when_all_join<result_type>{resource, count}
+            , values{count, resource}
+        {}
+
+        std::pmr::vector<std::optional<RETURN>> values;
+    };
+
+    if(wrappers.empty())
+        return internal::async_access::make(internal::make_ready_state(result_type{}));
+
+    std::vector<std::shared_ptr<internal::async_state<RETURN>>> states;
+    states.reserve(wrappers.size());
+    for(auto& wrapper : wrappers)
+        states.push_back(internal::async_access::release(wrapper));
+
+    std::pmr::polymorphic_allocator<> alloc{states.front()->resource()};
+    auto* join = alloc.new_object<join_type>(alloc.resource(), states.size());
+    auto result = join->state;
+
+    for(size_t i = 0; i < states.size(); ++i)
+    {
+        states[i]->on_ready([join, i](internal::async_result<RETURN>&& result) {
+            try
+            {
+                join->values[i].emplace(result.take());
+            }
+            catch(...)
+            {
+                join->fail(std::current_exception());
+            }
+            join_type::arrive(join, [](join_type& j) {
+                result_type values;
+                values.reserve(j.values.size());
+                for(auto& value : j.values)
+                    values.push_back(std::move(*value));
+                return values;
+            });
+        });
+    }
+
+    return internal::async_access::make(std::move(result));
+}
+
+/// Returns a wrapper that becomes ready with the index and value of the first wrapper to finish
+/// If that wrapper threw, the exception is forwarded instead, the results of all other wrappers are discarded
+/// The combined state lives in the resource of the first wrapper, which has to outlive all of them as the others
+///     still complete their states after the first one finished
+template <typename RETURN, typename ... PARAMS>
+async_wrapper<std::pair<size_t, RETURN>> when_any(std::vector<async_wrapper<RETURN, PARAMS...>> wrappers)
+{
+    using result_type = std::pair<size_t, RETURN>;
+
+    if(wrappers.empty())
+        throw std::invalid_argument{"when_any needs at least one async_wrapper"};
+
+    struct join_type
+    {
+        explicit join_type(std::pmr::memory_resource* resource)
+            : state{internal::make_async_state<result_type>(resource)}
+        {}
+
+        std::shared_ptr<internal::async_state<result_type>> state;
+        std::atomic<bool> done = false;
+    };
+
+    std::vector<std::shared_ptr<internal::async_state<RETURN>>> states;
+    states.reserve(wrappers.size());
+    for(auto& wrapper : wrappers)
+        states.push_back(internal::async_access::release(wrapper));
+
+    std::pmr::memory_resource* resource = states.front()->resource();
+    auto join = std::allocate_shared<join_type>(std::pmr::polymorphic_allocator<join_type>{resource}, resource);
+    auto result = join->state;
+
+    for(size_t i = 0; i < states.size(); ++i)
+    {
+        states[i]->on_ready([join, i](internal::async_result<RETURN>&& result) mutable {
+            auto self = std::move(join);
+            if(self->done.exchange(true, std::memory_order_acq_rel))
+                return;
+            auto state = std::move(self->state);
+            self.reset();
+            internal::fulfill(state, [&]() { return result_type{i, result.take()}; });
+        });
+    }
+
+    return internal::async_access::make(std::move(result));
+}
+
 } // namespace t_ut
 
 #endif
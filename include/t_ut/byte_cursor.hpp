@@ -0,0 +1,301 @@
+#ifndef CPP_UTILITY_BYTE_CURSOR_HPP
+#define CPP_UTILITY_BYTE_CURSOR_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "span.hpp"
+
+namespace t_ut {
+
+static_assert(std::endian::native == std::endian::little || std::endian::native == std::endian::big,
+    "Mixed endian platforms are not supported");
+
+namespace internal {
+
+template <size_t SIZE>
+using unsigned_of_size = std::conditional_t<SIZE == 1, uint8_t,
+    std::conditional_t<SIZE == 2, uint16_t, std::conditional_t<SIZE == 4, uint32_t, uint64_t>>>;
+
+template <typename T>
+concept wire_value = (std::is_integral_v<T> || std::is_floating_point_v<T>)
+    && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+template <typename U>
+constexpr U byteswap(U value) noexcept
+{
+    if constexpr(sizeof(U) == 1)
+        return value;
+#if defined(__GNUC__) || defined(__clang__)
+    else if constexpr(sizeof(U) == 2)
+        return __builtin_bswap16(value);
+    else if constexpr(sizeof(U) == 4)
+        return __builtin_bswap32(value);
+    else
+        return __builtin_bswap64(value);
+#else
+    else
+    {
+        U result = 0;
+        for(size_t i = 0; i < sizeof(U); ++i, value >>= 8)
+            result = static_cast<U>((result << 8) | (value & 0xFF));
+        return result;
+    }
+#endif
+}
+
+} // namespace internal
+
+/// Reads a T stored with byte order ORDER from possibly unaligned memory
+template <internal::wire_value T, std::endian ORDER = std::endian::little>
+T load(const std::byte* source) noexcept
+{
+    using bits_type = internal::unsigned_of_size<sizeof(T)>;
+    bits_type bits;
+    std::memcpy(&bits, source, sizeof(T));
+    if constexpr(ORDER != std::endian::native)
+        bits = internal::byteswap(bits);
+    return std::bit_cast<T>(bits);
+}
+
+/// Writes value with byte order ORDER to possibly unaligned memory
+template <internal::wire_value T, std::endian ORDER = std::endian::little>
+void store(std::byte* destination, T value) noexcept
+{
+    using bits_type = internal::unsigned_of_size<sizeof(T)>;
+    auto bits = std::bit_cast<bits_type>(value);
+    if constexpr(ORDER != std::endian::native)
+        bits = internal::byteswap(bits);
+    std::memcpy(destination, &bits, sizeof(T));
+}
+
+/// Maximum number of bytes of a T encoded as LEB128 varint
+template <typename T>
+inline constexpr size_t max_varint_size = (sizeof(T) * 8 + 6) / 7;
+
+/// Number of bytes value needs as varint, signed values are zigzag encoded first
+template <std::integral T>
+constexpr size_t varint_size(T value) noexcept
+{
+    using unsigned_type = std::make_unsigned_t<T>;
+    auto bits = static_cast<unsigned_type>(value);
+    if constexpr(std::is_signed_v<T>)
+        bits = static_cast<unsigned_type>((bits << 1) ^ static_cast<unsigned_type>(value >> (sizeof(T) * 8 - 1)));
+
+    size_t size = 1;
+    for(; bits >= 0x80; bits >>= 7)
+        ++size;
+    return size;
+}
+
+/// Zero-copy cursor for parsing binary data in place
+/// read() and the other checked functions throw std::out_of_range if the buffer is too short and leave the cursor
+///     unchanged, the _unchecked variants require the caller to check remaining() beforehand
+/// Integers and floats are read with an explicit byte order, little endian by default
+class byte_reader
+{
+public:
+    constexpr byte_reader(span<const std::byte> buffer) noexcept
+        : m_buffer{buffer}
+    {}
+
+    constexpr size_t position() const { return m_position; }
+    constexpr size_t remaining() const { return m_buffer.size() - m_position; }
+    constexpr bool empty() const { return remaining() == 0; }
+
+    /// The whole buffer and the part that has not been read yet
+    constexpr span<const std::byte> buffer() const { return m_buffer; }
+    constexpr span<const std::byte> rest() const { return m_buffer.subspan(m_position); }
+
+    template <internal::wire_value T, std::endian ORDER = std::endian::little>
+    T read()
+    {
+        require(sizeof(T));
+        return read_unchecked<T, ORDER>();
+    }
+
+    template <internal::wire_value T, std::endian ORDER = std::endian::little>
+    T read_unchecked() noexcept
+    {
+        const T value = load<T, ORDER>(m_buffer.data() + m_position);
+        m_position += sizeof(T);
+        return value;
+    }
+
+    /// Reads the next value without advancing
+    template <internal::wire_value T, std::endian ORDER = std::endian::little>
+    T peek() const
+    {
+        require(sizeof(T));
+        return load<T, ORDER>(m_buffer.data() + m_position);
+    }
+
+    /// Returns the next count bytes without copying them
+    span<const std::byte> read_bytes(size_t count)
+    {
+        require(count);
+        return read_bytes_unchecked(count);
+    }
+
+    span<const std::byte> read_bytes_unchecked(size_t count) noexcept
+    {
+        const auto bytes = m_buffer.subspan(m_position, count);
+        m_position += count;
+        return bytes;
+    }
+
+    template <size_t COUNT>
+    span<const std::byte, COUNT> read_bytes()
+    {
+        require(COUNT);
+        const span<const std::byte, COUNT> bytes{m_buffer.data() + m_position, COUNT};
+        m_position += COUNT;
+        return bytes;
+    }
+
+    /// Reader over the next count bytes, e.g. a length prefixed message, this reader continues after them
+    byte_reader slice(size_t count)
+    {
+        return byte_reader{read_bytes(count)};
+    }
+
+    void skip(size_t count)
+    {
+        require(count);
+        m_position += count;
+    }
+
+    /// Reads a LEB128 varint as used by protobuf, signed types are zigzag decoded
+    /// Throws std::out_of_range if the buffer ends within the varint and std::overflow_error if it does not fit into T
+    template <std::integral T = uint64_t>
+    T read_varint()
+    {
+        using unsigned_type = std::make_unsigned_t<T>;
+        constexpr size_t max_size = max_varint_size<T>;
+
+        unsigned_type bits = 0;
+        size_t size = 0;
+        const std::byte* data = m_buffer.data() + m_position;
+        const size_t available = remaining() < max_size ? remaining() : max_size;
+        for(;; ++size)
+        {
+            if(size == available)
+            {
+                if(available == max_size)
+                    throw std::overflow_error{""};
+                throw std::out_of_range{""};
+            }
+
+            const auto byte = static_cast<unsigned_type>(data[size]);
+            const size_t shift = 7 * size;
+            const unsigned_type payload = byte & 0x7F;
+            // The last byte may only carry the bits that are left in T
+            if(shift + 7 > sizeof(T) * 8 && (payload >> (sizeof(T) * 8 - shift)) != 0)
+                throw std::overflow_error{""};
+
+            bits |= static_cast<unsigned_type>(payload << shift);
+            if((byte & 0x80) == 0)
+                break;
+        }
+        m_position += size + 1;
+
+        if constexpr(std::is_signed_v<T>)
+            return static_cast<T>((bits >> 1) ^ static_cast<unsigned_type>(-static_cast<unsigned_type>(bits & 1)));
+        else
+            return bits;
+    }
+
+private:
+    void require(size_t count) const
+    {
+        if(count > remaining())
+            throw std::out_of_range{""};
+    }
+
+    span<const std::byte> m_buffer;
+    size_t m_position = 0;
+};
+
+/// Cursor for serializing binary data into an existing buffer
+/// write() and the other checked functions throw std::out_of_range if the buffer is too short and leave it unchanged,
+///     the _unchecked variants require the caller to check remaining() beforehand
+class byte_writer
+{
+public:
+    constexpr byte_writer(span<std::byte> buffer) noexcept
+        : m_buffer{buffer}
+    {}
+
+    constexpr size_t position() const { return m_position; }
+    constexpr size_t remaining() const { return m_buffer.size() - m_position; }
+
+    /// The bytes written so far
+    constexpr span<std::byte> written() const { return m_buffer.first(m_position); }
+
+    template <internal::wire_value T, std::endian ORDER = std::endian::little>
+    void write(T value)
+    {
+        require(sizeof(T));
+        write_unchecked<T, ORDER>(value);
+    }
+
+    template <internal::wire_value T, std::endian ORDER = std::endian::little>
+    void write_unchecked(T value) noexcept
+    {
+        store<T, ORDER>(m_buffer.data() + m_position, value);
+        m_position += sizeof(T);
+    }
+
+    void write_bytes(span<const std::byte> bytes)
+    {
+        require(bytes.size());
+        if(!bytes.empty())
+            std::memcpy(m_buffer.data() + m_position, bytes.data(), bytes.size());
+        m_position += bytes.size();
+    }
+
+    /// Hands out the next count bytes to be filled in later, e.g. a length prefix
+    span<std::byte> claim(size_t count)
+    {
+        require(count);
+        const auto bytes = m_buffer.subspan(m_position, count);
+        m_position += count;
+        return bytes;
+    }
+
+    /// Writes value as LEB128 varint, signed types are zigzag encoded
+    template <std::integral T>
+    void write_varint(T value)
+    {
+        using unsigned_type = std::make_unsigned_t<T>;
+        auto bits = static_cast<unsigned_type>(value);
+        if constexpr(std::is_signed_v<T>)
+            bits = static_cast<unsigned_type>((bits << 1) ^ static_cast<unsigned_type>(value >> (sizeof(T) * 8 - 1)));
+
+        require(varint_size(value));
+        std::byte* data = m_buffer.data() + m_position;
+        for(; bits >= 0x80; bits >>= 7)
+            *data++ = static_cast<std::byte>((bits & 0x7F) | 0x80);
+        *data++ = static_cast<std::byte>(bits);
+        m_position = static_cast<size_t>(data - m_buffer.data());
+    }
+
+private:
+    void require(size_t count) const
+    {
+        if(count > remaining())
+            throw std::out_of_range{""};
+    }
+
+    span<std::byte> m_buffer;
+    size_t m_position = 0;
+};
+
+} // namespace t_ut
+
+#endif
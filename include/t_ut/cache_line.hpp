@@ -0,0 +1,17 @@
+#ifndef CPP_UTILITY_CACHE_LINE_HPP
+#define CPP_UTILITY_CACHE_LINE_HPP
+
+#include <cstddef>
+
+namespace t_ut {
+
+namespace internal {
+
+/// Assumed cache line size, used to keep data written by different threads apart and to align arrays
+inline constexpr size_t cache_line_size = 64;
+
+} // namespace internal
+
+} // namespace t_ut
+
+#endif
@@ -1,49 +1,127 @@
 #ifndef CPP_UTILITY_CHAN_HPP
 #define CPP_UTILITY_CHAN_HPP
 
+#include <chrono>
 #include <condition_variable>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <optional>
+#include <string_view>
 
+#include "metrics.hpp"
+#include "object_pool.hpp"
 #include "ringbuffer.hpp"
+#include "trace.hpp"
 
 namespace t_ut
 {
 
+/// Metrics a chan reports to, waits are in nanoseconds
+struct chan_metrics
+{
+    /// Metrics of the t_ut_chan_* families in registry, labels tell channels apart, e.g. chan="events"
+    static chan_metrics registered(metrics_registry& registry = metrics_registry::global(),
+        std::string_view labels = {})
+    {
+        return {
+            &registry.get_counter("t_ut_chan_sent_total", "Values sent", labels),
+            &registry.get_counter("t_ut_chan_received_total", "Values received", labels),
+            &registry.get_counter("t_ut_chan_overwritten_total", "Values dropped before they were received", labels),
+            &registry.get_histogram("t_ut_chan_receive_wait_nanoseconds", "Time receive waited for a value", labels)};
+    }
+
+    counter* sent;
+    counter* received;
+    counter* overwritten;
+    histogram* receive_wait;
+};
+
+namespace internal
+{
+
+inline void record_send(const std::optional<chan_metrics>& metrics, bool overwritten) noexcept
+{
+    if(!metrics)
+        return;
+    metrics->sent->add();
+    if(overwritten)
+        metrics->overwritten->add();
+}
+
+inline std::chrono::steady_clock::time_point receive_started(const std::optional<chan_metrics>& metrics) noexcept
+{
+    return metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+}
+
+inline void record_receive(const std::optional<chan_metrics>& metrics, std::chrono::steady_clock::time_point started)
+{
+    if(!metrics)
+        return;
+    metrics->received->add();
+    const auto waited = std::chrono::steady_clock::now() - started;
+    metrics->receive_wait->record(
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()));
+}
+
+} // namespace internal
+
 template <typename value_type, size_t buffer_size = 1>
 class chan
 {
 public:
+    chan() = default;
+
+    /// The shared state of the channel is allocated from resource, which has to outlive all copies of the channel
+    explicit chan(std::pmr::memory_resource* resource)
+        : m_storage{std::allocate_shared<storage_type>(std::pmr::polymorphic_allocator<storage_type>{resource})}
+    {}
+
+    /// All copies of the channel report the values sent and received to metrics
+    explicit chan(const chan_metrics& metrics)
+    {
+        m_storage->metrics = metrics;
+    }
+
+    chan(const chan_metrics& metrics, std::pmr::memory_resource* resource)
+        : chan{resource}
+    {
+        m_storage->metrics = metrics;
+    }
+
     void send(const value_type& data)
     {
+        const trace_span span{"chan::send"};
+        const trace_flow flow = trace_flow::begin("chan::value");
+        bool overwritten;
         {
             std::lock_guard<std::mutex> lock{m_storage->mutex};
-            m_storage->data.push_or_override(data);
+            overwritten = m_storage->data.push_or_override(data);
+            m_storage->flows.push_or_override(flow);
         }
+        internal::record_send(m_storage->metrics, overwritten);
         m_storage->cond.notify_one();
     }
 
     const value_type& peek()
     {
-        if(m_storage->data.empty())
-        {
-            std::unique_lock<std::mutex> lock{m_storage->mutex};
-            m_storage->cond.wait(lock, [this]() {
-                return !m_storage->data.empty();
-            });
-        }
+        std::unique_lock<std::mutex> lock{m_storage->mutex};
+        m_storage->cond.wait(lock, [this]() {
+            return !m_storage->data.empty();
+        });
         return m_storage->data.peek();
     }
 
     value_type receive()
     {
-        if(m_storage->data.empty())
-        {
-            std::unique_lock<std::mutex> lock{m_storage->mutex};
-            m_storage->cond.wait(lock, [this]() {
-                return !m_storage->data.empty();
-            });
-        }
+        const trace_span span{"chan::receive"};
+        const auto started = internal::receive_started(m_storage->metrics);
+        std::unique_lock<std::mutex> lock{m_storage->mutex};
+        m_storage->cond.wait(lock, [this]() {
+            return !m_storage->data.empty();
+        });
+        internal::record_receive(m_storage->metrics, started);
+        m_storage->flows.pop_unchecked().end();
         return m_storage->data.pop_unchecked();
     }
 
@@ -54,11 +132,14 @@ private:
         std::mutex mutex;
         std::condition_variable cond;
         ringbuffer<internal_type, internal_size + 1> data;
+        /// Flow of every buffered value, so tracing links each send to its receive
+        ringbuffer<trace_flow, internal_size + 1> flows;
+        std::optional<chan_metrics> metrics;
     };
 
     using storage_type = buffered_chan_storage<value_type, buffer_size>;
 
-    std::shared_ptr<storage_type> m_storage = std::make_shared<storage_type>();
+    std::shared_ptr<storage_type> m_storage = std::allocate_shared<storage_type>(pool_allocator<storage_type>{});
 };
 
 /// Simple class that mimics the basic behaviour of golangs chan
@@ -66,47 +147,77 @@ template <typename value_type>
 class chan<value_type, 1>
 {
 public:
+    chan() = default;
+
+    /// The shared state of the channel is allocated from resource, which has to outlive all copies of the channel
+    explicit chan(std::pmr::memory_resource* resource)
+        : m_storage{std::allocate_shared<storage_type>(std::pmr::polymorphic_allocator<storage_type>{resource})}
+    {}
+
+    /// All copies of the channel report the values sent and received to metrics
+    explicit chan(const chan_metrics& metrics)
+    {
+        m_storage->metrics = metrics;
+    }
+
+    chan(const chan_metrics& metrics, std::pmr::memory_resource* resource)
+        : chan{resource}
+    {
+        m_storage->metrics = metrics;
+    }
 
     void send(const value_type& data)
     {
+        const trace_span span{"chan::send"};
+        const trace_flow flow = trace_flow::begin("chan::value");
+        bool overwritten;
         {
             std::lock_guard<std::mutex> lock{m_storage->mutex};
+            overwritten = m_storage->data.has_value();
             m_storage->data = data;
+            m_storage->flow = flow;
         }
+        internal::record_send(m_storage->metrics, overwritten);
         m_storage->cond.notify_one();
     }
 
     void send(value_type&& data)
     {
+        const trace_span span{"chan::send"};
+        const trace_flow flow = trace_flow::begin("chan::value");
+        bool overwritten;
         {
             std::lock_guard<std::mutex> lock{m_storage->mutex};
+            overwritten = m_storage->data.has_value();
             m_storage->data = std::move(data);
+            m_storage->flow = flow;
         }
+        internal::record_send(m_storage->metrics, overwritten);
         m_storage->cond.notify_one();
     }
 
     const value_type& peek()
     {
-        if(!m_storage->data)
-        {
-            std::unique_lock<std::mutex> lock{m_storage->mutex};
-            m_storage->cond.wait(lock, [this]() {
-                return m_storage->data != std::nullopt;
-            });
-        }
+        std::unique_lock<std::mutex> lock{m_storage->mutex};
+        m_storage->cond.wait(lock, [this]() {
+            return m_storage->data != std::nullopt;
+        });
         return *(m_storage->data);
     }
 
     value_type receive()
     {
-        if(!m_storage->data)
-        {
-            std::unique_lock<std::mutex> lock{m_storage->mutex};
-            m_storage->cond.wait(lock, [this]() {
-                return m_storage->data != std::nullopt;
-            });
-        }
-        return std::move(*(m_storage->data));
+        const trace_span span{"chan::receive"};
+        const auto started = internal::receive_started(m_storage->metrics);
+        std::unique_lock<std::mutex> lock{m_storage->mutex};
+        m_storage->cond.wait(lock, [this]() {
+            return m_storage->data != std::nullopt;
+        });
+        internal::record_receive(m_storage->metrics, started);
+        m_storage->flow.end();
+        value_type data = std::move(*(m_storage->data));
+        m_storage->data.reset();
+        return data;
     }
 
 private:
@@ -116,11 +227,14 @@ private:
         std::mutex mutex;
         std::condition_variable cond;
         std::optional<internal_type> data;
+        /// Flow of the value, so tracing links the send to its receive
+        trace_flow flow;
+        std::optional<chan_metrics> metrics;
     };
 
     using storage_type = chan_storage<value_type>;
 
-    std::shared_ptr<storage_type> m_storage = std::make_shared<storage_type>();
+    std::shared_ptr<storage_type> m_storage = std::allocate_shared<storage_type>(pool_allocator<storage_type>{});
 };
 
 template <typename value_type, size_t buffer_size>
@@ -0,0 +1,78 @@
+#ifndef CPP_UTILITY_COMPILE_TIME_BIMAP_HPP
+#define CPP_UTILITY_COMPILE_TIME_BIMAP_HPP
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include "compile_time_map.hpp"
+
+namespace t_ut
+{
+
+/// Two compile_time_maps built from one table, left() maps LEFT to RIGHT and right() maps RIGHT back to LEFT
+/// Both sides have to be unique, a constexpr bimap with a duplicate on either side does not compile
+/// Each side picks its own lookup strategy, so e.g. enum to name is an array index for contiguous enums and name to
+///     enum is a perfect hash
+template <typename LEFT, typename RIGHT, size_t SIZE>
+class compile_time_bimap
+{
+public:
+    using left_type = LEFT;
+    using right_type = RIGHT;
+    using pair_type = std::pair<left_type, right_type>;
+    using left_map_type = compile_time_map<left_type, right_type, SIZE>;
+    using right_map_type = compile_time_map<right_type, left_type, SIZE>;
+
+    template <typename ... PAIR>
+        requires (sizeof...(PAIR) == SIZE && (std::is_convertible_v<PAIR, pair_type> && ...))
+    constexpr compile_time_bimap(PAIR&& ... pairs)
+        : compile_time_bimap{std::array<pair_type, SIZE>{static_cast<PAIR&&>(pairs) ...}}
+    {}
+
+    constexpr compile_time_bimap(const std::initializer_list<pair_type>& init_list)
+        : compile_time_bimap{make_array<pair_type, SIZE>(init_list)}
+    {}
+
+    constexpr compile_time_bimap(const std::array<pair_type, SIZE>& data)
+        : m_left{data}
+        , m_right{swapped(data)}
+    {}
+
+    constexpr const left_map_type& left() const
+    {
+        return m_left;
+    }
+
+    constexpr const right_map_type& right() const
+    {
+        return m_right;
+    }
+
+    constexpr size_t size() const
+    {
+        return SIZE;
+    }
+
+private:
+    static constexpr std::array<std::pair<right_type, left_type>, SIZE> swapped(
+        const std::array<pair_type, SIZE>& data)
+    {
+        std::array<std::pair<right_type, left_type>, SIZE> result{};
+        for(size_t i = 0; i < SIZE; ++i)
+            result[i] = {data[i].second, data[i].first};
+        return result;
+    }
+
+    left_map_type m_left;
+    right_map_type m_right;
+};
+
+template <typename LEFT, typename RIGHT, size_t SIZE>
+compile_time_bimap(const std::array<std::pair<LEFT, RIGHT>, SIZE>&) -> compile_time_bimap<LEFT, RIGHT, SIZE>;
+
+} // namespace t_ut
+
+#endif
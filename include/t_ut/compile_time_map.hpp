@@ -1,7 +1,18 @@
 #ifndef CPP_UTILITY_COMPILE_TIME_MAP_HPP
 #define CPP_UTILITY_COMPILE_TIME_MAP_HPP
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace t_ut
 {
@@ -20,57 +31,426 @@ namespace
     constexpr std::array<T, N> make_array(const std::initializer_list<T>& init_list)
     {
         if(N != init_list.size())
-            return {};
+            throw std::invalid_argument{"initializer_list size does not match the size of compile_time_map"};
         return make_array_internal<T, N>(init_list, std::make_index_sequence<N>());
     }
 
 }
 
-template <typename KEY, typename VALUE, size_t SIZE>
+/// How a compile_time_map finds a key
+enum class lookup_strategy
+{
+    /// Compares the key with every entry, the fastest for a handful of entries
+    linear,
+    /// Entries are sorted by key and found with a binary search
+    sorted,
+    /// Perfect hash built at compile time, a lookup hashes once and compares a single key
+    perfect_hash
+};
+
+namespace internal
+{
+
+/// Finalizer of MurmurHash3, a bijection on 64 bit values that spreads every input bit over the whole result
+constexpr uint64_t mix_hash(uint64_t value) noexcept
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+template <typename KEY>
+concept integral_key = std::is_integral_v<KEY> || std::is_enum_v<KEY>;
+
+template <typename KEY>
+concept perfect_hashable = integral_key<KEY> || std::is_same_v<KEY, std::string_view>;
+
+/// Value of an integral or enum key as unsigned integer that keeps the order of signed keys
+template <integral_key KEY>
+constexpr uint64_t key_bits(const KEY& key) noexcept
+{
+    using underlying_type =
+        typename std::conditional_t<std::is_enum_v<KEY>, std::underlying_type<KEY>, std::type_identity<KEY>>::type;
+    const auto value = static_cast<underlying_type>(key);
+    if constexpr(std::is_signed_v<underlying_type>)
+        return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ (uint64_t{1} << 63);
+    else
+        return static_cast<uint64_t>(value);
+}
+
+template <integral_key KEY>
+constexpr uint64_t compile_time_hash(const KEY& key) noexcept
+{
+    return mix_hash(key_bits(key));
+}
+
+/// COUNT characters starting at position as little endian integer
+template <size_t COUNT>
+constexpr uint64_t string_chunk(std::string_view key, size_t position) noexcept
+{
+    if(!std::is_constant_evaluated() && std::endian::native == std::endian::little)
+    {
+        std::conditional_t<COUNT == 8, uint64_t, uint32_t> chunk;
+        std::memcpy(&chunk, key.data() + position, COUNT);
+        return chunk;
+    }
+    uint64_t chunk = 0;
+    for(size_t i = 0; i < COUNT; ++i)
+        chunk |= static_cast<uint64_t>(static_cast<unsigned char>(key[position + i])) << (8 * i);
+    return chunk;
+}
+
+constexpr uint64_t string_hash_step(uint64_t hash, uint64_t chunk) noexcept
+{
+    return std::rotl((hash ^ chunk) * 0x9e3779b97f4a7c15ULL, 29);
+}
+
+/// Hashes 8 characters per step, gives the same result at compile time and at run time
+/// The last chunk overlaps the previous one instead of reading a variable number of characters
+constexpr uint64_t compile_time_hash(std::string_view key) noexcept
+{
+    const size_t size = key.size();
+    uint64_t hash = size;
+    for(size_t position = 0; position + 8 < size; position += 8)
+        hash = string_hash_step(hash, string_chunk<8>(key, position));
+
+    uint64_t last = 0;
+    if(size >= 8)
+        last = string_chunk<8>(key, size - 8);
+    else if(size >= 4)
+        last = string_chunk<4>(key, 0) | (string_chunk<4>(key, size - 4) << 32);
+    else if(size > 0)
+        last = static_cast<unsigned char>(key[0]) | (static_cast<uint64_t>(static_cast<unsigned char>(key[size / 2])) << 8)
+            | (static_cast<uint64_t>(static_cast<unsigned char>(key[size - 1])) << 16);
+    return mix_hash(string_hash_step(hash, last));
+}
+
+/// Strategy a compile_time_map uses unless it is given one
+/// Pointers are compared by address, ordering unrelated pointers is not allowed at compile time
+template <typename KEY, size_t SIZE>
+constexpr lookup_strategy default_lookup_strategy()
+{
+    if constexpr(SIZE <= 8)
+        return lookup_strategy::linear;
+    else if constexpr(perfect_hashable<KEY>)
+        return lookup_strategy::perfect_hash;
+    else if constexpr(std::totally_ordered<KEY> && !std::is_pointer_v<KEY>)
+        return lookup_strategy::sorted;
+    else
+        return lookup_strategy::linear;
+}
+
+/// Index of the linear and sorted strategies, which search the entries themselves
+struct no_lookup_table
+{};
+
+/// Hash and displace perfect hash over SIZE keys
+/// Keys are grouped into buckets of about two by their hash, every bucket gets a seed that moves all of its keys
+///     into free slots. A slot holds the index of its entry, unused slots point to entry 0 so a lookup of a missing
+///     key just fails the key comparison.
+/// Integral keys that lie close together, like most enums, skip the hash and use their offset to the smallest key
+///     as slot instead
+template <size_t SIZE>
+class perfect_hash_table
+{
+public:
+    static constexpr size_t bucket_count = SIZE / 2 + 1;
+    static constexpr size_t slot_count = std::bit_ceil(SIZE + SIZE / 4 + 2);
+
+    using index_type = std::conditional_t<SIZE <= UINT8_MAX, uint8_t,
+        std::conditional_t<SIZE <= UINT16_MAX, uint16_t, uint32_t>>;
+
+    /// Throws std::invalid_argument, which fails the compilation of a constexpr map, if two hashes are equal
+    constexpr void build(const std::array<uint64_t, SIZE>& hashes)
+    {
+        std::array<size_t, SIZE> order{};
+        std::array<size_t, bucket_count> sizes{};
+        for(size_t i = 0; i < SIZE; ++i)
+        {
+            order[i] = i;
+            ++sizes[bucket(hashes[i])];
+        }
+
+        // Equal hashes end up in the same slot with every seed, these are duplicate keys
+        std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return hashes[lhs] < hashes[rhs]; });
+        for(size_t i = 1; i < SIZE; ++i)
+        {
+            if(hashes[order[i - 1]] == hashes[order[i]])
+                throw std::invalid_argument{"duplicate key in compile_time_map"};
+        }
+
+        // Place the largest buckets first while most slots are still free
+        std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs)
+        {
+            const size_t lhs_bucket = bucket(hashes[lhs]);
+            const size_t rhs_bucket = bucket(hashes[rhs]);
+            if(sizes[lhs_bucket] != sizes[rhs_bucket])
+                return sizes[lhs_bucket] > sizes[rhs_bucket];
+            return lhs_bucket < rhs_bucket;
+        });
+
+        std::array<bool, slot_count> taken{};
+        for(size_t begin = 0; begin < SIZE;)
+        {
+            const size_t current = bucket(hashes[order[begin]]);
+            const size_t end = begin + sizes[current];
+            for(uint32_t seed = 0;; ++seed)
+            {
+                if(seed > UINT16_MAX)
+                    throw std::invalid_argument{"no perfect hash found for compile_time_map"};
+
+                size_t placed = begin;
+                for(; placed < end && !taken[slot(hashes[order[placed]], seed)]; ++placed)
+                    taken[slot(hashes[order[placed]], seed)] = true;
+
+                if(placed == end)
+                {
+                    for(size_t i = begin; i < end; ++i)
+                        m_slots[slot(hashes[order[i]], seed)] = static_cast<index_type>(order[i]);
+                    m_seeds[current] = static_cast<uint16_t>(seed);
+                    break;
+                }
+                for(size_t i = begin; i < placed; ++i)
+                    taken[slot(hashes[order[i]], seed)] = false;
+            }
+            begin = end;
+        }
+    }
+
+    /// Indexes values, the key_bits() of the keys, directly if they are less than slot_count apart
+    /// Returns false and leaves the table unchanged otherwise
+    constexpr bool build_direct(const std::array<uint64_t, SIZE>& values)
+    {
+        if(SIZE == 0)
+            return false;
+        const auto [min, max] = std::minmax_element(values.begin(), values.end());
+        if(*max - *min >= slot_count)
+            return false;
+
+        std::array<bool, slot_count> taken{};
+        for(size_t i = 0; i < SIZE; ++i)
+        {
+            const size_t offset = static_cast<size_t>(values[i] - *min);
+            if(taken[offset])
+                throw std::invalid_argument{"duplicate key in compile_time_map"};
+            taken[offset] = true;
+            m_slots[offset] = static_cast<index_type>(i);
+        }
+        m_first = *min;
+        m_direct = true;
+        return true;
+    }
+
+    constexpr bool is_direct() const
+    {
+        return m_direct;
+    }
+
+    /// Index of the only entry that can have this hash
+    constexpr size_t find(uint64_t hash) const
+    {
+        return m_slots[slot(hash, m_seeds[bucket(hash)])];
+    }
+
+    /// Index of the only entry that can have this value in a direct table
+    constexpr size_t find_direct(uint64_t value) const
+    {
+        const uint64_t offset = value - m_first;
+        return offset < slot_count ? m_slots[offset] : 0;
+    }
+
+private:
+    static constexpr size_t bucket(uint64_t hash)
+    {
+        return static_cast<size_t>(((hash >> 32) * bucket_count) >> 32);
+    }
+
+    /// The hash is already mixed, a multiplication is enough to move it around for every seed
+    static constexpr size_t slot(uint64_t hash, uint32_t seed)
+    {
+        constexpr int slot_bits = std::countr_zero(slot_count);
+        return static_cast<size_t>(((hash ^ (seed * 0x9e3779b97f4a7c15ULL)) * 0xbf58476d1ce4e5b9ULL) >> (64 - slot_bits));
+    }
+
+    std::array<uint16_t, bucket_count> m_seeds{};
+    std::array<index_type, slot_count> m_slots{};
+    uint64_t m_first = 0;
+    bool m_direct = false;
+};
+
+} // namespace internal
+
+/// Fixed map that is meant to be built at compile time
+/// STRATEGY picks how keys are found. By default maps of up to 8 entries are scanned linearly, integral, enum and
+///     std::string_view keys get a perfect hash and other ordered keys are sorted for a binary search.
+/// Use std::string_view for string keys, const char* keys are compared by address
+/// Keys have to be unique, a constexpr map with duplicate keys or a wrong number of entries does not compile
+/// find() returns nullptr for a missing key, at() throws std::out_of_range and operator[] returns a default
+///     constructed value
+/// Lookups in a constant expression, e.g. to initialize a constexpr variable, are done entirely at compile time
+template <typename KEY, typename VALUE, size_t SIZE,
+    lookup_strategy STRATEGY = internal::default_lookup_strategy<KEY, SIZE>()>
 class compile_time_map
 {
+    static_assert(STRATEGY != lookup_strategy::perfect_hash || internal::perfect_hashable<KEY>,
+        "perfect_hash needs integral, enum or std::string_view keys");
+    static_assert(STRATEGY != lookup_strategy::sorted || std::totally_ordered<KEY>, "sorted needs ordered keys");
+
 public:
     using key_type = KEY;
     using value_type = VALUE;
     using pair_type = std::pair<key_type, value_type>;
 
+    static constexpr lookup_strategy strategy = STRATEGY;
+
     template <typename ... PAIR>
     constexpr compile_time_map(PAIR&& ... pairs)
         : m_buffer{static_cast<PAIR&&>(pairs) ...}
-    {}
+    {
+        build();
+    }
 
     constexpr compile_time_map(const std::initializer_list<pair_type>& init_list)
         : m_buffer{make_array<pair_type, SIZE>(init_list)}
-    {}
+    {
+        build();
+    }
 
     constexpr compile_time_map(const std::array<pair_type, SIZE> &data)
         : m_buffer{data}
-    {}
+    {
+        build();
+    }
+
+    /// Pointer to the value of key or nullptr
+    constexpr const value_type* find(const key_type& key) const
+    {
+        const size_t index = find_index(key);
+        return index < SIZE ? &m_buffer[index].second : nullptr;
+    }
+
+    constexpr bool contains(const key_type& key) const
+    {
+        return find_index(key) < SIZE;
+    }
 
     constexpr value_type operator[](const key_type& key) const
     {
-        for(const auto& pair : m_buffer)
+        const value_type* value = find(key);
+        return value ? *value : value_type{};
+    }
+
+    constexpr const value_type& at(const key_type& key) const
+    {
+        const value_type* value = find(key);
+        if(!value)
+            throw std::out_of_range{""};
+        return *value;
+    }
+
+    constexpr size_t size() const
+    {
+        return SIZE;
+    }
+
+private:
+    using lookup_table = std::conditional_t<STRATEGY == lookup_strategy::perfect_hash,
+        internal::perfect_hash_table<SIZE>, internal::no_lookup_table>;
+
+    static constexpr bool key_less(const pair_type& lhs, const pair_type& rhs)
+    {
+        return lhs.first < rhs.first;
+    }
+
+    constexpr void build()
+    {
+        if constexpr(STRATEGY == lookup_strategy::perfect_hash)
+        {
+            if constexpr(internal::integral_key<KEY>)
+            {
+                std::array<uint64_t, SIZE> values{};
+                for(size_t i = 0; i < SIZE; ++i)
+                    values[i] = internal::key_bits(m_buffer[i].first);
+                if(m_lookup.build_direct(values))
+                    return;
+            }
+
+            std::array<uint64_t, SIZE> hashes{};
+            for(size_t i = 0; i < SIZE; ++i)
+                hashes[i] = internal::compile_time_hash(m_buffer[i].first);
+            m_lookup.build(hashes);
+        }
+        else if constexpr(STRATEGY == lookup_strategy::sorted)
+        {
+            std::sort(m_buffer.begin(), m_buffer.end(), key_less);
+            for(size_t i = 1; i < SIZE; ++i)
+            {
+                if(!(m_buffer[i - 1].first < m_buffer[i].first))
+                    throw std::invalid_argument{"duplicate key in compile_time_map"};
+            }
+        }
+        else
         {
-            if(pair.first == key)
-                return pair.second;
+            for(size_t i = 0; i < SIZE; ++i)
+            {
+                for(size_t j = i + 1; j < SIZE; ++j)
+                {
+                    if(m_buffer[i].first == m_buffer[j].first)
+                        throw std::invalid_argument{"duplicate key in compile_time_map"};
+                }
+            }
         }
-        return {};
     }
 
-    constexpr value_type at(const key_type& key) const
+    /// Index of key in m_buffer, SIZE if it is missing
+    constexpr size_t find_index(const key_type& key) const
     {
-        for(const auto& pair : m_buffer)
+        if constexpr(STRATEGY == lookup_strategy::perfect_hash)
         {
-            if(pair.first == key)
-                return pair.second;
+            if constexpr(SIZE > 0)
+            {
+                size_t index;
+                if constexpr(internal::integral_key<KEY>)
+                {
+                    index = m_lookup.is_direct() ? m_lookup.find_direct(internal::key_bits(key))
+                                                 : m_lookup.find(internal::compile_time_hash(key));
+                }
+                else
+                {
+                    index = m_lookup.find(internal::compile_time_hash(key));
+                }
+                if(m_buffer[index].first == key)
+                    return index;
+            }
+            return SIZE;
+        }
+        else if constexpr(STRATEGY == lookup_strategy::sorted)
+        {
+            const auto it = std::lower_bound(m_buffer.begin(), m_buffer.end(), key,
+                [](const pair_type& pair, const key_type& value) { return pair.first < value; });
+            return it != m_buffer.end() && it->first == key ? static_cast<size_t>(it - m_buffer.begin()) : SIZE;
+        }
+        else
+        {
+            for(size_t i = 0; i < SIZE; ++i)
+            {
+                if(m_buffer[i].first == key)
+                    return i;
+            }
+            return SIZE;
         }
-        return {};
     }
 
-private:
     std::array<pair_type, SIZE> m_buffer;
+    [[no_unique_address]] lookup_table m_lookup;
 };
 
+template <typename KEY, typename VALUE, size_t SIZE>
+compile_time_map(const std::array<std::pair<KEY, VALUE>, SIZE>&) -> compile_time_map<KEY, VALUE, SIZE>;
+
 } // namespace t_ut
 
 #endif
@@ -0,0 +1,530 @@
+#ifndef CPP_UTILITY_CONCURRENT_HASH_MAP_HPP
+#define CPP_UTILITY_CONCURRENT_HASH_MAP_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cache_line.hpp"
+#include "compile_time_map.hpp"
+#include "ebr.hpp"
+#include "object_pool.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+inline constexpr size_t hash_group_size = 16;
+inline constexpr uint8_t hash_ctrl_empty = 0x80;
+inline constexpr uint8_t hash_ctrl_deleted = 0xFE;
+inline constexpr uint64_t hash_ctrl_empty_word = 0x8080808080808080ULL;
+
+/// Bit i is set for every control byte i of a group that equals value
+/// Not routed through simd_dispatch(): a group is exactly one 16 byte SSE2 register, which is baseline on x86-64, and
+///     a probe mostly ends in its first group, so AVX2 or AVX-512 would have nothing to compare in the wider lanes while
+///     the dispatch adds a branch to every lookup
+inline uint32_t match_ctrl(uint64_t low, uint64_t high, uint8_t value) noexcept
+{
+#if defined(__SSE2__)
+    const __m128i ctrl = _mm_set_epi64x(static_cast<long long>(high), static_cast<long long>(low));
+    const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, pattern)));
+#else
+    uint32_t mask = 0;
+    for(unsigned i = 0; i < 8; ++i)
+    {
+        mask |= static_cast<uint32_t>(static_cast<uint8_t>(low >> (8 * i)) == value) << i;
+        mask |= static_cast<uint32_t>(static_cast<uint8_t>(high >> (8 * i)) == value) << (i + 8);
+    }
+    return mask;
+#endif
+}
+
+/// Entries are immutable, a new value replaces the whole node so readers never see a value that is being written
+template <typename KEY, typename VALUE>
+struct hash_node
+{
+    uint64_t hash;
+    KEY key;
+    VALUE value;
+};
+
+/// 16 control bytes, either empty, deleted or the low 7 bits of the hash of the entry, and the 16 entries they describe
+/// Readers compare all control bytes against the hash at once and only look at the entries that match
+template <typename NODE>
+struct alignas(cache_line_size) hash_group
+{
+    hash_group() noexcept
+    {
+        for(auto& word : ctrl)
+            word.store(hash_ctrl_empty_word, std::memory_order_relaxed);
+        for(auto& slot : slots)
+            slot.store(nullptr, std::memory_order_relaxed);
+    }
+
+    uint32_t match(uint8_t value) const noexcept
+    {
+        return match_ctrl(ctrl[0].load(std::memory_order_acquire), ctrl[1].load(std::memory_order_acquire), value);
+    }
+
+    /// Only called by the writer of the segment, which holds its lock
+    void set_ctrl(size_t index, uint8_t value) noexcept
+    {
+        auto& word = ctrl[index / 8];
+        const unsigned shift = 8 * (index % 8);
+        const uint64_t current = word.load(std::memory_order_relaxed);
+        word.store((current & ~(uint64_t{0xFF} << shift)) | (uint64_t{value} << shift), std::memory_order_release);
+    }
+
+    std::atomic<uint64_t> ctrl[2];
+    std::atomic<NODE*> slots[hash_group_size];
+};
+
+/// Open addressing table of one segment, probing visits whole groups in triangular steps
+/// While a table grows, the next one points back to it until all entries were moved over
+template <typename NODE>
+struct hash_table
+{
+    explicit hash_table(size_t group_count)
+        : mask{group_count - 1}
+        , groups{new hash_group<NODE>[group_count]}
+    {}
+
+    size_t capacity() const noexcept
+    {
+        return (mask + 1) * hash_group_size;
+    }
+
+    const size_t mask;
+    const std::unique_ptr<hash_group<NODE>[]> groups;
+    std::atomic<hash_table*> prev = nullptr;
+
+    // Only used by the writer of the segment
+    /// Full and deleted slots, a table is replaced once they reach 7/8 of the capacity
+    size_t used = 0;
+};
+
+} // namespace internal
+
+/// Hash map for state that many threads read and some threads change, e.g. a session cache
+/// Lookups take no lock: they run inside an ebr_guard and find entries by matching 16 control bytes of a group with
+///     one SIMD compare, as in Swiss tables. Entries are immutable nodes, so find() copies a value that can not
+///     change under it, and replaced or erased nodes are freed through epoch based reclamation
+/// Writers lock one of the segments the keys are spread over. A full segment grows incrementally: every write to it
+///     moves two groups of the old table to the new one, while readers look in both
+/// Keys and values have to be copyable, nodes come from the shared object_pool of their type
+template <typename KEY, typename VALUE, typename HASH = std::hash<KEY>, typename EQUAL = std::equal_to<KEY>>
+class concurrent_hash_map
+{
+    using node_type = internal::hash_node<KEY, VALUE>;
+    using group_type = internal::hash_group<node_type>;
+    using table_type = internal::hash_table<node_type>;
+
+public:
+    using key_type = KEY;
+    using mapped_type = VALUE;
+    using hasher = HASH;
+    using key_equal = EQUAL;
+
+    /// concurrency is the number of segments and so of writers that can work at the same time, rounded up to a power
+    ///     of two of at most 1024
+    explicit concurrent_hash_map(size_t concurrency = 64, HASH hash = HASH{}, EQUAL equal = EQUAL{})
+        : m_hash{std::move(hash)}
+        , m_equal{std::move(equal)}
+        , m_segment_mask{std::bit_ceil(std::clamp(concurrency, size_t{1}, max_segments)) - 1}
+        , m_segments{new segment[m_segment_mask + 1]}
+    {}
+
+    concurrent_hash_map(const concurrent_hash_map&) = delete;
+    concurrent_hash_map& operator=(const concurrent_hash_map&) = delete;
+
+    ~concurrent_hash_map()
+    {
+        for(size_t s = 0; s <= m_segment_mask; ++s)
+        {
+            table_type* table = m_segments[s].table.load(std::memory_order_relaxed);
+            if(table_type* prev = table->prev.load(std::memory_order_relaxed))
+                destroy(prev);
+            destroy(table);
+        }
+    }
+
+    size_t size() const noexcept
+    {
+        size_t result = 0;
+        for(size_t s = 0; s <= m_segment_mask; ++s)
+            result += m_segments[s].size.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    /// Copy of the value of key, if there is one
+    std::optional<VALUE> find(const KEY& key) const
+    {
+        std::optional<VALUE> result;
+        visit(key, [&](const VALUE& value) { result.emplace(value); });
+        return result;
+    }
+
+    bool contains(const KEY& key) const
+    {
+        return visit(key, [](const VALUE&) {});
+    }
+
+    /// Calls func with the value of key without copying it, the value may be replaced in the map meanwhile but stays
+    ///     alive until func returns
+    template <typename FUNC>
+    bool visit(const KEY& key, FUNC&& func) const
+    {
+        const uint64_t hash = hash_of(key);
+        const segment& seg = segment_for(hash);
+        const ebr_guard guard;
+
+        while(true)
+        {
+            const table_type* table = seg.table.load(std::memory_order_acquire);
+
+            // Entries only move from the old table to the new one, and are in the new one before they leave the old
+            const node_type* node = nullptr;
+            if(const table_type* prev = table->prev.load(std::memory_order_acquire))
+                node = find_node(*prev, hash, key);
+            if(!node)
+                node = find_node(*table, hash, key);
+
+            if(node)
+            {
+                std::invoke(func, std::as_const(node->value));
+                return true;
+            }
+            // A segment that started to grow after the table was loaded may have moved the entry already
+            if(seg.table.load(std::memory_order_acquire) == table)
+                return false;
+        }
+    }
+
+    /// Inserts value if key is not in the map yet, returns whether it was inserted
+    bool insert(const KEY& key, VALUE value)
+    {
+        return emplace(key, std::move(value), false);
+    }
+
+    /// Inserts value or replaces the value of key, returns whether it was inserted
+    bool insert_or_assign(const KEY& key, VALUE value)
+    {
+        return emplace(key, std::move(value), true);
+    }
+
+    bool erase(const KEY& key)
+    {
+        const uint64_t hash = hash_of(key);
+        segment& seg = segment_for(hash);
+        unlinked garbage;
+        std::unique_lock<std::mutex> lock{seg.mutex};
+        const bool erased = erase_locked(seg, hash, key, garbage);
+        lock.unlock();
+        garbage.retire();
+        return erased;
+    }
+
+private:
+    static constexpr size_t max_segments = 1024;
+    /// Groups of the old table moved by every write to a growing segment
+    static constexpr size_t migrate_batch = 2;
+
+    struct alignas(internal::cache_line_size) segment
+    {
+        segment()
+            : table{new table_type{1}}
+        {}
+
+        std::mutex mutex;
+        std::atomic<table_type*> table;
+        std::atomic<size_t> size = 0;
+        /// Groups of the previous table that were moved
+        size_t migrated = 0;
+    };
+
+    struct location
+    {
+        group_type* group;
+        size_t index;
+    };
+
+    /// What a write unlinked under the segment lock, retired only once the lock is released, as retiring may issue a
+    ///     membarrier that the other writers of the segment should not wait for
+    /// A write unlinks at most the node it replaces or erases and the old table of a finished growth
+    struct unlinked
+    {
+        unlinked() = default;
+        unlinked(const unlinked&) = delete;
+        unlinked& operator=(const unlinked&) = delete;
+
+        /// Only has something left if the write threw after unlinking, if retiring throws as well that is leaked
+        ///     rather than freed while readers may still use it
+        ~unlinked()
+        {
+            try
+            {
+                retire();
+            }
+            catch(...)
+            {}
+        }
+
+        void retire()
+        {
+            if(node_type* n = std::exchange(node, nullptr))
+                concurrent_hash_map::retire(n);
+            if(table_type* t = std::exchange(table, nullptr))
+                ebr_domain::global().retire(t, [](void* ptr) { delete static_cast<table_type*>(ptr); });
+        }
+
+        node_type* node = nullptr;
+        table_type* table = nullptr;
+    };
+
+    uint64_t hash_of(const KEY& key) const
+    {
+        return internal::mix_hash(static_cast<uint64_t>(m_hash(key)));
+    }
+
+    /// The top bits select the segment, the low 7 bits go into the control byte and the bits above select the group
+    segment& segment_for(uint64_t hash) const noexcept
+    {
+        return m_segments[(hash >> 54) & m_segment_mask];
+    }
+
+    static uint8_t ctrl_of(uint64_t hash) noexcept
+    {
+        return static_cast<uint8_t>(hash & 0x7F);
+    }
+
+    const node_type* find_node(const table_type& table, uint64_t hash, const KEY& key) const
+    {
+        const uint8_t ctrl = ctrl_of(hash);
+        size_t g = (hash >> 7) & table.mask;
+        for(size_t step = 1; step <= table.mask + 1; ++step)
+        {
+            const group_type& group = table.groups[g];
+            for(uint32_t match = group.match(ctrl); match; match &= match - 1)
+            {
+                const node_type* node = group.slots[std::countr_zero(match)].load(std::memory_order_acquire);
+                if(node && node->hash == hash && m_equal(node->key, key))
+                    return node;
+            }
+            if(group.match(internal::hash_ctrl_empty))
+                return nullptr;
+            g = (g + step) & table.mask;
+        }
+        return nullptr;
+    }
+
+    /// Slot of key in table, only called by the writer of the segment
+    location locate(table_type& table, uint64_t hash, const KEY& key) const
+    {
+        const node_type* node = find_node(table, hash, key);
+        if(!node)
+            return {nullptr, 0};
+
+        size_t g = (hash >> 7) & table.mask;
+        for(size_t step = 1;; ++step)
+        {
+            group_type& group = table.groups[g];
+            for(uint32_t match = group.match(ctrl_of(hash)); match; match &= match - 1)
+            {
+                const size_t index = static_cast<size_t>(std::countr_zero(match));
+                if(group.slots[index].load(std::memory_order_relaxed) == node)
+                    return {&group, index};
+            }
+            g = (g + step) & table.mask;
+        }
+    }
+
+    /// Stores node in the first empty or deleted slot of its probe sequence, the slot is filled before the control
+    ///     byte announces it, so readers that see the control byte also see the node
+    static void place(table_type& table, node_type* node) noexcept
+    {
+        size_t g = (node->hash >> 7) & table.mask;
+        for(size_t step = 1;; ++step)
+        {
+            group_type& group = table.groups[g];
+            const uint32_t free = group.match(internal::hash_ctrl_empty) | group.match(internal::hash_ctrl_deleted);
+            if(free)
+            {
+                const size_t index = static_cast<size_t>(std::countr_zero(free));
+                if(group.match(internal::hash_ctrl_empty) & (uint32_t{1} << index))
+                    ++table.used;
+                group.slots[index].store(node, std::memory_order_release);
+                group.set_ctrl(index, ctrl_of(node->hash));
+                return;
+            }
+            g = (g + step) & table.mask;
+        }
+    }
+
+    /// Deleted slots keep the probe sequences of other keys intact, they are reused by inserts and dropped on growth
+    static void remove(group_type& group, size_t index) noexcept
+    {
+        group.slots[index].store(nullptr, std::memory_order_release);
+        group.set_ctrl(index, internal::hash_ctrl_deleted);
+    }
+
+    bool erase_locked(segment& seg, uint64_t hash, const KEY& key, unlinked& garbage)
+    {
+        table_type* table = seg.table.load(std::memory_order_relaxed);
+        migrate_step(seg, table, garbage);
+
+        for(table_type* t : {table->prev.load(std::memory_order_relaxed), table})
+        {
+            if(!t)
+                continue;
+            if(auto [group, index] = locate(*t, hash, key); group)
+            {
+                garbage.node = group->slots[index].load(std::memory_order_relaxed);
+                remove(*group, index);
+                seg.size.store(seg.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool emplace(const KEY& key, VALUE&& value, bool assign)
+    {
+        const uint64_t hash = hash_of(key);
+        segment& seg = segment_for(hash);
+        unlinked garbage;
+        std::unique_lock<std::mutex> lock{seg.mutex};
+        const bool inserted = emplace_locked(seg, hash, key, std::move(value), assign, garbage);
+        lock.unlock();
+        garbage.retire();
+        return inserted;
+    }
+
+    bool emplace_locked(segment& seg, uint64_t hash, const KEY& key, VALUE&& value, bool assign, unlinked& garbage)
+    {
+        table_type* table = seg.table.load(std::memory_order_relaxed);
+        migrate_step(seg, table, garbage);
+
+        // Move an entry that is still in the old table first, so the new one is the only place to look at
+        if(table_type* prev = table->prev.load(std::memory_order_relaxed))
+        {
+            if(auto [group, index] = locate(*prev, hash, key); group)
+            {
+                node_type* node = group->slots[index].load(std::memory_order_relaxed);
+                place(*table, node);
+                remove(*group, index);
+            }
+        }
+
+        if(auto [group, index] = locate(*table, hash, key); group)
+        {
+            if(!assign)
+                return false;
+            node_type* old = group->slots[index].load(std::memory_order_relaxed);
+            group->slots[index].store(make_node(hash, key, std::move(value)), std::memory_order_release);
+            garbage.node = old;
+            return false;
+        }
+
+        node_type* node = make_node(hash, key, std::move(value));
+        if(table->used + 1 > table->capacity() / 8 * 7)
+            table = grow(seg, table, garbage);
+        place(*table, node);
+        seg.size.store(seg.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Starts moving the entries of table to a new one that has room for twice as many, a growth that is still in
+    ///     progress is finished first
+    table_type* grow(segment& seg, table_type* table, unlinked& garbage)
+    {
+        while(table->prev.load(std::memory_order_relaxed))
+            migrate_step(seg, table, garbage);
+
+        const size_t live = seg.size.load(std::memory_order_relaxed) + 1;
+        const size_t groups = std::bit_ceil(std::max(size_t{1}, live * 2 / internal::hash_group_size + 1));
+        auto* next = new table_type{groups};
+        next->prev.store(table, std::memory_order_relaxed);
+        seg.migrated = 0;
+        seg.table.store(next, std::memory_order_release);
+        return next;
+    }
+
+    /// Moves the next groups of a growing segment, the old table is unlinked once it is empty
+    void migrate_step(segment& seg, table_type* table, unlinked& garbage)
+    {
+        table_type* prev = table->prev.load(std::memory_order_relaxed);
+        if(!prev)
+            return;
+
+        const size_t end = std::min(seg.migrated + migrate_batch, prev->mask + 1);
+        for(; seg.migrated < end; ++seg.migrated)
+        {
+            group_type& group = prev->groups[seg.migrated];
+            for(size_t index = 0; index < internal::hash_group_size; ++index)
+            {
+                if(node_type* node = group.slots[index].load(std::memory_order_relaxed))
+                {
+                    place(*table, node);
+                    remove(group, index);
+                }
+            }
+        }
+
+        if(seg.migrated > prev->mask)
+        {
+            table->prev.store(nullptr, std::memory_order_release);
+            garbage.table = prev;
+        }
+    }
+
+    static node_type* make_node(uint64_t hash, const KEY& key, VALUE&& value)
+    {
+        return object_pool<node_type>::shared().create(hash, key, std::move(value));
+    }
+
+    static void retire(node_type* node)
+    {
+        ebr_domain::global().retire(node, [](void* ptr) {
+            object_pool<node_type>::shared().destroy(static_cast<node_type*>(ptr));
+        });
+    }
+
+    static void destroy(table_type* table)
+    {
+        for(size_t g = 0; g <= table->mask; ++g)
+        {
+            for(auto& slot : table->groups[g].slots)
+            {
+                if(node_type* node = slot.load(std::memory_order_relaxed))
+                    object_pool<node_type>::shared().destroy(node);
+            }
+        }
+        delete table;
+    }
+
+    [[no_unique_address]] HASH m_hash;
+    [[no_unique_address]] EQUAL m_equal;
+    const size_t m_segment_mask;
+    const std::unique_ptr<segment[]> m_segments;
+};
+
+} // namespace t_ut
+
+#endif
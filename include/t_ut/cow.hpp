@@ -1,15 +1,49 @@
 #ifndef CPP_UTILITY_COW_HPP
 #define CPP_UTILITY_COW_HPP
 
-#include <variant>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include "hazard_pointer.hpp"
+#include "refcount.hpp"
 
 namespace t_ut
 {
 
-/// Simple implementation of a Copy-on Write class
+namespace internal
+{
+
+/// Heap block of an owned cow, the value and its reference count are allocated together
+template <typename T, typename REFCOUNT>
+struct cow_block
+{
+    template <typename ... ARGS>
+    explicit cow_block(ARGS&& ... args)
+        : value(std::forward<ARGS>(args)...)
+    {}
+
+    REFCOUNT count;
+    T value;
+};
+
+} // namespace internal
+
 template <typename T>
+class atomic_cow;
+
+/// Simple implementation of a Copy-on Write class
+/// A cow either borrows a value it does not own or shares an owned value with its copies through a reference count
+///     stored next to the value, so copying an owned cow never copies the value
+/// The value is only copied by mut_ref() if it is borrowed or shared with other copies
+/// REFCOUNT is atomic_refcount if copies are handed to other threads, local_refcount if they all stay on one thread
+/// A moved from cow may only be assigned to or destroyed
+template <typename T, typename REFCOUNT = atomic_refcount>
 class cow
 {
+    using block_type = internal::cow_block<T, REFCOUNT>;
+
 public:
     using value_type = T;
     using reference = value_type&;
@@ -19,29 +53,61 @@ public:
     using iterator = pointer;
     using const_iterator = const_pointer;
 
-    cow(const_reference ref_to)
-        : m_data{&ref_to}
+    /// Borrows ref_to, which has to outlive the cow and all of its copies that are not modified
+    cow(const_reference ref_to) noexcept
+        : m_value{&ref_to}
+    {}
+
+    /// Takes ownership of a temporary instead of borrowing it
+    cow(value_type&& value)
+        : cow{std::in_place, std::move(value)}
     {}
 
-    cow(const cow& rhs)
+    template <typename ... ARGS>
+    explicit cow(std::in_place_t, ARGS&& ... args)
+        : m_block{new block_type(std::forward<ARGS>(args)...)}
+        , m_value{&m_block->value}
+    {}
+
+    cow(const cow& rhs) noexcept
+        : m_block{rhs.m_block}
+        , m_value{rhs.m_value}
     {
-        *this = rhs;
+        if(m_block)
+            m_block->count.retain();
     }
 
-    cow& operator=(const cow& rhs)
+    cow& operator=(const cow& rhs) noexcept
     {
-        if(rhs.is_borrowed())
-            m_data = &rhs.ref();
-        else
-            m_data = rhs.ref();
+        cow{rhs}.swap(*this);
+        return *this;
     }
 
-    cow(cow&&) = default;
-    cow& operator=(cow&&) = default;
+    cow(cow&& rhs) noexcept
+        : m_block{std::exchange(rhs.m_block, nullptr)}
+        , m_value{std::exchange(rhs.m_value, nullptr)}
+    {}
+
+    cow& operator=(cow&& rhs) noexcept
+    {
+        cow{std::move(rhs)}.swap(*this);
+        return *this;
+    }
+
+    ~cow()
+    {
+        release();
+    }
+
+    void swap(cow& other) noexcept
+    {
+        std::swap(m_block, other.m_block);
+        std::swap(m_value, other.m_value);
+    }
 
     bool is_borrowed() const
     {
-        return std::holds_alternative<const_pointer>(m_data);
+        return m_block == nullptr;
     }
 
     bool is_owned() const
@@ -49,21 +115,28 @@ public:
         return !is_borrowed();
     }
 
+    /// Number of cows sharing the owned value, 0 if it is borrowed
+    size_t use_count() const
+    {
+        return m_block ? m_block->count.count() : 0;
+    }
+
     const_reference ref() const
     {
-        if(is_borrowed())
-            return *std::get<const_pointer>(m_data);
-        else
-            return std::get<value_type>(m_data);
+        return *m_value;
     }
 
+    /// Copies the value first unless this cow is its only owner
     reference mut_ref()
     {
-        if(is_borrowed())
+        if(!m_block || m_block->count.count() != 1)
         {
-            m_data = *std::get<const_pointer>(m_data);
+            block_type* copy = new block_type(*m_value);
+            release();
+            m_block = copy;
+            m_value = &copy->value;
         }
-        return std::get<value_type>(m_data);
+        return m_block->value;
     }
 
     const_reference operator*() const
@@ -76,8 +149,132 @@ public:
         return mut_ref();
     }
 
+    const_pointer operator->() const
+    {
+        return m_value;
+    }
+
+private:
+    friend class atomic_cow<T>;
+
+    /// Takes over a reference to block
+    explicit cow(block_type* block) noexcept
+        : m_block{block}
+        , m_value{&block->value}
+    {}
+
+    void release() noexcept
+    {
+        if(m_block && m_block->count.release())
+            delete m_block;
+    }
+
+    block_type* m_block = nullptr;
+    const_pointer m_value;
+};
+
+template <typename T, typename REFCOUNT>
+void swap(cow<T, REFCOUNT>& lhs, cow<T, REFCOUNT>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+/// cow whose copies all stay on one thread, so the reference count does not need atomic operations
+template <typename T>
+using local_cow = cow<T, local_refcount>;
+
+/// Holds the current version of a value that readers take consistent snapshots of while a writer replaces it
+/// load() is lock-free and returns a cow sharing the current version, which stays alive as long as a snapshot of it
+///     exists. Writers are serialized by a mutex and publish a new version with an atomic pointer swap.
+/// Combined with persistent_map or persistent_vector a new version shares everything but the changed path with the
+///     old one.
+/// load() protects the current block with a hazard pointer while it takes a reference, the reference of the
+///     atomic_cow to a replaced version is retired to the global hazard_domain, so that version may be destroyed
+///     later on whichever thread reclaims it
+template <typename T>
+class atomic_cow
+{
+    using block_type = internal::cow_block<T, atomic_refcount>;
+
+public:
+    using value_type = T;
+    using cow_type = cow<T, atomic_refcount>;
+
+    explicit atomic_cow(cow_type value)
+        : m_block{share(std::move(value))}
+    {}
+
+    template <typename ... ARGS>
+    explicit atomic_cow(std::in_place_t, ARGS&& ... args)
+        : atomic_cow{cow_type{std::in_place, std::forward<ARGS>(args)...}}
+    {}
+
+    atomic_cow(const atomic_cow&) = delete;
+    atomic_cow& operator=(const atomic_cow&) = delete;
+
+    ~atomic_cow()
+    {
+        cow_type{m_block.load(std::memory_order_acquire)};
+    }
+
+    /// Snapshot of the current version
+    /// The first hazard_pointer of a thread allocates its record, which may throw std::bad_alloc
+    cow_type load() const
+    {
+        hazard_pointer hazard;
+        block_type* block = hazard.protect(m_block);
+        block->count.retain();
+        return cow_type{block};
+    }
+
+    void store(cow_type value)
+    {
+        exchange(std::move(value));
+    }
+
+    /// Publishes value and returns the previous version
+    cow_type exchange(cow_type value)
+    {
+        block_type* block = share(std::move(value));
+        std::lock_guard<std::mutex> lock{m_writer};
+        return publish(block);
+    }
+
+    /// Publishes func(current version), func has to return a T or a cow of it and must not access this atomic_cow
+    template <typename FUNC>
+    cow_type update(FUNC&& func)
+    {
+        std::lock_guard<std::mutex> lock{m_writer};
+        cow_type next{std::invoke(std::forward<FUNC>(func), load().ref())};
+        publish(share(cow_type{next}));
+        return next;
+    }
+
 private:
-    std::variant<const_pointer, value_type> m_data;
+    /// Reference to an owned block of value, a borrowed value is copied first
+    static block_type* share(cow_type&& value)
+    {
+        if(value.is_borrowed())
+            value = cow_type{std::in_place, value.ref()};
+        value.m_value = nullptr;
+        return std::exchange(value.m_block, nullptr);
+    }
+
+    /// Readers may still be about to take a reference to the previous block, so the reference of the atomic_cow is
+    ///     only dropped once no hazard pointer protects it
+    /// block is published even if retiring throws, the reference to the previous block is leaked then rather than
+    ///     dropped while readers may still take one
+    cow_type publish(block_type* block)
+    {
+        block_type* previous = m_block.exchange(block, std::memory_order_acq_rel);
+        previous->count.retain();
+        cow_type result{previous};
+        hazard_domain::global().retire(previous, [](void* ptr) { cow_type{static_cast<block_type*>(ptr)}; });
+        return result;
+    }
+
+    std::atomic<block_type*> m_block;
+    std::mutex m_writer;
 };
 
 } // namespace t_ut
@@ -0,0 +1,246 @@
+#ifndef CPP_UTILITY_EBR_HPP
+#define CPP_UTILITY_EBR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "asymmetric_fence.hpp"
+#include "cache_line.hpp"
+#include "record_registry.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Retired objects are labeled with the epoch on the next collection, which also is early enough
+inline constexpr uint64_t ebr_unlabeled = UINT64_MAX;
+
+struct ebr_retired
+{
+    void* object;
+    void (*deleter)(void*);
+    uint64_t epoch;
+};
+
+/// State of one thread in a domain, records are reused by later threads and only freed with the domain
+struct alignas(cache_line_size) ebr_record
+{
+    /// Announced epoch while the thread is inside a guard, 0 otherwise
+    std::atomic<uint64_t> epoch = 0;
+    std::atomic<bool> owned = false;
+    ebr_record* next = nullptr;
+
+    // Only used by the owning thread
+    size_t nesting = 0;
+    std::vector<ebr_retired> retired;
+    size_t collect_at = 64;
+};
+
+inline void free_retired(std::vector<ebr_retired>& retired, uint64_t safe_epoch) noexcept
+{
+    size_t kept = 0;
+    for(auto& r : retired)
+    {
+        if(r.epoch < safe_epoch)
+            r.deleter(r.object);
+        else
+            retired[kept++] = r;
+    }
+    retired.resize(kept);
+}
+
+/// Shared part of an ebr_domain, thread caches keep it alive until their thread is done with it
+class ebr_state : public cached_depot
+{
+public:
+    using record_type = ebr_record;
+
+    ebr_state() = default;
+    ebr_state(const ebr_state&) = delete;
+    ebr_state& operator=(const ebr_state&) = delete;
+
+    ebr_record* acquire_record()
+    {
+        return m_records.acquire();
+    }
+
+    /// Hands the objects the thread could not free yet to the domain and makes the record available again
+    void release_record(ebr_record* record) noexcept
+    {
+        // Orphans are freed by the epoch, so they need theirs before they leave the record
+        if(!record->retired.empty())
+        {
+            asymmetric_fence::heavy();
+            label(*record);
+        }
+        m_records.release(record);
+    }
+
+    void enter(ebr_record& record) noexcept
+    {
+        if(record.nesting++ > 0)
+            return;
+
+        // Announce an epoch that is still current after the announcement became visible, so no scan can miss it
+        uint64_t epoch = m_epoch.load(std::memory_order_relaxed);
+        while(true)
+        {
+            record.epoch.store(epoch, std::memory_order_relaxed);
+            asymmetric_fence::light();
+            const uint64_t current = m_epoch.load(std::memory_order_acquire);
+            if(current == epoch)
+                break;
+            epoch = current;
+        }
+    }
+
+    void leave(ebr_record& record) noexcept
+    {
+        if(--record.nesting == 0)
+            record.epoch.store(0, std::memory_order_release);
+    }
+
+    void retire(ebr_record& record, void* object, void (*deleter)(void*))
+    {
+        record.retired.push_back({object, deleter, ebr_unlabeled});
+        if(record.retired.size() >= record.collect_at)
+        {
+            collect(record);
+            // A guard that is held for long keeps objects alive, do not scan again on every retire until it is gone
+            record.collect_at = std::max(collect_threshold, record.retired.size() * 2);
+        }
+    }
+
+    /// Advances the epoch if every thread inside a guard has seen the current one and frees what is safe to free
+    /// Objects retired in epoch e are unreachable for everyone once the epoch reached e + 2
+    void collect(ebr_record& record) noexcept
+    {
+        // After the fence every guard that starts sees the objects unlinked, so they can not be reached from epochs
+        //     that begin later
+        asymmetric_fence::heavy();
+        try_advance(label(record));
+        const uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        free_retired(record.retired, epoch - 1);
+        m_records.try_free_orphans([&](std::vector<ebr_retired>& orphans) { free_retired(orphans, epoch - 1); });
+    }
+
+    uint64_t epoch() const noexcept
+    {
+        return m_epoch.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t collect_threshold = 64;
+
+    uint64_t label(ebr_record& record) noexcept
+    {
+        const uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+        for(auto& r : record.retired)
+        {
+            if(r.epoch == ebr_unlabeled)
+                r.epoch = epoch;
+        }
+        return epoch;
+    }
+
+    /// Called after a heavy fence, so the announcements of all guards that started before it are visible
+    bool try_advance(uint64_t epoch) noexcept
+    {
+        for(const ebr_record* record = m_records.head(); record; record = record->next)
+        {
+            const uint64_t announced = record->epoch.load(std::memory_order_seq_cst);
+            if(announced != 0 && announced != epoch)
+                return false;
+        }
+        return m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    alignas(cache_line_size) std::atomic<uint64_t> m_epoch = 1;
+    record_registry<ebr_record, ebr_retired> m_records;
+};
+
+} // namespace internal
+
+/// Epoch based memory reclamation for lock-free data structures
+/// Readers access shared objects inside an ebr_guard, writers that unlink an object retire() it instead of deleting
+///     it, and it is deleted once no guard that could still see it is active. Guards are cheap to enter, but a
+///     thread that stays inside one holds back all reclamation of the domain
+class ebr_domain
+{
+public:
+    ebr_domain()
+        : m_state{std::make_shared<internal::ebr_state>()}
+    {}
+
+    ebr_domain(const ebr_domain&) = delete;
+    ebr_domain& operator=(const ebr_domain&) = delete;
+
+    ~ebr_domain()
+    {
+        m_state->close();
+        if(auto* records = internal::thread_records<internal::ebr_state>::local())
+            records->drop(m_state.get());
+    }
+
+    /// Domain shared by the t_ut containers, it is never destroyed so objects can still be retired at exit
+    static ebr_domain& global()
+    {
+        static auto* domain = new ebr_domain;
+        return *domain;
+    }
+
+    /// deleter is called with object once it is safe, retired objects must already be unreachable for new readers
+    void retire(void* object, void (*deleter)(void*))
+    {
+        const internal::scoped_record<internal::ebr_state> record{*m_state, internal::local_record(m_state)};
+        m_state->retire(*record, object, deleter);
+    }
+
+    template <typename T>
+    void retire(T* object)
+    {
+        retire(object, [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+
+    /// Frees what the calling thread retired, as far as the active guards allow
+    void collect()
+    {
+        if(auto* r = internal::local_record(m_state))
+            m_state->collect(*r);
+    }
+
+private:
+    friend class ebr_guard;
+
+    std::shared_ptr<internal::ebr_state> m_state;
+};
+
+/// Keeps the objects of a domain that the thread can reach alive while it exists, guards can be nested
+class ebr_guard
+{
+public:
+    explicit ebr_guard(ebr_domain& domain = ebr_domain::global())
+        : m_record{*domain.m_state, internal::local_record(domain.m_state)}
+    {
+        m_record.state().enter(*m_record);
+    }
+
+    ebr_guard(const ebr_guard&) = delete;
+    ebr_guard& operator=(const ebr_guard&) = delete;
+
+    ~ebr_guard()
+    {
+        m_record.state().leave(*m_record);
+    }
+
+private:
+    internal::scoped_record<internal::ebr_state> m_record;
+};
+
+} // namespace t_ut
+
+#endif
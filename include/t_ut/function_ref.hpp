@@ -1,52 +1,192 @@
 #ifndef CPP_UTILITY_FUNCTION_REF_HPP
 #define CPP_UTILITY_FUNCTION_REF_HPP
 
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace t_ut
 {
 
-/// Wrapper class for generically passing around lambdas or function pointers without
-///     taking ownership.
-///     Approach to implement my own basic version of upcoming std::function_ref
-/// Base function template
-template <typename FUNC>
-class function_ref;
+/// Tag to bind a function_ref to a function or member pointer known at compile time, e.g. nontype<&widget::draw>
+/// The pointer becomes part of the call and takes no storage, like std::nontype
+template <auto FUNC>
+struct nontype_t
+{
+    explicit nontype_t() = default;
+};
 
-/// Specialization
-template <typename RET, typename ... ARGS>
-class function_ref<RET(ARGS...)>
+template <auto FUNC>
+inline constexpr nontype_t<FUNC> nontype{};
+
+namespace internal
 {
+
+/// Parameter type of the type erased call
+/// Small trivially copyable arguments are passed on by value so they stay in registers, everything else is passed
+///     by reference so a by-value parameter is only materialized once when the target is called
+template <typename T>
+using function_ref_param_t =
+    std::conditional_t<std::is_trivially_copyable_v<T> && sizeof(T) <= 2 * sizeof(void*), T, T&&>;
+
+template <bool CONST, bool NOEXCEPT, typename RET, typename ... ARGS>
+class function_ref_base
+{
+    template <typename T>
+    using qualified_t = std::conditional_t<CONST, const T, T>;
+
+    template <typename FUNC>
+    static constexpr bool invocable = NOEXCEPT ? std::is_nothrow_invocable_r_v<RET, FUNC, ARGS...>
+                                               : std::is_invocable_r_v<RET, FUNC, ARGS...>;
+
+    template <typename FUNC>
+    static constexpr bool is_function_pointer =
+        std::is_pointer_v<std::decay_t<FUNC>> && std::is_function_v<std::remove_pointer_t<std::decay_t<FUNC>>>;
+
+    /// Function and member pointers are stored by value, they are usually passed as temporaries
+    template <typename FUNC>
+    static constexpr bool is_pointer = is_function_pointer<FUNC> || std::is_member_pointer_v<std::decay_t<FUNC>>;
+
 public:
     using return_type = RET;
 
-    template<typename FUNC>
-    function_ref(FUNC&& func)
-        : m_repr{reinterpret_cast<void*>(std::addressof(func))}
+    template <typename FUNC,
+        typename = std::enable_if_t<!std::is_base_of_v<function_ref_base, std::remove_cv_t<std::remove_reference_t<FUNC>>>
+            && (is_pointer<FUNC> ? invocable<std::decay_t<FUNC>>
+                                 : invocable<qualified_t<std::remove_reference_t<FUNC>>&>)>>
+    function_ref_base(FUNC&& func) noexcept
     {
-        m_callback = +[](void* repr, ARGS&& ... args) -> return_type {
-            return std::invoke(
-                *reinterpret_cast<typename std::add_pointer<FUNC>::type>(repr),
-                static_cast<ARGS&&>(args)...
-            );
-        };
+        if constexpr(is_function_pointer<FUNC>)
+        {
+            // Store the function pointer itself and not the address of the (possibly temporary) pointer object
+            m_storage.function = reinterpret_cast<void (*)()>(static_cast<std::decay_t<FUNC>>(func));
+            m_callback = &call_function<std::decay_t<FUNC>>;
+        }
+        else if constexpr(std::is_member_pointer_v<std::decay_t<FUNC>>)
+        {
+            // Growing the storage for them would slow down every call through a function_ref
+            using member_type = std::decay_t<FUNC>;
+            static_assert(sizeof(member_type) <= sizeof(storage),
+                "member function pointers do not fit into a function_ref, bind them with nontype<&T::member>");
+            const member_type member = func;
+            std::memcpy(&m_storage, &member, sizeof(member_type));
+            m_callback = &call_member<member_type>;
+        }
+        else
+        {
+            m_storage.object = static_cast<const void*>(std::addressof(func));
+            m_callback = &call_object<qualified_t<std::remove_reference_t<FUNC>>>;
+        }
     }
 
-    return_type operator()(ARGS ... args) const
+    template <auto FUNC, typename = std::enable_if_t<invocable<decltype(FUNC)>>>
+    function_ref_base(nontype_t<FUNC>) noexcept
+        : m_storage{nullptr}
+        , m_callback{&call_constant<FUNC>}
+    {}
+
+    return_type operator()(ARGS ... args) const noexcept(NOEXCEPT)
     {
-        return m_callback(m_repr, static_cast<ARGS&&>(args)...);
+        return m_callback(m_storage, std::forward<ARGS>(args)...);
     }
 
 private:
-    void* m_repr;
-    return_type (*m_callback)(void*, ARGS&& ...);
+    union storage
+    {
+        const void* object;
+        void (*function)();
+    };
+
+    template <typename FUNC>
+    static return_type call_object(storage repr, function_ref_param_t<ARGS> ... args) noexcept(NOEXCEPT)
+    {
+        FUNC& func = *const_cast<FUNC*>(static_cast<const FUNC*>(repr.object));
+        if constexpr(std::is_void_v<return_type>)
+            std::invoke(func, std::forward<ARGS>(args)...);
+        else
+            return std::invoke(func, std::forward<ARGS>(args)...);
+    }
+
+    template <typename FUNC>
+    static return_type call_function(storage repr, function_ref_param_t<ARGS> ... args) noexcept(NOEXCEPT)
+    {
+        if constexpr(std::is_void_v<return_type>)
+            reinterpret_cast<FUNC>(repr.function)(std::forward<ARGS>(args)...);
+        else
+            return reinterpret_cast<FUNC>(repr.function)(std::forward<ARGS>(args)...);
+    }
+
+    template <typename MEMBER>
+    static return_type call_member(storage repr, function_ref_param_t<ARGS> ... args) noexcept(NOEXCEPT)
+    {
+        MEMBER member;
+        std::memcpy(&member, &repr, sizeof(MEMBER));
+        if constexpr(std::is_void_v<return_type>)
+            std::invoke(member, std::forward<ARGS>(args)...);
+        else
+            return std::invoke(member, std::forward<ARGS>(args)...);
+    }
+
+    template <auto FUNC>
+    static return_type call_constant(storage, function_ref_param_t<ARGS> ... args) noexcept(NOEXCEPT)
+    {
+        if constexpr(std::is_void_v<return_type>)
+            std::invoke(FUNC, std::forward<ARGS>(args)...);
+        else
+            return std::invoke(FUNC, std::forward<ARGS>(args)...);
+    }
+
+    storage m_storage;
+    return_type (*m_callback)(storage, function_ref_param_t<ARGS> ...) noexcept(NOEXCEPT);
+};
+
+} // namespace internal
+
+/// Wrapper class for generically passing around lambdas or function pointers without
+///     taking ownership.
+///     Approach to implement my own basic version of upcoming std::function_ref
+/// Function pointers and data member pointers are stored by value and called directly, member function pointers are
+///     too large and have to be bound with nontype<&T::member>, callable objects are referenced and must outlive the
+///     function_ref
+/// Base function template
+template <typename FUNC>
+class function_ref;
+
+/// Specializations for plain, const and noexcept qualified signatures
+/// A const signature invokes the referenced callable as const
+template <typename RET, typename ... ARGS>
+class function_ref<RET(ARGS...)> : public internal::function_ref_base<false, false, RET, ARGS...>
+{
+    using internal::function_ref_base<false, false, RET, ARGS...>::function_ref_base;
 };
 
-/// Template deduction guide
+template <typename RET, typename ... ARGS>
+class function_ref<RET(ARGS...) const> : public internal::function_ref_base<true, false, RET, ARGS...>
+{
+    using internal::function_ref_base<true, false, RET, ARGS...>::function_ref_base;
+};
+
+template <typename RET, typename ... ARGS>
+class function_ref<RET(ARGS...) noexcept> : public internal::function_ref_base<false, true, RET, ARGS...>
+{
+    using internal::function_ref_base<false, true, RET, ARGS...>::function_ref_base;
+};
+
+template <typename RET, typename ... ARGS>
+class function_ref<RET(ARGS...) const noexcept> : public internal::function_ref_base<true, true, RET, ARGS...>
+{
+    using internal::function_ref_base<true, true, RET, ARGS...>::function_ref_base;
+};
+
+/// Template deduction guides
 template <typename RET, typename ... ARGS>
 function_ref(RET (*)(ARGS...)) -> function_ref<RET(ARGS...)>;
 
+template <typename RET, typename ... ARGS>
+function_ref(RET (*)(ARGS...) noexcept) -> function_ref<RET(ARGS...) noexcept>;
+
 } // namespace t_ut
 
 #endif
@@ -0,0 +1,234 @@
+#ifndef CPP_UTILITY_HAZARD_POINTER_HPP
+#define CPP_UTILITY_HAZARD_POINTER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "asymmetric_fence.hpp"
+#include "cache_line.hpp"
+#include "record_registry.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Hazard pointers a thread can hold at the same time before further ones need a record of their own
+inline constexpr size_t hazard_slots = 8;
+
+struct hazard_retired
+{
+    void* object;
+    void (*deleter)(void*);
+};
+
+/// Hazard pointers of one thread in a domain, records are reused by later threads and only freed with the domain
+struct alignas(cache_line_size) hazard_record
+{
+    std::atomic<const void*> slots[hazard_slots] = {};
+    std::atomic<bool> owned = false;
+    hazard_record* next = nullptr;
+
+    // Only used by the owning thread
+    /// Bit i is set while slot i belongs to a hazard_pointer
+    uint32_t used = 0;
+    std::vector<hazard_retired> retired;
+};
+
+/// Shared part of a hazard_domain, thread caches keep it alive until their thread is done with it
+class hazard_state : public cached_depot
+{
+public:
+    using record_type = hazard_record;
+
+    hazard_state() = default;
+    hazard_state(const hazard_state&) = delete;
+    hazard_state& operator=(const hazard_state&) = delete;
+
+    hazard_record* acquire_record()
+    {
+        return m_records.acquire();
+    }
+
+    /// Hands the objects the thread could not free yet to the domain and makes the record available again
+    void release_record(hazard_record* record) noexcept
+    {
+        m_records.release(record);
+    }
+
+    void retire(hazard_record& record, void* object, void (*deleter)(void*))
+    {
+        record.retired.push_back({object, deleter});
+        // At most one object per slot survives a scan, so scanning at twice the slot count keeps the garbage of a
+        //     thread bounded while every scan frees at least half of it
+        const size_t threshold = std::max(collect_threshold,
+            2 * hazard_slots * m_records.size());
+        if(record.retired.size() >= threshold)
+            scan(record);
+    }
+
+    /// Frees every retired object of record that no hazard pointer protects
+    void scan(hazard_record& record)
+    {
+        // After the fence every protect() that starts sees the objects unlinked and fails its validation, while the
+        //     slots of those that already succeeded are visible below
+        asymmetric_fence::heavy();
+        std::vector<const void*> hazards;
+        for(const hazard_record* r = m_records.head(); r; r = r->next)
+        {
+            for(const auto& slot : r->slots)
+            {
+                if(const void* ptr = slot.load(std::memory_order_acquire))
+                    hazards.push_back(ptr);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        free_unprotected(record.retired, hazards);
+        m_records.try_free_orphans([&](std::vector<hazard_retired>& orphans) { free_unprotected(orphans, hazards); });
+    }
+
+private:
+    static constexpr size_t collect_threshold = 64;
+
+    static void free_unprotected(std::vector<hazard_retired>& retired, const std::vector<const void*>& hazards) noexcept
+    {
+        size_t kept = 0;
+        for(auto& r : retired)
+        {
+            if(std::binary_search(hazards.begin(), hazards.end(), static_cast<const void*>(r.object)))
+                retired[kept++] = r;
+            else
+                r.deleter(r.object);
+        }
+        retired.resize(kept);
+    }
+
+    record_registry<hazard_record, hazard_retired> m_records;
+};
+
+} // namespace internal
+
+/// Hazard pointer based memory reclamation for lock-free data structures
+/// A reader publishes the pointer it is about to use in a hazard_pointer, writers that unlink an object retire() it
+///     and it is deleted once no hazard pointer holds it. Unlike an ebr_domain, a reader that stalls only keeps the
+///     objects it protects alive, so the retired but not yet deleted objects of a thread stay bounded by twice the
+///     number of hazard pointers. Protecting a pointer costs a little more than entering an ebr_guard.
+class hazard_domain
+{
+public:
+    hazard_domain()
+        : m_state{std::make_shared<internal::hazard_state>()}
+    {}
+
+    hazard_domain(const hazard_domain&) = delete;
+    hazard_domain& operator=(const hazard_domain&) = delete;
+
+    ~hazard_domain()
+    {
+        m_state->close();
+        if(auto* records = internal::thread_records<internal::hazard_state>::local())
+            records->drop(m_state.get());
+    }
+
+    /// Domain shared by the t_ut containers, it is never destroyed so objects can still be retired at exit
+    static hazard_domain& global()
+    {
+        static auto* domain = new hazard_domain;
+        return *domain;
+    }
+
+    /// deleter is called with object once it is safe, retired objects must already be unreachable for new readers
+    void retire(void* object, void (*deleter)(void*))
+    {
+        const internal::scoped_record<internal::hazard_state> record{*m_state, internal::local_record(m_state)};
+        m_state->retire(*record, object, deleter);
+    }
+
+    template <typename T>
+    void retire(T* object)
+    {
+        retire(object, [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+
+    /// Frees what the calling thread retired and no hazard pointer protects
+    void collect()
+    {
+        if(auto* r = internal::local_record(m_state))
+            m_state->scan(*r);
+    }
+
+private:
+    friend class hazard_pointer;
+
+    std::shared_ptr<internal::hazard_state> m_state;
+};
+
+/// Protects one object of a domain from being deleted while it exists
+class hazard_pointer
+{
+public:
+    explicit hazard_pointer(hazard_domain& domain = hazard_domain::global())
+        : m_record{*domain.m_state, available(internal::local_record(domain.m_state))}
+        , m_index{static_cast<uint32_t>(std::countr_one(m_record->used))}
+    {
+        m_record->used |= uint32_t{1} << m_index;
+    }
+
+    hazard_pointer(const hazard_pointer&) = delete;
+    hazard_pointer& operator=(const hazard_pointer&) = delete;
+
+    ~hazard_pointer()
+    {
+        slot().store(nullptr, std::memory_order_release);
+        m_record->used &= ~(uint32_t{1} << m_index);
+    }
+
+    /// Loads src and protects the object it points to, which stays alive until the protection is reset, even if it
+    ///     is unlinked from src meanwhile
+    template <typename T>
+    T* protect(const std::atomic<T*>& src) noexcept
+    {
+        T* ptr = src.load(std::memory_order_relaxed);
+        while(true)
+        {
+            slot().store(ptr, std::memory_order_relaxed);
+            internal::asymmetric_fence::light();
+            T* current = src.load(std::memory_order_acquire);
+            if(current == ptr)
+                return ptr;
+            ptr = current;
+        }
+    }
+
+    /// Protects ptr, which has to be protected by other means already, or drops the protection
+    void reset_protection(const void* ptr = nullptr) noexcept
+    {
+        slot().store(ptr, std::memory_order_release);
+    }
+
+private:
+    static constexpr uint32_t full = (uint32_t{1} << internal::hazard_slots) - 1;
+
+    /// Threads that hold all slots of their record borrow another one, like those whose caches are gone
+    static internal::hazard_record* available(internal::hazard_record* record) noexcept
+    {
+        return record && record->used != full ? record : nullptr;
+    }
+
+    std::atomic<const void*>& slot() noexcept
+    {
+        return m_record->slots[m_index];
+    }
+
+    internal::scoped_record<internal::hazard_state> m_record;
+    uint32_t m_index;
+};
+
+} // namespace t_ut
+
+#endif
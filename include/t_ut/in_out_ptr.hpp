@@ -1,64 +1,33 @@
 #ifndef CPP_UTILITY_IN_OUT_PTR_HPP
 #define CPP_UTILITY_IN_OUT_PTR_HPP
 
+#include <utility>
+
+#include "out_ptr.hpp"
+
 namespace t_ut {
 
-// TODO Currently only working with unique_ptr, so make it work with shared_ptr
-// Problem is, that shared_ptr's release function takes the deleter as a parameter
-template <typename SMART, typename POINTER>
-class in_out_ptr
+/// Passes a smart pointer to a C function that takes an object through a POINTER* parameter and may replace it, e.g.
+///     realloc style functions: resize_handle(t_ut::in_out_ptr{handle}, size)
+/// The smart pointer gives up ownership to the function and takes over the pointer it leaves behind at the end of the
+///     full expression, if the function frees the object and writes a null pointer the smart pointer stays empty
+/// ARGS are passed on to reset, e.g. adopt_ref for an intrusive_ptr, whose reference the function takes over
+/// A shared_ptr cannot give up ownership, so it does not work with in_out_ptr
+template <typename SMART, typename POINTER, typename ... ARGS>
+class in_out_ptr : public internal::out_ptr_base<SMART, POINTER, ARGS...>
 {
-public:
-    using smart_ptr_type = SMART;
-    using ptr_type = POINTER;
+    static_assert(!internal::is_shared_ptr<SMART>::value, "a shared_ptr cannot release its object");
 
-    in_out_ptr(smart_ptr_type& smart_ptr)
-        : m_smart{&smart_ptr},
-          m_ptr{smart_ptr.release()}
+public:
+    explicit in_out_ptr(SMART& smart, ARGS ... args)
+        : internal::out_ptr_base<SMART, POINTER, ARGS...>{smart,
+            static_cast<POINTER>(out_ptr_traits<SMART>::release(smart)), std::move(args)...}
     {}
-
-    in_out_ptr(const in_out_ptr&) = delete;
-    in_out_ptr& operator=(const in_out_ptr&) = delete;
-
-    in_out_ptr(in_out_ptr&& rhs) noexcept
-        : m_smart{rhs.m_smart},
-          m_ptr{rhs.m_ptr}
-    {
-        rhs.m_smart = nullptr;
-    }
-
-    in_out_ptr& operator=(in_out_ptr&& rhs) noexcept
-    {
-        m_smart = rhs.m_smart;
-        m_ptr = rhs.m_ptr;
-
-        rhs.m_smart = nullptr;
-    }
-
-    ~in_out_ptr() noexcept
-    {
-        m_smart->reset(m_ptr);
-    }
-
-    operator ptr_type*() noexcept
-    {
-        return &m_ptr;
-    }
-
-    operator void**() noexcept
-    {
-        return reinterpret_cast<void**>(&m_ptr);
-    }
-
-private:
-    smart_ptr_type* m_smart;
-    ptr_type m_ptr;
 };
 
-/// Deduction guide for in_out_ptr type from a smart pointer
-template <typename SMART>
-in_out_ptr(SMART& smart) ->
-    in_out_ptr<typename std::remove_reference<decltype(smart)>::type, decltype(smart.get())>;
+/// Deduction guide for in_out_ptr type from a smart pointer and the arguments for its reset
+template <typename SMART, typename ... ARGS>
+in_out_ptr(SMART& smart, ARGS ... args) -> in_out_ptr<SMART, typename out_ptr_traits<SMART>::pointer, ARGS ...>;
 
 } // namespace t_ut
 
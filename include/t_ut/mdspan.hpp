@@ -0,0 +1,289 @@
+#ifndef CPP_UTILITY_MDSPAN_HPP
+#define CPP_UTILITY_MDSPAN_HPP
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+#include "span.hpp"
+
+namespace t_ut
+{
+
+/// Layout policies that map a multidimensional index to an offset into the underlying buffer
+/// Each policy provides a mapping<RANK> with extent(r), stride(r), size(), required_span_size() and operator()
+///     taking RANK indices
+
+/// Row major layout, the last index is contiguous
+struct layout_right
+{
+    template <size_t RANK>
+    class mapping;
+};
+
+/// Column major layout, the first index is contiguous
+struct layout_left
+{
+    template <size_t RANK>
+    class mapping;
+};
+
+/// Arbitrary stride per dimension, e.g. a tile of a bigger image
+struct layout_stride
+{
+    template <size_t RANK>
+    class mapping;
+};
+
+namespace internal
+{
+
+template <size_t RANK>
+constexpr size_t extents_product(const std::array<size_t, RANK>& extents, size_t first, size_t last)
+{
+    size_t product = 1;
+    for(size_t r = first; r < last; ++r)
+        product *= extents[r];
+    return product;
+}
+
+} // namespace internal
+
+template <size_t RANK>
+class layout_right::mapping
+{
+public:
+    using extents_type = std::array<size_t, RANK>;
+
+    constexpr explicit mapping(const extents_type& extents) noexcept
+        : m_extents{extents}
+    {}
+
+    constexpr const extents_type& extents() const { return m_extents; }
+    constexpr size_t extent(size_t r) const { return m_extents[r]; }
+    constexpr size_t stride(size_t r) const { return internal::extents_product(m_extents, r + 1, RANK); }
+    constexpr size_t size() const { return internal::extents_product(m_extents, 0, RANK); }
+    constexpr size_t required_span_size() const { return size(); }
+
+    static constexpr bool is_contiguous() { return true; }
+
+    template <std::convertible_to<size_t> ... INDICES>
+        requires (sizeof...(INDICES) == RANK)
+    constexpr size_t operator()(INDICES ... indices) const
+    {
+        size_t offset = 0;
+        size_t r = 0;
+        ((offset = offset * m_extents[r++] + static_cast<size_t>(indices)), ...);
+        return offset;
+    }
+
+private:
+    extents_type m_extents;
+};
+
+template <size_t RANK>
+class layout_left::mapping
+{
+public:
+    using extents_type = std::array<size_t, RANK>;
+
+    constexpr explicit mapping(const extents_type& extents) noexcept
+        : m_extents{extents}
+    {}
+
+    constexpr const extents_type& extents() const { return m_extents; }
+    constexpr size_t extent(size_t r) const { return m_extents[r]; }
+    constexpr size_t stride(size_t r) const { return internal::extents_product(m_extents, 0, r); }
+    constexpr size_t size() const { return internal::extents_product(m_extents, 0, RANK); }
+    constexpr size_t required_span_size() const { return size(); }
+
+    static constexpr bool is_contiguous() { return true; }
+
+    template <std::convertible_to<size_t> ... INDICES>
+        requires (sizeof...(INDICES) == RANK)
+    constexpr size_t operator()(INDICES ... indices) const
+    {
+        const size_t index_array[] = {static_cast<size_t>(indices)...};
+        size_t offset = 0;
+        for(size_t r = RANK; r > 0; --r)
+            offset = offset * m_extents[r - 1] + index_array[r - 1];
+        return offset;
+    }
+
+private:
+    extents_type m_extents;
+};
+
+template <size_t RANK>
+class layout_stride::mapping
+{
+public:
+    using extents_type = std::array<size_t, RANK>;
+    using strides_type = std::array<size_t, RANK>;
+
+    constexpr mapping(const extents_type& extents, const strides_type& strides) noexcept
+        : m_extents{extents}
+        , m_strides{strides}
+    {}
+
+    /// Any other mapping can be expressed with explicit strides
+    template <typename MAPPING>
+        requires (!std::is_same_v<MAPPING, mapping>) && std::is_same_v<typename MAPPING::extents_type, extents_type>
+    constexpr mapping(const MAPPING& other) noexcept
+        : m_extents{other.extents()}
+    {
+        for(size_t r = 0; r < RANK; ++r)
+            m_strides[r] = other.stride(r);
+    }
+
+    constexpr const extents_type& extents() const { return m_extents; }
+    constexpr const strides_type& strides() const { return m_strides; }
+    constexpr size_t extent(size_t r) const { return m_extents[r]; }
+    constexpr size_t stride(size_t r) const { return m_strides[r]; }
+    constexpr size_t size() const { return internal::extents_product(m_extents, 0, RANK); }
+
+    constexpr size_t required_span_size() const
+    {
+        size_t last = 0;
+        for(size_t r = 0; r < RANK; ++r)
+        {
+            if(m_extents[r] == 0)
+                return 0;
+            last += (m_extents[r] - 1) * m_strides[r];
+        }
+        return last + 1;
+    }
+
+    constexpr bool is_contiguous() const { return required_span_size() == size(); }
+
+    template <std::convertible_to<size_t> ... INDICES>
+        requires (sizeof...(INDICES) == RANK)
+    constexpr size_t operator()(INDICES ... indices) const
+    {
+        size_t offset = 0;
+        size_t r = 0;
+        ((offset += static_cast<size_t>(indices) * m_strides[r++]), ...);
+        return offset;
+    }
+
+private:
+    extents_type m_extents;
+    strides_type m_strides;
+};
+
+/// Non-owning multidimensional view over an existing buffer, inspired by std::mdspan
+/// The extents are runtime values, LAYOUT decides how indices are mapped to the buffer
+/// Elements are accessed with view(i, j, ...), rows and columns of 2-D views are returned as (strided) spans and
+///     subview() cuts out a tile without copying
+template <typename T, size_t RANK, typename LAYOUT = layout_right>
+class mdspan
+{
+    static_assert(RANK > 0, "mdspan needs at least one dimension");
+
+public:
+    using value_type = T;
+    using reference = value_type&;
+    using pointer = value_type*;
+    using layout_type = LAYOUT;
+    using mapping_type = typename LAYOUT::template mapping<RANK>;
+    using extents_type = std::array<size_t, RANK>;
+
+    constexpr mdspan(pointer data, const mapping_type& mapping) noexcept
+        : m_data{data}
+        , m_mapping{mapping}
+    {}
+
+    template <std::convertible_to<size_t> ... SIZES>
+        requires (sizeof...(SIZES) == RANK) && std::is_constructible_v<mapping_type, const extents_type&>
+    constexpr mdspan(pointer data, SIZES ... extents) noexcept
+        : m_data{data}
+        , m_mapping{extents_type{static_cast<size_t>(extents)...}}
+    {}
+
+    template <size_t EXTENT, std::convertible_to<size_t> ... SIZES>
+        requires (sizeof...(SIZES) == RANK) && std::is_constructible_v<mapping_type, const extents_type&>
+    constexpr mdspan(span<T, EXTENT> buffer, SIZES ... extents) noexcept
+        : mdspan{buffer.data(), extents...}
+    {}
+
+    /// Views of non-const elements convert to views of const elements and every layout converts to layout_stride
+    template <typename U, typename OTHER_LAYOUT>
+        requires std::is_convertible_v<U(*)[], T(*)[]>
+            && std::is_constructible_v<mapping_type, const typename OTHER_LAYOUT::template mapping<RANK>&>
+    constexpr mdspan(const mdspan<U, RANK, OTHER_LAYOUT>& other) noexcept
+        : m_data{other.data()}
+        , m_mapping{other.mapping()}
+    {}
+
+    static constexpr size_t rank() { return RANK; }
+
+    constexpr pointer data() const { return m_data; }
+    constexpr const mapping_type& mapping() const { return m_mapping; }
+    constexpr size_t extent(size_t r) const { return m_mapping.extent(r); }
+    constexpr size_t stride(size_t r) const { return m_mapping.stride(r); }
+    constexpr size_t size() const { return m_mapping.size(); }
+    constexpr bool empty() const { return size() == 0; }
+
+    template <std::convertible_to<size_t> ... INDICES>
+        requires (sizeof...(INDICES) == RANK)
+    constexpr reference operator()(INDICES ... indices) const
+    {
+        return m_data[m_mapping(indices...)];
+    }
+
+    /// Row i of a 2-D view, contiguous for layout_right
+    constexpr strided_span<T> row(size_t i) const requires (RANK == 2)
+    {
+        return {m_data + i * stride(0), extent(1), static_cast<std::ptrdiff_t>(stride(1))};
+    }
+
+    /// Column j of a 2-D view, contiguous for layout_left
+    constexpr strided_span<T> column(size_t j) const requires (RANK == 2)
+    {
+        return {m_data + j * stride(1), extent(0), static_cast<std::ptrdiff_t>(stride(0))};
+    }
+
+    /// All elements of a contiguous view as a flat span
+    constexpr span<T> flat() const requires (!std::is_same_v<LAYOUT, layout_stride>)
+    {
+        return {m_data, size()};
+    }
+
+    /// View of the block starting at offsets with the given extents, which has to lie within this view
+    constexpr mdspan<T, RANK, layout_stride> subview(const extents_type& offsets, const extents_type& extents) const
+    {
+        std::array<size_t, RANK> strides;
+        size_t offset = 0;
+        for(size_t r = 0; r < RANK; ++r)
+        {
+            strides[r] = stride(r);
+            offset += offsets[r] * strides[r];
+        }
+        return {m_data + offset, layout_stride::mapping<RANK>{extents, strides}};
+    }
+
+private:
+    pointer m_data;
+    mapping_type m_mapping;
+};
+
+/// Template deduction guides for class mdspan
+template <typename T, std::convertible_to<size_t> ... SIZES>
+mdspan(T*, SIZES...) -> mdspan<T, sizeof...(SIZES)>;
+
+template <typename T, size_t EXTENT, std::convertible_to<size_t> ... SIZES>
+mdspan(span<T, EXTENT>, SIZES...) -> mdspan<T, sizeof...(SIZES)>;
+
+template <typename T, size_t RANK>
+mdspan(T*, const layout_right::mapping<RANK>&) -> mdspan<T, RANK, layout_right>;
+
+template <typename T, size_t RANK>
+mdspan(T*, const layout_left::mapping<RANK>&) -> mdspan<T, RANK, layout_left>;
+
+template <typename T, size_t RANK>
+mdspan(T*, const layout_stride::mapping<RANK>&) -> mdspan<T, RANK, layout_stride>;
+
+} // namespace t_ut
+
+#endif
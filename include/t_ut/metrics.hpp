@@ -0,0 +1,458 @@
+#ifndef CPP_UTILITY_METRICS_HPP
+#define CPP_UTILITY_METRICS_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include "cache_line.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Shards of a sharded metric, a power of two so that every core has its own one in the common case
+inline size_t metric_shard_count() noexcept
+{
+    static const size_t count = std::bit_ceil(std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 64));
+    return count;
+}
+
+/// Threads are spread round robin over the shards when they first update a metric
+inline size_t metric_shard() noexcept
+{
+    static std::atomic<size_t> next = 0;
+    thread_local const size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+struct alignas(cache_line_size) metric_cell
+{
+    std::atomic<uint64_t> value = 0;
+};
+
+/// HDR style log-linear buckets: values below 2^SUB_BUCKET_BITS have their own bucket, larger ones share one with
+///     values that differ by less than 2^-(SUB_BUCKET_BITS-1)
+template <unsigned SUB_BUCKET_BITS>
+struct log_linear_buckets
+{
+    static constexpr unsigned sub_bucket_bits = SUB_BUCKET_BITS;
+    static constexpr uint64_t sub_bucket_count = uint64_t{1} << sub_bucket_bits;
+    static constexpr uint64_t half_count = sub_bucket_count / 2;
+    static constexpr size_t count =
+        sub_bucket_count + (std::numeric_limits<uint64_t>::digits - sub_bucket_bits) * half_count;
+
+    static size_t index_of(uint64_t value) noexcept
+    {
+        if(value < sub_bucket_count)
+            return static_cast<size_t>(value);
+
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - sub_bucket_bits;
+        const uint64_t sub_bucket = value >> shift;
+        return static_cast<size_t>(sub_bucket_count + (shift - 1) * half_count + (sub_bucket - half_count));
+    }
+
+    static uint64_t highest_value_of(size_t index) noexcept
+    {
+        if(index < sub_bucket_count)
+            return index;
+
+        const uint64_t offset = index - sub_bucket_count;
+        const unsigned shift = static_cast<unsigned>(offset / half_count) + 1;
+        const uint64_t sub_bucket = offset % half_count + half_count;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    /// Bucket of the value at the given percentile in [0, 100] of the total values counted in counts
+    template <typename COUNTS>
+    static size_t percentile_index(const COUNTS& counts, uint64_t total, double percent) noexcept
+    {
+        const auto rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total) + 0.5);
+        const uint64_t target = std::clamp<uint64_t>(rank, 1, std::max<uint64_t>(total, 1));
+
+        uint64_t seen = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            seen += counts[i];
+            if(seen >= target)
+                return i;
+        }
+        return count - 1;
+    }
+};
+
+/// Values below 16 have their own bucket, larger ones share one with values that differ by less than 12.5%
+using metric_buckets = log_linear_buckets<4>;
+
+struct histogram_shard
+{
+    std::array<std::atomic<uint64_t>, metric_buckets::count> buckets{};
+    std::atomic<uint64_t> sum = 0;
+};
+
+} // namespace internal
+
+/// Monotonic count of events, every thread adds to its own shard so that threads do not contend on one cache line
+class counter
+{
+public:
+    counter()
+        : m_mask{internal::metric_shard_count() - 1}
+        , m_cells{new internal::metric_cell[m_mask + 1]}
+    {}
+
+    counter(const counter&) = delete;
+    counter& operator=(const counter&) = delete;
+
+    void add(uint64_t n = 1) noexcept
+    {
+        m_cells[internal::metric_shard() & m_mask].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Sum of all shards, additions that happen meanwhile may or may not be included
+    uint64_t value() const noexcept
+    {
+        uint64_t result = 0;
+        for(size_t i = 0; i <= m_mask; ++i)
+            result += m_cells[i].value.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    const size_t m_mask;
+    const std::unique_ptr<internal::metric_cell[]> m_cells;
+};
+
+/// Value that goes up and down, e.g. a queue length
+/// Not sharded, set() needs the one current value, so gauges are for state that changes less often than counters
+class alignas(internal::cache_line_size) gauge
+{
+public:
+    gauge() = default;
+    gauge(const gauge&) = delete;
+    gauge& operator=(const gauge&) = delete;
+
+    void set(int64_t value) noexcept
+    {
+        m_value.store(value, std::memory_order_relaxed);
+    }
+
+    void add(int64_t n = 1) noexcept
+    {
+        m_value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void sub(int64_t n = 1) noexcept
+    {
+        m_value.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    int64_t value() const noexcept
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> m_value = 0;
+};
+
+/// Copy of the buckets of a histogram at one point in time
+class histogram_snapshot
+{
+    using buckets = internal::metric_buckets;
+
+public:
+    static constexpr size_t bucket_count = buckets::count;
+
+    uint64_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    uint64_t sum() const noexcept
+    {
+        return m_sum;
+    }
+
+    uint64_t bucket(size_t index) const noexcept
+    {
+        return m_counts[index];
+    }
+
+    /// Highest value that is counted in the bucket
+    static uint64_t upper_bound(size_t index) noexcept
+    {
+        return buckets::highest_value_of(index);
+    }
+
+    /// Highest value equivalent to the recorded value at the given percentile in [0, 100]
+    uint64_t percentile(double percent) const noexcept
+    {
+        if(m_count == 0)
+            return 0;
+        return upper_bound(buckets::percentile_index(m_counts, m_count, percent));
+    }
+
+private:
+    friend class histogram;
+
+    std::array<uint64_t, bucket_count> m_counts{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+};
+
+/// Lock-free distribution of values, e.g. latencies in nanoseconds, in log-linear buckets
+/// Every thread records into its own shard, which is only allocated once a thread of that shard records a value
+/// Values of any size are recorded, max_value only limits the buckets that are exported, larger values are only
+///     counted in the +Inf bucket there
+class histogram
+{
+    using buckets = internal::metric_buckets;
+
+public:
+    /// About 4.3 seconds for latencies in nanoseconds
+    static constexpr uint64_t default_max_value = (uint64_t{1} << 32) - 1;
+
+    explicit histogram(uint64_t max_value = default_max_value)
+        : m_mask{internal::metric_shard_count() - 1}
+        , m_shards{new std::atomic<internal::histogram_shard*>[m_mask + 1]{}}
+        , m_max_value{max_value}
+    {}
+
+    histogram(const histogram&) = delete;
+    histogram& operator=(const histogram&) = delete;
+
+    ~histogram()
+    {
+        for(size_t i = 0; i <= m_mask; ++i)
+            delete m_shards[i].load(std::memory_order_relaxed);
+    }
+
+    void record(uint64_t value)
+    {
+        internal::histogram_shard& shard = local_shard();
+        shard.buckets[buckets::index_of(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t max_value() const noexcept
+    {
+        return m_max_value;
+    }
+
+    /// Values recorded meanwhile may be missing or counted without their sum
+    histogram_snapshot snapshot() const noexcept
+    {
+        histogram_snapshot result;
+        for(size_t i = 0; i <= m_mask; ++i)
+        {
+            const internal::histogram_shard* shard = m_shards[i].load(std::memory_order_acquire);
+            if(!shard)
+                continue;
+            for(size_t b = 0; b < buckets::count; ++b)
+                result.m_counts[b] += shard->buckets[b].load(std::memory_order_relaxed);
+            result.m_sum += shard->sum.load(std::memory_order_relaxed);
+        }
+        for(uint64_t c : result.m_counts)
+            result.m_count += c;
+        return result;
+    }
+
+private:
+    internal::histogram_shard& local_shard()
+    {
+        auto& slot = m_shards[internal::metric_shard() & m_mask];
+        if(internal::histogram_shard* shard = slot.load(std::memory_order_acquire))
+            return *shard;
+
+        auto fresh = std::make_unique<internal::histogram_shard>();
+        internal::histogram_shard* expected = nullptr;
+        if(slot.compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel))
+            return *fresh.release();
+        return *expected;
+    }
+
+    const size_t m_mask;
+    const std::unique_ptr<std::atomic<internal::histogram_shard*>[]> m_shards;
+    const uint64_t m_max_value;
+};
+
+/// Owns named metrics and writes them in the Prometheus text format
+/// A metric is identified by its name and its labels, given as they appear in the exposition, e.g. pool="io".
+///     Asking for the same name and labels again returns the same metric, which stays valid as long as the registry
+class metrics_registry
+{
+public:
+    metrics_registry() = default;
+    metrics_registry(const metrics_registry&) = delete;
+    metrics_registry& operator=(const metrics_registry&) = delete;
+
+    /// Registry the instrumentation of the t_ut types reports to by default, it is never destroyed
+    static metrics_registry& global()
+    {
+        static auto* registry = new metrics_registry;
+        return *registry;
+    }
+
+    counter& get_counter(std::string_view name, std::string_view help, std::string_view labels = {})
+    {
+        return get<counter>(name, help, labels);
+    }
+
+    gauge& get_gauge(std::string_view name, std::string_view help, std::string_view labels = {})
+    {
+        return get<gauge>(name, help, labels);
+    }
+
+    /// max_value only applies when the histogram is created, see histogram
+    histogram& get_histogram(std::string_view name, std::string_view help, std::string_view labels = {},
+        uint64_t max_value = histogram::default_max_value)
+    {
+        return get<histogram>(name, help, labels, max_value);
+    }
+
+    /// Histograms write coarse buckets that end below the powers of two up to the first one above their max_value,
+    ///     le="0", "1", "3", "7", ..., whether they counted something or not, so the series of a histogram stay few
+    ///     and the same between scrapes. They add up the fine buckets, snapshots keep those for percentiles
+    std::string to_prometheus() const
+    {
+        std::string out;
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        for(const auto& f : m_families)
+        {
+            out.append("# HELP ").append(f.name).append(" ").append(f.help).append("\n");
+            out.append("# TYPE ").append(f.name).append(" ").append(type_name(f.metrics.front().metric)).append("\n");
+            for(const auto& s : f.metrics)
+                std::visit([&](const auto& metric) { write(out, f.name, s.labels, *metric); }, s.metric);
+        }
+        return out;
+    }
+
+private:
+    using metric_ptr = std::variant<std::unique_ptr<counter>, std::unique_ptr<gauge>, std::unique_ptr<histogram>>;
+
+    struct series
+    {
+        std::string labels;
+        metric_ptr metric;
+    };
+
+    struct family
+    {
+        std::string name;
+        std::string help;
+        std::vector<series> metrics;
+    };
+
+    template <typename METRIC, typename ... ARGS>
+    METRIC& get(std::string_view name, std::string_view help, std::string_view labels, ARGS ... args)
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        auto f = std::find_if(m_families.begin(), m_families.end(), [&](const family& e) { return e.name == name; });
+        if(f == m_families.end())
+            f = m_families.insert(m_families.end(), family{std::string{name}, std::string{help}, {}});
+        else if(!std::holds_alternative<std::unique_ptr<METRIC>>(f->metrics.front().metric))
+            throw std::invalid_argument{"metric registered with another type"};
+
+        for(auto& s : f->metrics)
+        {
+            if(s.labels == labels)
+                return *std::get<std::unique_ptr<METRIC>>(s.metric);
+        }
+        auto& s = f->metrics.emplace_back(series{std::string{labels}, std::make_unique<METRIC>(args ...)});
+        return *std::get<std::unique_ptr<METRIC>>(s.metric);
+    }
+
+    static const char* type_name(const metric_ptr& metric) noexcept
+    {
+        constexpr const char* names[] = {"counter", "gauge", "histogram"};
+        return names[metric.index()];
+    }
+
+    template <typename T>
+    static void append_number(std::string& out, T value)
+    {
+        char buffer[24];
+        const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    static void append_sample(std::string& out, std::string_view name, std::string_view suffix,
+        std::string_view labels, std::string_view extra_label = {})
+    {
+        out.append(name).append(suffix);
+        if(!labels.empty() || !extra_label.empty())
+        {
+            out.append("{").append(labels);
+            if(!labels.empty() && !extra_label.empty())
+                out.append(",");
+            out.append(extra_label).append("}");
+        }
+        out.append(" ");
+    }
+
+    static void write(std::string& out, std::string_view name, std::string_view labels, const counter& metric)
+    {
+        append_sample(out, name, {}, labels);
+        append_number(out, metric.value());
+        out.append("\n");
+    }
+
+    static void write(std::string& out, std::string_view name, std::string_view labels, const gauge& metric)
+    {
+        append_sample(out, name, {}, labels);
+        append_number(out, metric.value());
+        out.append("\n");
+    }
+
+    static void write(std::string& out, std::string_view name, std::string_view labels, const histogram& metric)
+    {
+        const histogram_snapshot snapshot = metric.snapshot();
+        const auto bound_count = static_cast<unsigned>(std::bit_width(metric.max_value())) + 1;
+        uint64_t cumulative = 0;
+        size_t next = 0;
+        std::string le;
+        for(unsigned k = 0; k < bound_count; ++k)
+        {
+            // 2^k - 1 is always the highest value of a fine bucket
+            const uint64_t bound = k < 64 ? (uint64_t{1} << k) - 1 : std::numeric_limits<uint64_t>::max();
+            for(const size_t last = internal::metric_buckets::index_of(bound); next <= last; ++next)
+                cumulative += snapshot.bucket(next);
+            le.assign("le=\"");
+            append_number(le, bound);
+            le.append("\"");
+            append_sample(out, name, "_bucket", labels, le);
+            append_number(out, cumulative);
+            out.append("\n");
+        }
+        append_sample(out, name, "_bucket", labels, "le=\"+Inf\"");
+        append_number(out, snapshot.count());
+        out.append("\n");
+        append_sample(out, name, "_sum", labels);
+        append_number(out, snapshot.sum());
+        out.append("\n");
+        append_sample(out, name, "_count", labels);
+        append_number(out, snapshot.count());
+        out.append("\n");
+    }
+
+    mutable std::mutex m_mutex;
+    std::vector<family> m_families;
+};
+
+} // namespace t_ut
+
+#endif
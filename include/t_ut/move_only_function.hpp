@@ -0,0 +1,208 @@
+#ifndef CPP_UTILITY_MOVE_ONLY_FUNCTION_HPP
+#define CPP_UTILITY_MOVE_ONLY_FUNCTION_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace t_ut
+{
+
+/// Types that can be moved to a new address with memcpy without running their move constructor and destructor
+/// Defaults to trivially copyable types, specialize it for types known to be relocatable like a lambda
+///     capturing a std::unique_ptr
+template <typename T>
+struct is_trivially_relocatable
+    : std::bool_constant<std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>>
+{};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/// Base function template
+template <typename SIGNATURE, size_t INLINE_SIZE = 64>
+class move_only_function;
+
+/// Owning and move-only replacement for std::function
+/// Callables that fit into INLINE_SIZE bytes are stored in place, bigger ones on the heap
+/// Moving a trivially relocatable or heap stored callable is a plain memcpy of the buffer
+template <typename RET, typename ... ARGS, size_t INLINE_SIZE>
+class move_only_function<RET(ARGS...), INLINE_SIZE>
+{
+    static_assert(INLINE_SIZE >= sizeof(void*), "move_only_function needs room for at least one pointer");
+
+public:
+    using result_type = RET;
+
+    move_only_function() noexcept = default;
+
+    move_only_function(std::nullptr_t) noexcept
+    {}
+
+    template <typename FUNC,
+        typename = std::enable_if_t<!std::is_same_v<std::decay_t<FUNC>, move_only_function>
+            && std::is_invocable_r_v<RET, std::decay_t<FUNC>&, ARGS...>>>
+    move_only_function(FUNC&& func)
+    {
+        using func_type = std::decay_t<FUNC>;
+
+        if constexpr(std::is_pointer_v<func_type> || std::is_member_pointer_v<func_type>)
+        {
+            if(func == nullptr)
+                return;
+        }
+
+        if constexpr(stored_inline<func_type>())
+            ::new(static_cast<void*>(m_storage)) func_type(std::forward<FUNC>(func));
+        else
+            ::new(static_cast<void*>(m_storage)) func_type*(new func_type(std::forward<FUNC>(func)));
+
+        m_vtable = &vtable_for<func_type>;
+    }
+
+    move_only_function(const move_only_function&) = delete;
+    move_only_function& operator=(const move_only_function&) = delete;
+
+    move_only_function(move_only_function&& rhs) noexcept
+    {
+        take(rhs);
+    }
+
+    move_only_function& operator=(move_only_function&& rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            reset();
+            take(rhs);
+        }
+        return *this;
+    }
+
+    move_only_function& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    ~move_only_function()
+    {
+        reset();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_vtable != nullptr;
+    }
+
+    RET operator()(ARGS ... args) const
+    {
+        return m_vtable->invoke(m_storage, std::forward<ARGS>(args)...);
+    }
+
+    void swap(move_only_function& other) noexcept
+    {
+        move_only_function tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+private:
+    struct vtable
+    {
+        RET (*invoke)(void*, ARGS&& ...);
+        /// nullptr if the buffer can be relocated with memcpy
+        void (*relocate)(void* dst, void* src) noexcept;
+        /// nullptr if nothing needs to be destroyed
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <typename FUNC>
+    static constexpr bool stored_inline()
+    {
+        return sizeof(FUNC) <= INLINE_SIZE && alignof(FUNC) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<FUNC>;
+    }
+
+    template <typename FUNC>
+    static FUNC& target(void* storage) noexcept
+    {
+        if constexpr(stored_inline<FUNC>())
+            return *std::launder(reinterpret_cast<FUNC*>(storage));
+        else
+            return **std::launder(reinterpret_cast<FUNC**>(storage));
+    }
+
+    template <typename FUNC>
+    static RET invoke(void* storage, ARGS&& ... args)
+    {
+        if constexpr(std::is_void_v<RET>)
+            std::invoke(target<FUNC>(storage), std::forward<ARGS>(args)...);
+        else
+            return std::invoke(target<FUNC>(storage), std::forward<ARGS>(args)...);
+    }
+
+    template <typename FUNC>
+    static void relocate(void* dst, void* src) noexcept
+    {
+        FUNC& func = target<FUNC>(src);
+        ::new(dst) FUNC(std::move(func));
+        func.~FUNC();
+    }
+
+    template <typename FUNC>
+    static void destroy(void* storage) noexcept
+    {
+        if constexpr(stored_inline<FUNC>())
+            target<FUNC>(storage).~FUNC();
+        else
+            delete &target<FUNC>(storage);
+    }
+
+    template <typename FUNC>
+    static constexpr vtable vtable_for = {
+        &invoke<FUNC>,
+        (!stored_inline<FUNC>() || is_trivially_relocatable_v<FUNC>) ? nullptr : &relocate<FUNC>,
+        (stored_inline<FUNC>() && std::is_trivially_destructible_v<FUNC>) ? nullptr : &destroy<FUNC>};
+
+    void take(move_only_function& rhs) noexcept
+    {
+        if(!rhs.m_vtable)
+            return;
+
+        if(rhs.m_vtable->relocate)
+            rhs.m_vtable->relocate(m_storage, rhs.m_storage);
+        else
+            std::memcpy(m_storage, rhs.m_storage, INLINE_SIZE);
+
+        m_vtable = std::exchange(rhs.m_vtable, nullptr);
+    }
+
+    void reset() noexcept
+    {
+        if(m_vtable && m_vtable->destroy)
+            m_vtable->destroy(m_storage);
+        m_vtable = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable std::byte m_storage[INLINE_SIZE];
+    const vtable* m_vtable = nullptr;
+};
+
+template <typename SIGNATURE, size_t INLINE_SIZE>
+void swap(move_only_function<SIGNATURE, INLINE_SIZE>& lhs, move_only_function<SIGNATURE, INLINE_SIZE>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template <typename SIGNATURE, size_t INLINE_SIZE>
+bool operator==(const move_only_function<SIGNATURE, INLINE_SIZE>& func, std::nullptr_t) noexcept
+{
+    return !func;
+}
+
+} // namespace t_ut
+
+#endif
@@ -0,0 +1,478 @@
+#ifndef CPP_UTILITY_OBJECT_POOL_HPP
+#define CPP_UTILITY_OBJECT_POOL_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "cache_line.hpp"
+#include "thread_cache.hpp"
+
+namespace t_ut {
+
+/// Counters of a fixed_pool_resource, they are only updated when a thread exchanges a magazine with the depot
+struct pool_statistics
+{
+    /// Blocks carved from chunks, i.e. the most blocks that were in use or cached by threads at once
+    size_t blocks = 0;
+    size_t chunks = 0;
+    size_t magazines = 0;
+    /// Full and empty magazines threads took from the depot, every one covers up to magazine_size calls
+    size_t exchanges = 0;
+};
+
+namespace internal {
+
+inline constexpr size_t magazine_size = 64;
+inline constexpr size_t pool_chunk_size = size_t{64} * 1024;
+
+/// Fixed number of free blocks that moves between threads and the depot as a whole
+struct alignas(cache_line_size) pool_magazine
+{
+    std::atomic<pool_magazine*> next = nullptr;
+    /// All magazines of a depot form a second list, so they can be freed with it
+    pool_magazine* next_allocated = nullptr;
+    size_t count = 0;
+    std::array<void*, magazine_size> blocks;
+};
+
+/// Lock free stack of magazines, the head carries a tag that changes with every push and pop against ABA
+/// Magazines are only freed together with the depot, so a thread that loses a race still reads valid memory
+class magazine_stack
+{
+public:
+    void push(pool_magazine* magazine) noexcept
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        do
+            magazine->next.store(pointer(head), std::memory_order_relaxed);
+        while(!m_head.compare_exchange_weak(head, pack(magazine, head), std::memory_order_release,
+            std::memory_order_relaxed));
+    }
+
+    pool_magazine* pop() noexcept
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        while(pool_magazine* magazine = pointer(head))
+        {
+            const uint64_t next = pack(magazine->next.load(std::memory_order_relaxed), head);
+            if(m_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+                return magazine;
+        }
+        return nullptr;
+    }
+
+private:
+    /// User space addresses fit into 48 bits on 64 bit platforms, the bits above hold the tag
+    static constexpr unsigned pointer_bits = sizeof(void*) == 4 ? 32 : 48;
+    static constexpr uint64_t pointer_mask = (uint64_t{1} << pointer_bits) - 1;
+
+    static uint64_t pack(pool_magazine* magazine, uint64_t previous) noexcept
+    {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(magazine))
+            | ((previous & ~pointer_mask) + (pointer_mask + 1));
+    }
+
+    static pool_magazine* pointer(uint64_t value) noexcept
+    {
+        return reinterpret_cast<pool_magazine*>(static_cast<uintptr_t>(value & pointer_mask));
+    }
+
+    alignas(cache_line_size) std::atomic<uint64_t> m_head = 0;
+};
+
+/// Blocks shared by all threads of a fixed_pool_resource, kept in full and empty magazines
+class pool_depot : public cached_depot
+{
+public:
+    pool_depot(size_t block_size, size_t alignment, std::pmr::memory_resource* upstream) noexcept
+        : m_block_size{block_size}
+        , m_alignment{alignment}
+        , m_upstream{upstream}
+    {}
+
+    pool_depot(const pool_depot&) = delete;
+    pool_depot& operator=(const pool_depot&) = delete;
+
+    ~pool_depot()
+    {
+        for(pool_magazine* magazine = m_magazines; magazine;)
+            delete std::exchange(magazine, magazine->next_allocated);
+        for(void* chunk : m_chunks)
+            m_upstream->deallocate(chunk, m_chunk_size, m_alignment);
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept
+    {
+        return m_upstream;
+    }
+
+    /// A magazine with at least one block, carved from a chunk if no thread gave any back
+    pool_magazine* take_full()
+    {
+        m_exchanges.fetch_add(1, std::memory_order_relaxed);
+        if(pool_magazine* magazine = m_full.pop())
+            return magazine;
+
+        pool_magazine* magazine = take_empty();
+        const std::lock_guard<std::mutex> lock{m_grow_mutex};
+        try
+        {
+            while(magazine->count < magazine_size)
+            {
+                if(m_bump + m_block_size > m_bump_end)
+                    grow();
+                magazine->blocks[magazine->count++] = m_bump;
+                m_bump += m_block_size;
+            }
+        }
+        catch(...)
+        {
+            if(magazine->count == 0)
+            {
+                m_empty.push(magazine);
+                throw;
+            }
+        }
+        m_blocks += magazine->count;
+        return magazine;
+    }
+
+    pool_magazine* take_empty()
+    {
+        if(pool_magazine* magazine = m_empty.pop())
+            return magazine;
+
+        auto* magazine = new pool_magazine;
+        const std::lock_guard<std::mutex> lock{m_grow_mutex};
+        magazine->next_allocated = m_magazines;
+        m_magazines = magazine;
+        ++m_magazine_count;
+        return magazine;
+    }
+
+    void put(pool_magazine* magazine) noexcept
+    {
+        if(magazine->count > 0)
+            m_full.push(magazine);
+        else
+            m_empty.push(magazine);
+    }
+
+    pool_statistics stats() const
+    {
+        const std::lock_guard<std::mutex> lock{m_grow_mutex};
+        return {m_blocks, m_chunks.size(), m_magazine_count, m_exchanges.load(std::memory_order_relaxed)};
+    }
+
+private:
+    void grow()
+    {
+        // Make room first so that push_back can not throw and leak the chunk, doubling keeps the growth linear
+        if(m_chunks.size() == m_chunks.capacity())
+            m_chunks.reserve(std::max<size_t>(8, 2 * m_chunks.capacity()));
+        m_bump = static_cast<std::byte*>(m_upstream->allocate(m_chunk_size, m_alignment));
+        m_bump_end = m_bump + m_chunk_size;
+        m_chunks.push_back(m_bump);
+    }
+
+    const size_t m_block_size;
+    const size_t m_alignment;
+    std::pmr::memory_resource* m_upstream;
+
+    magazine_stack m_full;
+    magazine_stack m_empty;
+    alignas(cache_line_size) std::atomic<size_t> m_exchanges = 0;
+
+    alignas(cache_line_size) mutable std::mutex m_grow_mutex;
+    const size_t m_chunk_size = std::max(pool_chunk_size, m_block_size * magazine_size);
+    std::vector<void*> m_chunks;
+    std::byte* m_bump = nullptr;
+    std::byte* m_bump_end = nullptr;
+    pool_magazine* m_magazines = nullptr;
+    size_t m_magazine_count = 0;
+    size_t m_blocks = 0;
+};
+
+/// A loaded magazine to allocate from and free to and the previous one, so a thread that alternates between
+///     allocating and freeing around a magazine boundary does not go to the depot every time
+struct pool_thread_cache
+{
+    explicit pool_thread_cache(pool_depot& depot)
+        : loaded{depot.take_empty()}
+        , previous{depot.take_empty()}
+    {}
+
+    void flush(pool_depot& depot) noexcept
+    {
+        depot.put(loaded);
+        depot.put(previous);
+    }
+
+    pool_magazine* loaded;
+    pool_magazine* previous;
+};
+
+using pool_thread_caches = thread_caches<pool_depot, pool_thread_cache>;
+
+} // namespace internal
+
+/// Pool of blocks of one size, for objects of the same type that are created and destroyed all the time
+/// Every thread allocates from and frees to its own magazines of 64 blocks, and only exchanges a full or empty magazine
+///     with the lock free stacks of the depot when it runs out, so blocks move between threads without a lock and
+///     without malloc once the pool has grown to its working set
+/// Usable as a std::pmr::memory_resource, requests that do not fit into a block go to the upstream resource, which has
+///     to be thread safe. Blocks are only returned upstream once the pool is gone and every thread that used it exited
+///     or used any fixed_pool_resource again
+class fixed_pool_resource final : public std::pmr::memory_resource
+{
+public:
+    explicit fixed_pool_resource(size_t block_size, size_t alignment = alignof(std::max_align_t),
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_block_size{(std::max(block_size, size_t{1}) + alignment - 1) / alignment * alignment}
+        , m_alignment{alignment}
+        , m_depot{std::make_shared<internal::pool_depot>(m_block_size, m_alignment, upstream)}
+    {}
+
+    fixed_pool_resource(const fixed_pool_resource&) = delete;
+    fixed_pool_resource& operator=(const fixed_pool_resource&) = delete;
+
+    ~fixed_pool_resource() override
+    {
+        m_depot->close();
+        if(auto* caches = internal::pool_thread_caches::local())
+            caches->drop(m_depot.get());
+    }
+
+    size_t block_size() const noexcept
+    {
+        return m_block_size;
+    }
+
+    std::pmr::memory_resource* upstream_resource() const noexcept
+    {
+        return m_depot->upstream();
+    }
+
+    void* allocate_block()
+    {
+        auto* caches = internal::pool_thread_caches::local();
+        if(!caches)
+        {
+            internal::pool_magazine* magazine = m_depot->take_full();
+            void* result = magazine->blocks[--magazine->count];
+            m_depot->put(magazine);
+            return result;
+        }
+
+        auto& cache = caches->find(m_depot);
+        if(cache.loaded->count == 0)
+        {
+            if(cache.previous->count > 0)
+            {
+                std::swap(cache.loaded, cache.previous);
+            }
+            else
+            {
+                internal::pool_magazine* full = m_depot->take_full();
+                m_depot->put(cache.previous);
+                cache.previous = std::exchange(cache.loaded, full);
+            }
+        }
+        return cache.loaded->blocks[--cache.loaded->count];
+    }
+
+    void deallocate_block(void* block)
+    {
+        auto* caches = internal::pool_thread_caches::local();
+        if(!caches)
+        {
+            internal::pool_magazine* magazine = m_depot->take_empty();
+            magazine->blocks[magazine->count++] = block;
+            m_depot->put(magazine);
+            return;
+        }
+
+        auto& cache = caches->find(m_depot);
+        if(cache.loaded->count == internal::magazine_size)
+        {
+            if(cache.previous->count < internal::magazine_size)
+            {
+                std::swap(cache.loaded, cache.previous);
+            }
+            else
+            {
+                internal::pool_magazine* empty = m_depot->take_empty();
+                m_depot->put(cache.previous);
+                cache.previous = std::exchange(cache.loaded, empty);
+            }
+        }
+        cache.loaded->blocks[cache.loaded->count++] = block;
+    }
+
+    pool_statistics stats() const
+    {
+        return m_depot->stats();
+    }
+
+private:
+    bool fits(size_t bytes, size_t alignment) const noexcept
+    {
+        return bytes <= m_block_size && alignment <= m_alignment;
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if(!fits(bytes, alignment))
+            return m_depot->upstream()->allocate(bytes, alignment);
+        return allocate_block();
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        if(!fits(bytes, alignment))
+            return m_depot->upstream()->deallocate(ptr, bytes, alignment);
+        deallocate_block(ptr);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    size_t m_block_size;
+    size_t m_alignment;
+    std::shared_ptr<internal::pool_depot> m_depot;
+};
+
+/// Typed front end of a fixed_pool_resource for objects of type T
+template <typename T>
+class object_pool
+{
+public:
+    object_pool()
+        : m_pool{sizeof(T), alignof(T)}
+    {}
+
+    explicit object_pool(std::pmr::memory_resource* upstream)
+        : m_pool{sizeof(T), alignof(T), upstream}
+    {}
+
+    /// Pool used by pooled_ptr and pool_allocator, it is never destroyed so objects can still be freed at exit
+    static object_pool& shared()
+    {
+        static auto* pool = new object_pool;
+        return *pool;
+    }
+
+    T* allocate()
+    {
+        return static_cast<T*>(m_pool.allocate_block());
+    }
+
+    void deallocate(T* ptr)
+    {
+        m_pool.deallocate_block(ptr);
+    }
+
+    template <typename ... ARGS>
+    T* create(ARGS&& ... args)
+    {
+        T* ptr = allocate();
+        try
+        {
+            return ::new(static_cast<void*>(ptr)) T(std::forward<ARGS>(args)...);
+        }
+        catch(...)
+        {
+            deallocate(ptr);
+            throw;
+        }
+    }
+
+    void destroy(T* ptr)
+    {
+        ptr->~T();
+        deallocate(ptr);
+    }
+
+    fixed_pool_resource& resource() noexcept
+    {
+        return m_pool;
+    }
+
+    pool_statistics stats() const
+    {
+        return m_pool.stats();
+    }
+
+private:
+    fixed_pool_resource m_pool;
+};
+
+template <typename T>
+struct pooled_deleter
+{
+    void operator()(T* ptr) const
+    {
+        object_pool<T>::shared().destroy(ptr);
+    }
+};
+
+/// unique_ptr to an object in the shared object_pool of its type
+template <typename T>
+using pooled_ptr = std::unique_ptr<T, pooled_deleter<T>>;
+
+template <typename T, typename ... ARGS>
+pooled_ptr<T> make_pooled(ARGS&& ... args)
+{
+    return pooled_ptr<T>{object_pool<T>::shared().create(std::forward<ARGS>(args)...)};
+}
+
+/// Allocator that takes single objects from the shared object_pool of their type, e.g. for allocate_shared or the
+///     nodes of std::list and std::map, arrays come from std::allocator
+template <typename T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+
+    pool_allocator() = default;
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept
+    {}
+
+    T* allocate(size_t count)
+    {
+        if(count == 1)
+            return object_pool<T>::shared().allocate();
+        return std::allocator<T>{}.allocate(count);
+    }
+
+    void deallocate(T* ptr, size_t count)
+    {
+        if(count == 1)
+            object_pool<T>::shared().deallocate(ptr);
+        else
+            std::allocator<T>{}.deallocate(ptr, count);
+    }
+
+    template <typename U>
+    friend bool operator==(const pool_allocator&, const pool_allocator<U>&) noexcept
+    {
+        return true;
+    }
+};
+
+} // namespace t_ut
+
+#endif
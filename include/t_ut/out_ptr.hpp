@@ -1,59 +1,90 @@
 #ifndef CPP_UTILITY_OUT_PTR_HPP
 #define CPP_UTILITY_OUT_PTR_HPP
 
-#include <utility>
+#include <memory>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace t_ut {
 
-// TODO Currently only working with unique_ptr, so make it work with shared_ptr
-// Problem is, that shared_ptr's release function takes the deleter as a parameter
+namespace internal {
 
+template <typename SMART>
+struct is_shared_ptr : std::false_type
+{};
 
-// f(std::get<Indices>(::std::forward<ArgTuple>(args))...)
+template <typename T>
+struct is_shared_ptr<std::shared_ptr<T>> : std::true_type
+{};
 
-template <typename SMART, typename POINTER, typename ... DELETER>
-class out_ptr
+/// The pointer typedef of SMART if it has one, like unique_ptr, otherwise a pointer to its element_type
+template <typename SMART>
+struct smart_pointer
 {
-public:
-    using smart_ptr_type = SMART;
-    using ptr_type = POINTER;
+    using type = typename SMART::element_type*;
+};
 
-    out_ptr(smart_ptr_type& smart, DELETER ... deleter)
-        : m_smart{&smart},
-          m_ptr{smart.get()},
-          m_deleter{std::move(deleter)...}
-    {}
+template <typename SMART>
+    requires requires { typename SMART::pointer; }
+struct smart_pointer<SMART>
+{
+    using type = typename SMART::pointer;
+};
 
-    out_ptr(const out_ptr&) = delete;
-    out_ptr& operator=(const out_ptr&) = delete;
+} // namespace internal
 
-    out_ptr(out_ptr&& rhs) noexcept
-        : m_smart{rhs.m_smart},
-          m_ptr{rhs.m_ptr},
-          m_deleter{std::move(rhs.m_deleter)}
+/// How out_ptr and in_out_ptr clear a smart pointer, hand a new pointer to it and take its pointer back
+/// The defaults use reset() and reset(pointer, args ...), or assign SMART(pointer, args ...) if there is no such reset,
+///     and release() or detach(). Specialize it for handle types that work differently.
+template <typename SMART>
+struct out_ptr_traits
+{
+    using pointer = typename internal::smart_pointer<SMART>::type;
+
+    static void clear(SMART& smart) noexcept
     {
-        rhs.m_smart = nullptr;
+        if constexpr(requires { smart.reset(); })
+            smart.reset();
+        else
+            smart = SMART{};
     }
 
-    out_ptr& operator=(out_ptr&& rhs) noexcept
+    template <typename ... ARGS>
+    static void reset(SMART& smart, pointer ptr, ARGS&& ... args)
     {
-        m_smart = rhs.m_smart;
-        m_ptr = rhs.m_ptr;
-        m_deleter = std::move(rhs.m_deleter);
+        if constexpr(requires { smart.reset(ptr, std::forward<ARGS>(args)...); })
+            smart.reset(ptr, std::forward<ARGS>(args)...);
+        else
+            smart = SMART(ptr, std::forward<ARGS>(args)...);
+    }
 
-        rhs.m_smart = nullptr;
+    static pointer release(SMART& smart) noexcept
+    {
+        if constexpr(requires { smart.release(); })
+            return smart.release();
+        else
+            return smart.detach();
     }
+};
+
+namespace internal {
+
+/// Holds the raw pointer the C function writes and hands it to the smart pointer on destruction
+template <typename SMART, typename POINTER, typename ... ARGS>
+class out_ptr_base
+{
+public:
+    using smart_ptr_type = SMART;
+    using ptr_type = POINTER;
+
+    /// Not movable, so the smart pointer is always there to take the pointer and no moved from state has to be checked
+    out_ptr_base(const out_ptr_base&) = delete;
+    out_ptr_base& operator=(const out_ptr_base&) = delete;
 
-    ~out_ptr() noexcept
+    ~out_ptr_base() noexcept
     {
-        if(m_smart)
-        {
-            if constexpr(sizeof...(DELETER) != 0)
-                m_smart->reset(m_ptr, std::get<0>(m_deleter));
-            else
-                m_smart->reset(m_ptr);
-        }
+        store();
     }
 
     operator ptr_type*() noexcept
@@ -62,22 +93,65 @@ public:
     }
 
     operator void**() noexcept
+        requires (!std::is_same_v<ptr_type, void*>)
     {
         return reinterpret_cast<void**>(&m_ptr);
     }
 
+protected:
+    using traits = out_ptr_traits<SMART>;
+
+    out_ptr_base(smart_ptr_type& smart, ptr_type ptr, ARGS&& ... args)
+        : m_smart{smart}
+        , m_ptr{ptr}
+        , m_args{std::move(args)...}
+    {}
+
 private:
-    smart_ptr_type* m_smart;
-    ptr_type m_ptr;
+    /// A null pointer is not handed over, the smart pointer has already been cleared
+    void store() noexcept
+    {
+        if(m_ptr)
+        {
+            std::apply([this](ARGS& ... args)
+            {
+                traits::reset(m_smart, static_cast<typename traits::pointer>(m_ptr), std::move(args)...);
+            }, m_args);
+        }
+    }
 
-    std::tuple<DELETER...> m_deleter;
+    smart_ptr_type& m_smart;
+    ptr_type m_ptr;
+    [[no_unique_address]] std::tuple<ARGS...> m_args;
 };
 
+} // namespace internal
+
+/// Passes a smart pointer to a C function that creates an object and returns it through a POINTER* parameter:
+///     create_handle(t_ut::out_ptr{handle})
+/// The smart pointer is cleared right away and takes over the new pointer at the end of the full expression
+/// ARGS are passed on to reset, e.g. the deleter of a shared_ptr or adopt_ref for an intrusive_ptr
+/// POINTER defaults to the smart pointer's type, it can be any type that converts to it, e.g. void*
+/// The pointer is a plain member that the compiler keeps in place, so nothing is allocated or called beyond what a raw
+///     pointer that is put into the smart pointer by hand needs, only the reference to the smart pointer is kept in the
+///     frame, codegen/out_ptr_codegen.cpp checks that
+template <typename SMART, typename POINTER, typename ... ARGS>
+class out_ptr : public internal::out_ptr_base<SMART, POINTER, ARGS...>
+{
+    static_assert(!internal::is_shared_ptr<SMART>::value || sizeof...(ARGS) > 0,
+        "a shared_ptr would delete the object, pass the deleter of the C API");
+
+public:
+    explicit out_ptr(SMART& smart, ARGS ... args)
+        : internal::out_ptr_base<SMART, POINTER, ARGS...>{smart, POINTER{}, std::move(args)...}
+    {
+        out_ptr_traits<SMART>::clear(smart);
+    }
+};
 
-/// Deduction guide for out_ptr type from a shared_ptr with a custom deleter
-template <typename SMART, typename ... DELETER>
-out_ptr(SMART& smart, DELETER&& ... deleter) ->
-    out_ptr<typename std::remove_reference<decltype(smart)>::type, decltype(smart.get()), DELETER ...>;
+/// Deduction guide for out_ptr type from a smart pointer and the arguments for its reset
+template <typename SMART, typename ... ARGS>
+out_ptr(SMART& smart, ARGS ... args) -> out_ptr<SMART, typename out_ptr_traits<SMART>::pointer, ARGS ...>;
 
 } // namespace t_ut
 
@@ -0,0 +1,472 @@
+#ifndef CPP_UTILITY_PERSISTENT_MAP_HPP
+#define CPP_UTILITY_PERSISTENT_MAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "refcount.hpp"
+#include "small_vector.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Node of a hash array mapped trie in the compressed (CHAMP) layout
+/// Every level consumes 5 bits of the hash. A node stores entries that end at this level and children for
+///     hash fragments shared by several entries, the bitmaps tell which fragment sits at which position.
+///     Below the last hash bits a node only holds entries with the very same hash.
+/// Children and entries are stored in arrays behind the node in the same allocation, so a lookup touches one
+///     cache line per level. Nodes are never modified after create(), updates build new nodes along the path.
+template <typename KEY, typename VALUE>
+class hamt_node : public refcounted<hamt_node<KEY, VALUE>>
+{
+public:
+    struct entry
+    {
+        size_t hash;
+        std::pair<KEY, VALUE> value;
+    };
+
+    using node_ptr = intrusive_ptr<const hamt_node>;
+    /// Lists of the entries and children of a node that is about to be created
+    using entry_list = small_vector<const entry*, 33>;
+    using child_list = small_vector<node_ptr, 33>;
+
+    static constexpr size_t bits = 5;
+    static constexpr size_t hash_bits = sizeof(size_t) * 8;
+
+    static_assert(alignof(entry) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "over-aligned keys or values are not supported");
+
+    static constexpr uint32_t fragment_bit(size_t hash, size_t shift)
+    {
+        return uint32_t{1} << ((hash >> shift) & ((1u << bits) - 1));
+    }
+
+    static constexpr size_t index(uint32_t map, uint32_t bit)
+    {
+        return static_cast<size_t>(std::popcount(map & (bit - 1)));
+    }
+
+    /// New node with copies of entries and children, the entry movable points to is moved instead of copied
+    static node_ptr create(uint32_t entry_map, uint32_t child_map, const entry_list& entries, child_list&& children,
+        entry* movable = nullptr)
+    {
+        void* memory = ::operator new(entries_offset(children.size()) + entries.size() * sizeof(entry));
+        // From here on the node destroys whatever has been constructed if copying an entry throws
+        intrusive_ptr<hamt_node> node{::new(memory) hamt_node(entry_map, child_map, children.size()), adopt_ref};
+        for(node_ptr& child : children)
+        {
+            ::new(static_cast<void*>(node->children_data() + node->m_child_count)) node_ptr(std::move(child));
+            ++node->m_child_count;
+        }
+        for(const entry* source : entries)
+        {
+            void* target = static_cast<void*>(node->entries_data() + node->m_entry_count);
+            if(source == movable)
+                ::new(target) entry(std::move(*movable));
+            else
+                ::new(target) entry(*source);
+            ++node->m_entry_count;
+        }
+        return node;
+    }
+
+    ~hamt_node()
+    {
+        std::destroy_n(entries_data(), m_entry_count);
+        std::destroy_n(children_data(), m_child_count);
+    }
+
+    static void operator delete(void* memory)
+    {
+        ::operator delete(memory);
+    }
+
+    uint32_t entry_map() const { return m_entry_map; }
+    uint32_t child_map() const { return m_child_map; }
+    size_t entry_count() const { return m_entry_count; }
+    size_t child_count() const { return m_child_count; }
+    const entry& entry_at(size_t position) const { return entries_data()[position]; }
+    const node_ptr& child_at(size_t position) const { return children_data()[position]; }
+
+    entry_list all_entries() const
+    {
+        entry_list result;
+        for(size_t i = 0; i < m_entry_count; ++i)
+            result.push_back(&entry_at(i));
+        return result;
+    }
+
+    child_list all_children() const
+    {
+        child_list result;
+        for(size_t i = 0; i < m_child_count; ++i)
+            result.push_back(child_at(i));
+        return result;
+    }
+
+    /// Node with a single entry that can be pulled up into the parent
+    bool is_single_entry() const
+    {
+        return m_entry_count == 1 && m_child_count == 0;
+    }
+
+private:
+    hamt_node(uint32_t entry_map, uint32_t child_map, size_t child_capacity) noexcept
+        : m_entry_map{entry_map}
+        , m_child_map{child_map}
+        , m_child_capacity{static_cast<uint32_t>(child_capacity)}
+    {}
+
+    static constexpr size_t align_up(size_t offset, size_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static constexpr size_t children_offset()
+    {
+        return align_up(sizeof(hamt_node), alignof(node_ptr));
+    }
+
+    static constexpr size_t entries_offset(size_t child_capacity)
+    {
+        return align_up(children_offset() + child_capacity * sizeof(node_ptr), alignof(entry));
+    }
+
+    node_ptr* children_data() const
+    {
+        return std::launder(reinterpret_cast<node_ptr*>(
+            reinterpret_cast<std::byte*>(const_cast<hamt_node*>(this)) + children_offset()));
+    }
+
+    entry* entries_data() const
+    {
+        return std::launder(reinterpret_cast<entry*>(
+            reinterpret_cast<std::byte*>(const_cast<hamt_node*>(this)) + entries_offset(m_child_capacity)));
+    }
+
+    uint32_t m_entry_map;
+    uint32_t m_child_map;
+    uint32_t m_child_capacity;
+    uint32_t m_child_count = 0;
+    size_t m_entry_count = 0;
+};
+
+} // namespace internal
+
+/// Immutable hash map that shares structure between versions
+/// set() and erase() return a new map and copy only the O(log32 n) nodes on the path to the changed entry,
+///     all other nodes are shared with the original map, which stays unchanged
+/// Copying a map only retains its root, so versions can be kept and handed around cheaply, e.g. through atomic_cow
+/// Lookups on different versions are thread safe, the reference counts of the nodes are atomic
+template <typename KEY, typename VALUE, typename HASH = std::hash<KEY>, typename EQUAL = std::equal_to<KEY>>
+class persistent_map
+{
+    using node_type = internal::hamt_node<KEY, VALUE>;
+    using node_ptr = typename node_type::node_ptr;
+    using entry = typename node_type::entry;
+
+public:
+    using key_type = KEY;
+    using mapped_type = VALUE;
+    using value_type = std::pair<KEY, VALUE>;
+    using size_type = size_t;
+    using hasher = HASH;
+    using key_equal = EQUAL;
+
+    persistent_map() = default;
+
+    persistent_map(std::initializer_list<value_type> values)
+    {
+        for(const auto& value : values)
+            insert_in_place(value.first, value.second);
+    }
+
+    size_type size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    /// Pointer to the value of key or nullptr
+    const mapped_type* find(const key_type& key) const
+    {
+        const size_t hash = m_hash(key);
+        const node_type* node = m_root.get();
+        for(size_t shift = 0; node; shift += node_type::bits)
+        {
+            if(shift >= node_type::hash_bits)
+                return find_collision(*node, key);
+
+            const uint32_t bit = node_type::fragment_bit(hash, shift);
+            if(node->entry_map() & bit)
+            {
+                const entry& candidate = node->entry_at(node_type::index(node->entry_map(), bit));
+                return candidate.hash == hash && m_equal(candidate.value.first, key) ? &candidate.value.second
+                                                                                      : nullptr;
+            }
+            if(!(node->child_map() & bit))
+                return nullptr;
+            node = node->child_at(node_type::index(node->child_map(), bit)).get();
+        }
+        return nullptr;
+    }
+
+    bool contains(const key_type& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    const mapped_type& at(const key_type& key) const
+    {
+        const mapped_type* value = find(key);
+        if(!value)
+            throw std::out_of_range{""};
+        return *value;
+    }
+
+    /// Copy of the map with key set to value, whether it existed before or not
+    [[nodiscard]] persistent_map set(key_type key, mapped_type value) const
+    {
+        persistent_map result{*this};
+        result.insert_in_place(std::move(key), std::move(value));
+        return result;
+    }
+
+    /// Copy of the map without key, shares the whole tree with this map if key does not exist
+    [[nodiscard]] persistent_map erase(const key_type& key) const
+    {
+        persistent_map result{*this};
+        if(!m_root)
+            return result;
+
+        bool erased = false;
+        node_ptr root = erase(m_root, m_hash(key), key, 0, erased);
+        if(erased)
+        {
+            result.m_root = std::move(root);
+            --result.m_size;
+        }
+        return result;
+    }
+
+    /// Calls func with every key and value, in an unspecified order
+    template <typename FUNC>
+    void for_each(FUNC&& func) const
+    {
+        if(m_root)
+            for_each(*m_root, func);
+    }
+
+    /// True if both maps are the same version or one was derived from the other without any change
+    bool shares_root_with(const persistent_map& other) const
+    {
+        return m_root == other.m_root;
+    }
+
+private:
+    using entry_list = typename node_type::entry_list;
+    using child_list = typename node_type::child_list;
+
+    const mapped_type* find_collision(const node_type& node, const key_type& key) const
+    {
+        for(size_t i = 0; i < node.entry_count(); ++i)
+        {
+            if(m_equal(node.entry_at(i).value.first, key))
+                return &node.entry_at(i).value.second;
+        }
+        return nullptr;
+    }
+
+    void insert_in_place(key_type key, mapped_type value)
+    {
+        bool added = false;
+        entry new_entry{m_hash(key), {std::move(key), std::move(value)}};
+        m_root = insert(m_root.get(), new_entry, 0, added);
+        m_size += added;
+    }
+
+    template <typename LIST, typename T>
+    static void insert_at(LIST& list, size_t position, T&& value)
+    {
+        list.insert(list.begin() + static_cast<std::ptrdiff_t>(position), std::forward<T>(value));
+    }
+
+    template <typename LIST>
+    static void erase_at(LIST& list, size_t position)
+    {
+        list.erase(list.begin() + static_cast<std::ptrdiff_t>(position));
+    }
+
+    /// Copy of node with new_entry inserted, node may be null
+    node_ptr insert(const node_type* node, entry& new_entry, size_t shift, bool& added) const
+    {
+        if(!node)
+        {
+            added = true;
+            return node_type::create(node_type::fragment_bit(new_entry.hash, shift), 0, {&new_entry}, {}, &new_entry);
+        }
+
+        entry_list entries = node->all_entries();
+        child_list children = node->all_children();
+
+        if(shift >= node_type::hash_bits)
+        {
+            for(const entry*& existing : entries)
+            {
+                if(m_equal(existing->value.first, new_entry.value.first))
+                {
+                    existing = &new_entry;
+                    return node_type::create(0, 0, entries, {}, &new_entry);
+                }
+            }
+            entries.push_back(&new_entry);
+            added = true;
+            return node_type::create(0, 0, entries, {}, &new_entry);
+        }
+
+        uint32_t entry_map = node->entry_map();
+        uint32_t child_map = node->child_map();
+        const uint32_t bit = node_type::fragment_bit(new_entry.hash, shift);
+        if(entry_map & bit)
+        {
+            const size_t position = node_type::index(entry_map, bit);
+            const entry& existing = *entries[position];
+            if(existing.hash == new_entry.hash && m_equal(existing.value.first, new_entry.value.first))
+            {
+                entries[position] = &new_entry;
+            }
+            else
+            {
+                // Two entries share this fragment now, move both into a new child
+                node_ptr child = merge(existing, new_entry, shift + node_type::bits);
+                erase_at(entries, position);
+                entry_map &= ~bit;
+                child_map |= bit;
+                insert_at(children, node_type::index(child_map, bit), std::move(child));
+                added = true;
+            }
+        }
+        else if(child_map & bit)
+        {
+            node_ptr& child = children[node_type::index(child_map, bit)];
+            child = insert(child.get(), new_entry, shift + node_type::bits, added);
+        }
+        else
+        {
+            entry_map |= bit;
+            insert_at(entries, node_type::index(entry_map, bit), &new_entry);
+            added = true;
+        }
+        return node_type::create(entry_map, child_map, entries, std::move(children), &new_entry);
+    }
+
+    node_ptr merge(const entry& existing, entry& new_entry, size_t shift) const
+    {
+        if(shift >= node_type::hash_bits)
+            return node_type::create(0, 0, {&existing, &new_entry}, {}, &new_entry);
+
+        const uint32_t existing_bit = node_type::fragment_bit(existing.hash, shift);
+        const uint32_t new_bit = node_type::fragment_bit(new_entry.hash, shift);
+        if(existing_bit == new_bit)
+        {
+            child_list children;
+            children.push_back(merge(existing, new_entry, shift + node_type::bits));
+            return node_type::create(0, existing_bit, {}, std::move(children));
+        }
+
+        entry_list entries{&existing, &new_entry};
+        if(existing_bit > new_bit)
+            std::swap(entries[0], entries[1]);
+        return node_type::create(existing_bit | new_bit, 0, entries, {}, &new_entry);
+    }
+
+    /// node without key, node itself if key does not exist and nullptr if nothing is left
+    /// A child that is left with a single entry is replaced by the entry, so every map has one canonical shape
+    node_ptr erase(const node_ptr& node, size_t hash, const key_type& key, size_t shift, bool& erased) const
+    {
+        if(shift >= node_type::hash_bits)
+        {
+            for(size_t i = 0; i < node->entry_count(); ++i)
+            {
+                if(m_equal(node->entry_at(i).value.first, key))
+                {
+                    erased = true;
+                    if(node->entry_count() == 1)
+                        return nullptr;
+                    entry_list entries = node->all_entries();
+                    erase_at(entries, i);
+                    return node_type::create(0, 0, entries, {});
+                }
+            }
+            return node;
+        }
+
+        uint32_t entry_map = node->entry_map();
+        uint32_t child_map = node->child_map();
+        const uint32_t bit = node_type::fragment_bit(hash, shift);
+        if(entry_map & bit)
+        {
+            const size_t position = node_type::index(entry_map, bit);
+            const entry& existing = node->entry_at(position);
+            if(existing.hash != hash || !m_equal(existing.value.first, key))
+                return node;
+
+            erased = true;
+            if(node->is_single_entry())
+                return nullptr;
+            entry_list entries = node->all_entries();
+            erase_at(entries, position);
+            return node_type::create(entry_map & ~bit, child_map, entries, node->all_children());
+        }
+
+        if(!(child_map & bit))
+            return node;
+
+        const size_t child_position = node_type::index(child_map, bit);
+        const node_ptr& child = node->child_at(child_position);
+        node_ptr new_child = erase(child, hash, key, shift + node_type::bits, erased);
+        if(new_child == child)
+            return node;
+
+        entry_list entries = node->all_entries();
+        child_list children = node->all_children();
+        if(!new_child || new_child->is_single_entry())
+        {
+            erase_at(children, child_position);
+            child_map &= ~bit;
+            if(new_child)
+            {
+                entry_map |= bit;
+                insert_at(entries, node_type::index(entry_map, bit), &new_child->entry_at(0));
+            }
+        }
+        else
+        {
+            children[child_position] = std::move(new_child);
+        }
+        return node_type::create(entry_map, child_map, entries, std::move(children));
+    }
+
+    template <typename FUNC>
+    static void for_each(const node_type& node, FUNC& func)
+    {
+        for(size_t i = 0; i < node.entry_count(); ++i)
+            func(node.entry_at(i).value.first, node.entry_at(i).value.second);
+        for(size_t i = 0; i < node.child_count(); ++i)
+            for_each(*node.child_at(i), func);
+    }
+
+    node_ptr m_root;
+    size_type m_size = 0;
+    [[no_unique_address]] hasher m_hash;
+    [[no_unique_address]] key_equal m_equal;
+};
+
+} // namespace t_ut
+
+#endif
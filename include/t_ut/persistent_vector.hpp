@@ -0,0 +1,313 @@
+#ifndef CPP_UTILITY_PERSISTENT_VECTOR_HPP
+#define CPP_UTILITY_PERSISTENT_VECTOR_HPP
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "refcount.hpp"
+#include "static_vector.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+inline constexpr size_t vector_node_bits = 5;
+inline constexpr size_t vector_node_size = size_t{1} << vector_node_bits;
+inline constexpr size_t vector_node_mask = vector_node_size - 1;
+
+/// Nodes of a persistent_vector, the tree depth tells whether a node is a branch or a leaf
+struct vector_node : refcounted<vector_node>
+{
+    virtual ~vector_node() = default;
+};
+
+struct vector_branch : vector_node
+{
+    static_vector<intrusive_ptr<const vector_node>, vector_node_size> children;
+};
+
+template <typename T>
+struct vector_leaf : vector_node
+{
+    static_vector<T, vector_node_size> values;
+};
+
+} // namespace internal
+
+/// Immutable vector that shares structure between versions
+/// Elements are stored in chunks of 32 at the leaves of a tree with 32 children per branch, so an element is found
+///     in O(log32 n) steps and push_back(), set() and pop_back() copy only the nodes on the path to it while all
+///     other chunks are shared with the original vector
+/// Copying a vector only retains its root, so versions can be kept and handed around cheaply, e.g. through atomic_cow
+template <typename T>
+class persistent_vector
+{
+    using node_ptr = intrusive_ptr<const internal::vector_node>;
+    using branch_type = internal::vector_branch;
+    using leaf_type = internal::vector_leaf<T>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using const_reference = const value_type&;
+
+    /// Random access iterator that remembers the current chunk, so iterating touches every node only once
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator() = default;
+
+        reference operator*() const
+        {
+            if(!m_leaf || (m_index & ~internal::vector_node_mask) != m_leaf_start)
+            {
+                m_leaf = &m_vector->leaf_for(m_index);
+                m_leaf_start = m_index & ~internal::vector_node_mask;
+            }
+            return m_leaf->values[m_index & internal::vector_node_mask];
+        }
+
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        const_iterator& operator++() { ++m_index; return *this; }
+        const_iterator operator++(int) { auto tmp = *this; ++m_index; return tmp; }
+        const_iterator& operator--() { --m_index; return *this; }
+        const_iterator operator--(int) { auto tmp = *this; --m_index; return tmp; }
+        const_iterator& operator+=(difference_type n) { m_index += static_cast<size_t>(n); return *this; }
+        const_iterator& operator-=(difference_type n) { m_index -= static_cast<size_t>(n); return *this; }
+
+        friend const_iterator operator+(const_iterator it, difference_type n) { return it += n; }
+        friend const_iterator operator+(difference_type n, const_iterator it) { return it += n; }
+        friend const_iterator operator-(const_iterator it, difference_type n) { return it -= n; }
+
+        friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs)
+        {
+            return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index);
+        }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs)
+        {
+            return lhs.m_index == rhs.m_index;
+        }
+
+        friend auto operator<=>(const const_iterator& lhs, const const_iterator& rhs)
+        {
+            return lhs.m_index <=> rhs.m_index;
+        }
+
+    private:
+        friend class persistent_vector;
+
+        const_iterator(const persistent_vector* vector, size_t index)
+            : m_vector{vector}
+            , m_index{index}
+        {}
+
+        const persistent_vector* m_vector = nullptr;
+        size_t m_index = 0;
+        mutable const leaf_type* m_leaf = nullptr;
+        mutable size_t m_leaf_start = 0;
+    };
+
+    using iterator = const_iterator;
+
+    persistent_vector() = default;
+
+    persistent_vector(std::initializer_list<value_type> values)
+    {
+        for(const auto& value : values)
+            push_back_in_place(value);
+    }
+
+    size_type size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const_reference operator[](size_type index) const
+    {
+        return leaf_for(index).values[index & internal::vector_node_mask];
+    }
+
+    const_reference at(size_type index) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range{""};
+        return (*this)[index];
+    }
+
+    const_reference front() const { return (*this)[0]; }
+    const_reference back() const { return (*this)[m_size - 1]; }
+
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    /// Copy of the vector with value appended
+    [[nodiscard]] persistent_vector push_back(value_type value) const
+    {
+        persistent_vector result{*this};
+        result.push_back_in_place(std::move(value));
+        return result;
+    }
+
+    /// Copy of the vector with the element at index replaced by value
+    [[nodiscard]] persistent_vector set(size_type index, value_type value) const
+    {
+        if(index >= m_size)
+            throw std::out_of_range{""};
+
+        persistent_vector result{*this};
+        result.m_root = set(m_root.get(), m_shift, index, std::move(value));
+        return result;
+    }
+
+    /// Copy of the vector without its last element
+    [[nodiscard]] persistent_vector pop_back() const
+    {
+        persistent_vector result{*this};
+        result.m_root = pop_back(m_root.get(), m_shift, m_size - 1);
+        --result.m_size;
+
+        // Drop levels that only have a single child left
+        while(result.m_shift > 0 && static_cast<const branch_type&>(*result.m_root).children.size() == 1)
+        {
+            node_ptr child = static_cast<const branch_type&>(*result.m_root).children.front();
+            result.m_root = std::move(child);
+            result.m_shift -= internal::vector_node_bits;
+        }
+        if(result.m_size == 0)
+            result.m_shift = 0;
+        return result;
+    }
+
+    /// True if both vectors are the same version
+    bool shares_root_with(const persistent_vector& other) const
+    {
+        return m_root == other.m_root;
+    }
+
+private:
+    const leaf_type& leaf_for(size_type index) const
+    {
+        const internal::vector_node* node = m_root.get();
+        for(size_t shift = m_shift; shift > 0; shift -= internal::vector_node_bits)
+            node = static_cast<const branch_type*>(node)->children[(index >> shift) & internal::vector_node_mask].get();
+        return *static_cast<const leaf_type*>(node);
+    }
+
+    void push_back_in_place(value_type value)
+    {
+        if(!m_root)
+        {
+            m_root = new_path(0, std::move(value));
+        }
+        else if(m_size == (size_t{1} << (m_shift + internal::vector_node_bits)))
+        {
+            // The tree is full, grow it by one level
+            auto root = make_intrusive<branch_type>();
+            root->children.push_back(std::move(m_root));
+            root->children.push_back(new_path(m_shift, std::move(value)));
+            m_root = std::move(root);
+            m_shift += internal::vector_node_bits;
+        }
+        else
+        {
+            m_root = push_back(m_root.get(), m_shift, m_size, std::move(value));
+        }
+        ++m_size;
+    }
+
+    /// Branches down to a new leaf that only holds value
+    static node_ptr new_path(size_t shift, value_type&& value)
+    {
+        if(shift == 0)
+        {
+            auto leaf = make_intrusive<leaf_type>();
+            leaf->values.push_back(std::move(value));
+            return leaf;
+        }
+
+        auto branch = make_intrusive<branch_type>();
+        branch->children.push_back(new_path(shift - internal::vector_node_bits, std::move(value)));
+        return branch;
+    }
+
+    static node_ptr push_back(const internal::vector_node* node, size_t shift, size_t index, value_type&& value)
+    {
+        if(shift == 0)
+        {
+            auto leaf = make_intrusive<leaf_type>(static_cast<const leaf_type&>(*node));
+            leaf->values.push_back(std::move(value));
+            return leaf;
+        }
+
+        auto branch = make_intrusive<branch_type>(static_cast<const branch_type&>(*node));
+        const size_t child = (index >> shift) & internal::vector_node_mask;
+        if(child < branch->children.size())
+            branch->children[child] = push_back(branch->children[child].get(), shift - internal::vector_node_bits, index,
+                std::move(value));
+        else
+            branch->children.push_back(new_path(shift - internal::vector_node_bits, std::move(value)));
+        return branch;
+    }
+
+    static node_ptr set(const internal::vector_node* node, size_t shift, size_t index, value_type&& value)
+    {
+        if(shift == 0)
+        {
+            auto leaf = make_intrusive<leaf_type>(static_cast<const leaf_type&>(*node));
+            leaf->values[index & internal::vector_node_mask] = std::move(value);
+            return leaf;
+        }
+
+        auto branch = make_intrusive<branch_type>(static_cast<const branch_type&>(*node));
+        auto& child = branch->children[(index >> shift) & internal::vector_node_mask];
+        child = set(child.get(), shift - internal::vector_node_bits, index, std::move(value));
+        return branch;
+    }
+
+    /// node without the element at index, which is the last one, nullptr if nothing is left
+    static node_ptr pop_back(const internal::vector_node* node, size_t shift, size_t index)
+    {
+        if(shift == 0)
+        {
+            const auto& leaf = static_cast<const leaf_type&>(*node);
+            if(leaf.values.size() == 1)
+                return nullptr;
+            auto copy = make_intrusive<leaf_type>(leaf);
+            copy->values.pop_back();
+            return copy;
+        }
+
+        const auto& branch = static_cast<const branch_type&>(*node);
+        const size_t child = (index >> shift) & internal::vector_node_mask;
+        node_ptr new_child = pop_back(branch.children[child].get(), shift - internal::vector_node_bits, index);
+        if(!new_child && child == 0)
+            return nullptr;
+
+        auto copy = make_intrusive<branch_type>(branch);
+        if(new_child)
+            copy->children[child] = std::move(new_child);
+        else
+            copy->children.pop_back();
+        return copy;
+    }
+
+    node_ptr m_root;
+    size_type m_size = 0;
+    /// Bits of the index consumed above the leaves
+    size_t m_shift = 0;
+};
+
+} // namespace t_ut
+
+#endif
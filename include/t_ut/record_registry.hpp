@@ -0,0 +1,173 @@
+#ifndef CPP_UTILITY_RECORD_REGISTRY_HPP
+#define CPP_UTILITY_RECORD_REGISTRY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cache_line.hpp"
+#include "thread_cache.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Per thread records of a memory reclamation domain, records are reused by later threads and only freed with the
+///     registry, so the list can be walked without any protection
+/// RECORD has an std::atomic<bool> owned, a RECORD* next and a std::vector<RETIRED> retired, RETIRED has the object
+///     and its deleter. The objects a thread could not free before releasing its record become orphans of the registry
+template <typename RECORD, typename RETIRED>
+class record_registry
+{
+public:
+    record_registry() = default;
+    record_registry(const record_registry&) = delete;
+    record_registry& operator=(const record_registry&) = delete;
+
+    /// Nothing can reach the retired objects anymore once the domain is gone
+    ~record_registry()
+    {
+        for(RECORD* record = head(); record;)
+        {
+            for(auto& r : record->retired)
+                r.deleter(r.object);
+            delete std::exchange(record, record->next);
+        }
+        for(auto& r : m_orphans)
+            r.deleter(r.object);
+    }
+
+    RECORD* head() const noexcept
+    {
+        return m_records.load(std::memory_order_acquire);
+    }
+
+    size_t size() const noexcept
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    RECORD* acquire()
+    {
+        for(RECORD* record = head(); record; record = record->next)
+        {
+            if(!record->owned.load(std::memory_order_relaxed) && !record->owned.exchange(true, std::memory_order_acquire))
+                return record;
+        }
+
+        auto* record = new RECORD;
+        record->owned.store(true, std::memory_order_relaxed);
+        record->next = m_records.load(std::memory_order_relaxed);
+        while(!m_records.compare_exchange_weak(record->next, record, std::memory_order_release,
+            std::memory_order_relaxed))
+        {}
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    /// Hands the objects the thread could not free yet to the orphans and makes the record available again
+    void release(RECORD* record) noexcept
+    {
+        if(!record->retired.empty())
+        {
+            const std::lock_guard<std::mutex> lock{m_orphan_mutex};
+            m_orphans.insert(m_orphans.end(), record->retired.begin(), record->retired.end());
+            record->retired.clear();
+        }
+        record->owned.store(false, std::memory_order_release);
+    }
+
+    /// Calls free with the orphans unless there are none or another thread is freeing them already
+    template <typename FUNC>
+    void try_free_orphans(FUNC&& free) noexcept
+    {
+        std::unique_lock<std::mutex> lock{m_orphan_mutex, std::try_to_lock};
+        if(lock.owns_lock() && !m_orphans.empty())
+            free(m_orphans);
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<RECORD*> m_records = nullptr;
+    std::atomic<size_t> m_size = 0;
+    std::mutex m_orphan_mutex;
+    std::vector<RETIRED> m_orphans;
+};
+
+/// The record a thread uses in one domain, STATE has acquire_record() and release_record()
+template <typename STATE>
+struct thread_record
+{
+    explicit thread_record(STATE& state)
+        : record{state.acquire_record()}
+    {}
+
+    void flush(STATE& state) noexcept
+    {
+        state.release_record(record);
+    }
+
+    typename STATE::record_type* record;
+};
+
+template <typename STATE>
+using thread_records = thread_caches<STATE, thread_record<STATE>>;
+
+/// Record of the calling thread in a domain, null once the thread caches of the calling thread were destroyed
+template <typename STATE>
+typename STATE::record_type* local_record(const std::shared_ptr<STATE>& state)
+{
+    auto* cache = thread_records<STATE>::local(state);
+    return cache ? cache->record : nullptr;
+}
+
+/// Uses the given record of the calling thread, or borrows one for its own lifetime if there is none, e.g. once the
+///     thread caches are gone in thread_local destructors
+template <typename STATE>
+class scoped_record
+{
+public:
+    using record_type = typename STATE::record_type;
+
+    scoped_record(STATE& state, record_type* record)
+        : m_state{&state}
+        , m_record{record ? record : state.acquire_record()}
+        , m_borrowed{!record}
+    {}
+
+    scoped_record(const scoped_record&) = delete;
+    scoped_record& operator=(const scoped_record&) = delete;
+
+    ~scoped_record()
+    {
+        if(m_borrowed)
+            m_state->release_record(m_record);
+    }
+
+    STATE& state() const noexcept
+    {
+        return *m_state;
+    }
+
+    record_type& operator*() const noexcept
+    {
+        return *m_record;
+    }
+
+    record_type* operator->() const noexcept
+    {
+        return m_record;
+    }
+
+private:
+    STATE* m_state;
+    record_type* m_record;
+    bool m_borrowed;
+};
+
+} // namespace internal
+
+} // namespace t_ut
+
+#endif
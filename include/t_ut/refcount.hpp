@@ -0,0 +1,229 @@
+#ifndef CPP_UTILITY_REFCOUNT_HPP
+#define CPP_UTILITY_REFCOUNT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace t_ut {
+
+/// Reference counters for intrusively counted objects, a new counter starts at one
+/// release() returns true when the last reference is gone and the object has to be destroyed
+
+/// Counter for objects that are shared between threads
+class atomic_refcount
+{
+public:
+    atomic_refcount() noexcept = default;
+    atomic_refcount(const atomic_refcount&) = delete;
+    atomic_refcount& operator=(const atomic_refcount&) = delete;
+
+    void retain() noexcept
+    {
+        // A new reference can only be created from an existing one, so nothing has to be ordered here
+        m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool release() noexcept
+    {
+        // Acquire so the thread that destroys the object sees all writes made through other references
+        return m_count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    /// Exact if it returns one, any other value may already be outdated
+    size_t count() const noexcept
+    {
+        return m_count.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<size_t> m_count{1};
+};
+
+/// Counter for objects that are only used by one thread at a time
+class local_refcount
+{
+public:
+    local_refcount() noexcept = default;
+    local_refcount(const local_refcount&) = delete;
+    local_refcount& operator=(const local_refcount&) = delete;
+
+    void retain() noexcept
+    {
+        ++m_count;
+    }
+
+    bool release() noexcept
+    {
+        return --m_count == 0;
+    }
+
+    size_t count() const noexcept
+    {
+        return m_count;
+    }
+
+private:
+    size_t m_count = 1;
+};
+
+/// Base class that stores the reference count of DERIVED and provides the hooks used by intrusive_ptr
+/// The count is mutable so that objects can be shared as const
+template <typename DERIVED, typename REFCOUNT = atomic_refcount>
+class refcounted
+{
+public:
+    size_t use_count() const noexcept
+    {
+        return m_count.count();
+    }
+
+    friend void intrusive_retain(const DERIVED* object) noexcept
+    {
+        object->m_count.retain();
+    }
+
+    friend void intrusive_release(const DERIVED* object) noexcept
+    {
+        if(object->m_count.release())
+            delete object;
+    }
+
+protected:
+    refcounted() noexcept = default;
+    /// Copies start with their own count
+    refcounted(const refcounted&) noexcept
+    {}
+    refcounted& operator=(const refcounted&) noexcept
+    {
+        return *this;
+    }
+    ~refcounted() = default;
+
+private:
+    mutable REFCOUNT m_count;
+};
+
+/// Tag to take over a reference without retaining it again
+struct adopt_ref_t
+{
+    explicit adopt_ref_t() = default;
+};
+
+inline constexpr adopt_ref_t adopt_ref{};
+
+/// Smart pointer to an object with an embedded reference count
+/// The count is changed through intrusive_retain(T*) and intrusive_release(T*), which are found by ADL, e.g. by
+///     deriving from refcounted or by wrapping the AddRef/Release functions of a C API
+template <typename T>
+class intrusive_ptr
+{
+public:
+    using element_type = T;
+
+    constexpr intrusive_ptr() noexcept = default;
+
+    constexpr intrusive_ptr(std::nullptr_t) noexcept
+    {}
+
+    /// Retains object, which already has to hold a reference
+    explicit intrusive_ptr(T* object) noexcept
+        : m_object{object}
+    {
+        if(m_object)
+            intrusive_retain(m_object);
+    }
+
+    /// Takes over the reference a new object starts with
+    intrusive_ptr(T* object, adopt_ref_t) noexcept
+        : m_object{object}
+    {}
+
+    intrusive_ptr(const intrusive_ptr& rhs) noexcept
+        : intrusive_ptr{rhs.m_object}
+    {}
+
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    intrusive_ptr(const intrusive_ptr<U>& rhs) noexcept
+        : intrusive_ptr{static_cast<T*>(rhs.get())}
+    {}
+
+    intrusive_ptr(intrusive_ptr&& rhs) noexcept
+        : m_object{std::exchange(rhs.m_object, nullptr)}
+    {}
+
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    intrusive_ptr(intrusive_ptr<U>&& rhs) noexcept
+        : m_object{rhs.detach()}
+    {}
+
+    intrusive_ptr& operator=(intrusive_ptr rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    ~intrusive_ptr()
+    {
+        if(m_object)
+            intrusive_release(m_object);
+    }
+
+    T* get() const noexcept { return m_object; }
+    T& operator*() const noexcept { return *m_object; }
+    T* operator->() const noexcept { return m_object; }
+    explicit operator bool() const noexcept { return m_object != nullptr; }
+
+    /// Gives up ownership of the reference without releasing it
+    T* detach() noexcept
+    {
+        return std::exchange(m_object, nullptr);
+    }
+
+    void reset() noexcept
+    {
+        intrusive_ptr{}.swap(*this);
+    }
+
+    void reset(T* object) noexcept
+    {
+        intrusive_ptr{object}.swap(*this);
+    }
+
+    void reset(T* object, adopt_ref_t) noexcept
+    {
+        intrusive_ptr{object, adopt_ref}.swap(*this);
+    }
+
+    void swap(intrusive_ptr& other) noexcept
+    {
+        std::swap(m_object, other.m_object);
+    }
+
+    friend bool operator==(const intrusive_ptr& lhs, const intrusive_ptr& rhs) noexcept
+    {
+        return lhs.m_object == rhs.m_object;
+    }
+
+    friend bool operator==(const intrusive_ptr& lhs, std::nullptr_t) noexcept
+    {
+        return lhs.m_object == nullptr;
+    }
+
+private:
+    T* m_object = nullptr;
+};
+
+/// Allocates a T whose initial reference is owned by the returned pointer
+template <typename T, typename ... ARGS>
+intrusive_ptr<T> make_intrusive(ARGS&& ... args)
+{
+    return intrusive_ptr<T>{new T(std::forward<ARGS>(args)...), adopt_ref};
+}
+
+} // namespace t_ut
+
+#endif
@@ -1,58 +1,379 @@
-#ifndef CPP_UTILITY_COW_HPP
-#define CPP_UTILITY_COW_HPP
+#ifndef CPP_UTILITY_RESULT_HPP
+#define CPP_UTILITY_RESULT_HPP
 
-#include <variant>
+#include <array>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 namespace t_ut
 {
 
+/// Tags to construct the ok or the error value of a result in place, also if both have the same type
+struct in_place_ok_t
+{
+    explicit in_place_ok_t() = default;
+};
+
+inline constexpr in_place_ok_t in_place_ok{};
+
+struct in_place_err_t
+{
+    explicit in_place_err_t() = default;
+};
+
+inline constexpr in_place_err_t in_place_err{};
+
+namespace internal
+{
+
+/// Default return type of result::match, the common type of both callbacks' results
+struct deduce_match_result
+{};
+
+template <typename RET, typename OK_FUNC, typename ERR_FUNC, typename OK_ARG, typename ERR_ARG>
+struct match_result
+{
+    using type = RET;
+};
+
+template <typename OK_FUNC, typename ERR_FUNC, typename OK_ARG, typename ERR_ARG>
+struct match_result<deduce_match_result, OK_FUNC, ERR_FUNC, OK_ARG, ERR_ARG>
+{
+    using type = std::common_type_t<std::invoke_result_t<OK_FUNC, OK_ARG>, std::invoke_result_t<ERR_FUNC, ERR_ARG>>;
+};
+
+} // namespace internal
+
 /// Basic implementation of a result type inspired by rusts result
+/// The ok and the error value share their storage next to a flag, so a result is as large as the larger of both plus
+///     the flag, and copying and destroying it is trivial if it is for both types
+/// Callbacks are template parameters and get inlined, nothing is type-erased or allocated
+/// ok() and err() require the result to hold that value, value_or() and match() work on both
 template <typename OK, typename ERR>
 class result
 {
+    static_assert(std::is_object_v<OK> && std::is_object_v<ERR>, "result holds neither references nor void");
+
+    static constexpr bool trivially_copyable = std::is_trivially_copy_constructible_v<OK>
+        && std::is_trivially_copy_constructible_v<ERR> && std::is_trivially_copy_assignable_v<OK>
+        && std::is_trivially_copy_assignable_v<ERR> && std::is_trivially_destructible_v<OK>
+        && std::is_trivially_destructible_v<ERR>;
+    static constexpr bool trivially_movable = std::is_trivially_move_constructible_v<OK>
+        && std::is_trivially_move_constructible_v<ERR> && std::is_trivially_move_assignable_v<OK>
+        && std::is_trivially_move_assignable_v<ERR> && std::is_trivially_destructible_v<OK>
+        && std::is_trivially_destructible_v<ERR>;
+    // Switching between ok and error destroys the old value before constructing the new one, that must not throw
+    static constexpr bool nothrow_movable =
+        std::is_nothrow_move_constructible_v<OK> && std::is_nothrow_move_constructible_v<ERR>;
+    // A small result is returned in registers, leftover bytes behind the smaller value would have to be carried along
+    static constexpr size_t storage_size = sizeof(OK) > sizeof(ERR) ? sizeof(OK) : sizeof(ERR);
+    static constexpr bool clear_padding = sizeof(OK) != sizeof(ERR) && storage_size <= 2 * sizeof(void*);
+
 public:
     using ok_type = OK;
     using err_type = ERR;
 
-    result(const ok_type& ok)
-        : m_data{ok}
+    constexpr result(const ok_type& ok) requires (!std::is_same_v<OK, ERR>)
+        : result{in_place_ok, ok}
+    {}
+
+    constexpr result(ok_type&& ok) requires (!std::is_same_v<OK, ERR>)
+        : result{in_place_ok, std::move(ok)}
+    {}
+
+    // Templates with the type fixed to ERR, otherwise they would redeclare the ok constructors if OK is ERR
+    template <typename E = ERR>
+        requires (!std::is_same_v<OK, E>)
+    constexpr result(const std::type_identity_t<E>& err)
+        : result{in_place_err, err}
     {}
 
-    result(const err_type& err)
-        : m_data{err}
+    template <typename E = ERR>
+        requires (!std::is_same_v<OK, E>)
+    constexpr result(std::type_identity_t<E>&& err)
+        : result{in_place_err, std::move(err)}
     {}
 
-    bool is_ok() const
+    template <typename ... ARGS>
+    constexpr explicit result(in_place_ok_t, ARGS&& ... args)
+        : m_is_ok{true}
     {
-        return std::holds_alternative<ok_type>(m_data);
+        clear_storage();
+        std::construct_at(&m_ok, std::forward<ARGS>(args)...);
     }
 
-    bool is_err() const
+    template <typename ... ARGS>
+    constexpr explicit result(in_place_err_t, ARGS&& ... args)
+        : m_is_ok{false}
     {
-        return !is_ok();
+        clear_storage();
+        std::construct_at(&m_err, std::forward<ARGS>(args)...);
+    }
+
+    constexpr result(const result&) requires trivially_copyable = default;
+
+    constexpr result(const result& rhs)
+        requires (!trivially_copyable && std::is_copy_constructible_v<OK> && std::is_copy_constructible_v<ERR>)
+        : m_is_ok{rhs.m_is_ok}
+    {
+        construct_from(rhs);
+    }
+
+    constexpr result(result&&) requires trivially_movable = default;
+
+    constexpr result(result&& rhs) noexcept(nothrow_movable)
+        requires (!trivially_movable && std::is_move_constructible_v<OK> && std::is_move_constructible_v<ERR>)
+        : m_is_ok{rhs.m_is_ok}
+    {
+        construct_from(std::move(rhs));
     }
 
-    template <typename RET>
-    RET match(const std::function<RET(const OK&)>& ok_cb, const std::function<RET(const ERR&)>& err_cb) const
+    constexpr result& operator=(const result&) requires trivially_copyable = default;
+
+    constexpr result& operator=(const result& rhs)
+        requires (!trivially_copyable && nothrow_movable && std::is_copy_constructible_v<OK>
+            && std::is_copy_constructible_v<ERR> && std::is_copy_assignable_v<OK> && std::is_copy_assignable_v<ERR>)
     {
-        if(is_ok())
-            return ok_cb(std::get<ok_type>(m_data));
+        if(m_is_ok == rhs.m_is_ok)
+            assign_from(rhs);
         else
-            return err_cb(std::get<err_type>(m_data));
+            switch_to(result{rhs});
+        return *this;
     }
 
-    template <typename RET>
-    RET match(const std::function<RET(OK&)>& ok_cb, const std::function<RET(ERR&)>& err_cb)
+    constexpr result& operator=(result&&) requires trivially_movable = default;
+
+    constexpr result& operator=(result&& rhs) noexcept(
+        nothrow_movable && std::is_nothrow_move_assignable_v<OK> && std::is_nothrow_move_assignable_v<ERR>)
+        requires (!trivially_movable && nothrow_movable && std::is_move_assignable_v<OK>
+            && std::is_move_assignable_v<ERR>)
     {
-        if(is_ok())
-            return ok_cb(std::get<ok_type>(m_data));
+        if(m_is_ok == rhs.m_is_ok)
+            assign_from(std::move(rhs));
         else
-            return err_cb(std::get<err_type>(m_data));
+            switch_to(std::move(rhs));
+        return *this;
+    }
+
+    constexpr ~result() requires (std::is_trivially_destructible_v<OK> && std::is_trivially_destructible_v<ERR>)
+        = default;
+
+    constexpr ~result()
+    {
+        destroy();
+    }
+
+    constexpr bool is_ok() const noexcept
+    {
+        return m_is_ok;
+    }
+
+    constexpr bool is_err() const noexcept
+    {
+        return !is_ok();
+    }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return is_ok();
+    }
+
+    constexpr ok_type& ok() & noexcept { return m_ok; }
+    constexpr const ok_type& ok() const& noexcept { return m_ok; }
+    constexpr ok_type&& ok() && noexcept { return std::move(m_ok); }
+
+    constexpr err_type& err() & noexcept { return m_err; }
+    constexpr const err_type& err() const& noexcept { return m_err; }
+    constexpr err_type&& err() && noexcept { return std::move(m_err); }
+
+    /// The ok value or fallback if this is an error
+    template <typename U>
+    constexpr ok_type value_or(U&& fallback) const&
+    {
+        return m_is_ok ? m_ok : static_cast<ok_type>(std::forward<U>(fallback));
+    }
+
+    template <typename U>
+    constexpr ok_type value_or(U&& fallback) &&
+    {
+        return m_is_ok ? std::move(m_ok) : static_cast<ok_type>(std::forward<U>(fallback));
+    }
+
+    /// Calls ok_func with the ok value or err_func with the error and returns what it returned
+    /// RET defaults to the common type of both callbacks' results
+    template <typename RET = internal::deduce_match_result, typename OK_FUNC, typename ERR_FUNC>
+    constexpr decltype(auto) match(OK_FUNC&& ok_func, ERR_FUNC&& err_func) &
+    {
+        return match<RET>(*this, std::forward<OK_FUNC>(ok_func), std::forward<ERR_FUNC>(err_func));
+    }
+
+    template <typename RET = internal::deduce_match_result, typename OK_FUNC, typename ERR_FUNC>
+    constexpr decltype(auto) match(OK_FUNC&& ok_func, ERR_FUNC&& err_func) const&
+    {
+        return match<RET>(*this, std::forward<OK_FUNC>(ok_func), std::forward<ERR_FUNC>(err_func));
+    }
+
+    template <typename RET = internal::deduce_match_result, typename OK_FUNC, typename ERR_FUNC>
+    constexpr decltype(auto) match(OK_FUNC&& ok_func, ERR_FUNC&& err_func) &&
+    {
+        return match<RET>(std::move(*this), std::forward<OK_FUNC>(ok_func), std::forward<ERR_FUNC>(err_func));
+    }
+
+    /// result<U, ERR> with U = func(ok value), the error is passed on unchanged
+    template <typename FUNC>
+    constexpr auto map(FUNC&& func) const&
+    {
+        return map(*this, std::forward<FUNC>(func));
+    }
+
+    template <typename FUNC>
+    constexpr auto map(FUNC&& func) &&
+    {
+        return map(std::move(*this), std::forward<FUNC>(func));
+    }
+
+    /// result<OK, F> with F = func(error), the ok value is passed on unchanged
+    template <typename FUNC>
+    constexpr auto map_err(FUNC&& func) const&
+    {
+        return map_err(*this, std::forward<FUNC>(func));
+    }
+
+    template <typename FUNC>
+    constexpr auto map_err(FUNC&& func) &&
+    {
+        return map_err(std::move(*this), std::forward<FUNC>(func));
+    }
+
+    /// func(ok value), which returns a result<U, ERR>, or the error
+    template <typename FUNC>
+    constexpr auto and_then(FUNC&& func) const&
+    {
+        return and_then(*this, std::forward<FUNC>(func));
+    }
+
+    template <typename FUNC>
+    constexpr auto and_then(FUNC&& func) &&
+    {
+        return and_then(std::move(*this), std::forward<FUNC>(func));
+    }
+
+    /// func(error), which returns a result<OK, F>, or the ok value
+    template <typename FUNC>
+    constexpr auto or_else(FUNC&& func) const&
+    {
+        return or_else(*this, std::forward<FUNC>(func));
+    }
+
+    template <typename FUNC>
+    constexpr auto or_else(FUNC&& func) &&
+    {
+        return or_else(std::move(*this), std::forward<FUNC>(func));
     }
 
 private:
-    std::variant<ok_type, err_type> m_data;
+    template <typename RET, typename SELF, typename OK_FUNC, typename ERR_FUNC>
+    static constexpr auto match(SELF&& self, OK_FUNC&& ok_func, ERR_FUNC&& err_func) ->
+        typename internal::match_result<RET, OK_FUNC, ERR_FUNC, decltype((std::forward<SELF>(self).m_ok)),
+            decltype((std::forward<SELF>(self).m_err))>::type
+    {
+        using return_type = typename internal::match_result<RET, OK_FUNC, ERR_FUNC,
+            decltype((std::forward<SELF>(self).m_ok)), decltype((std::forward<SELF>(self).m_err))>::type;
+        if(self.m_is_ok)
+            return static_cast<return_type>(std::invoke(std::forward<OK_FUNC>(ok_func), std::forward<SELF>(self).m_ok));
+        return static_cast<return_type>(std::invoke(std::forward<ERR_FUNC>(err_func), std::forward<SELF>(self).m_err));
+    }
+
+    template <typename SELF, typename FUNC>
+    static constexpr auto map(SELF&& self, FUNC&& func)
+    {
+        using value_type = std::remove_cvref_t<std::invoke_result_t<FUNC, decltype((std::forward<SELF>(self).m_ok))>>;
+        using result_type = result<value_type, ERR>;
+        if(self.m_is_ok)
+            return result_type{in_place_ok, std::invoke(std::forward<FUNC>(func), std::forward<SELF>(self).m_ok)};
+        return result_type{in_place_err, std::forward<SELF>(self).m_err};
+    }
+
+    template <typename SELF, typename FUNC>
+    static constexpr auto map_err(SELF&& self, FUNC&& func)
+    {
+        using error_type = std::remove_cvref_t<std::invoke_result_t<FUNC, decltype((std::forward<SELF>(self).m_err))>>;
+        using result_type = result<OK, error_type>;
+        if(self.m_is_ok)
+            return result_type{in_place_ok, std::forward<SELF>(self).m_ok};
+        return result_type{in_place_err, std::invoke(std::forward<FUNC>(func), std::forward<SELF>(self).m_err)};
+    }
+
+    template <typename SELF, typename FUNC>
+    static constexpr auto and_then(SELF&& self, FUNC&& func)
+    {
+        using result_type = std::remove_cvref_t<std::invoke_result_t<FUNC, decltype((std::forward<SELF>(self).m_ok))>>;
+        static_assert(std::is_same_v<typename result_type::err_type, ERR>, "and_then has to keep the error type");
+        if(self.m_is_ok)
+            return std::invoke(std::forward<FUNC>(func), std::forward<SELF>(self).m_ok);
+        return result_type{in_place_err, std::forward<SELF>(self).m_err};
+    }
+
+    template <typename SELF, typename FUNC>
+    static constexpr auto or_else(SELF&& self, FUNC&& func)
+    {
+        using result_type = std::remove_cvref_t<std::invoke_result_t<FUNC, decltype((std::forward<SELF>(self).m_err))>>;
+        static_assert(std::is_same_v<typename result_type::ok_type, OK>, "or_else has to keep the ok type");
+        if(self.m_is_ok)
+            return result_type{in_place_ok, std::forward<SELF>(self).m_ok};
+        return std::invoke(std::forward<FUNC>(func), std::forward<SELF>(self).m_err);
+    }
+
+    /// Constructs the value of rhs, m_is_ok is already set
+    template <typename RESULT>
+    constexpr void construct_from(RESULT&& rhs)
+    {
+        if(m_is_ok)
+            std::construct_at(&m_ok, std::forward<RESULT>(rhs).m_ok);
+        else
+            std::construct_at(&m_err, std::forward<RESULT>(rhs).m_err);
+    }
+
+    template <typename RESULT>
+    constexpr void assign_from(RESULT&& rhs)
+    {
+        if(m_is_ok)
+            m_ok = std::forward<RESULT>(rhs).m_ok;
+        else
+            m_err = std::forward<RESULT>(rhs).m_err;
+    }
+
+    constexpr void switch_to(result&& rhs) noexcept
+    {
+        destroy();
+        m_is_ok = rhs.m_is_ok;
+        construct_from(std::move(rhs));
+    }
+
+    constexpr void clear_storage() noexcept
+    {
+        if constexpr(clear_padding)
+            std::construct_at(&m_storage);
+    }
+
+    constexpr void destroy() noexcept
+    {
+        if(m_is_ok)
+            std::destroy_at(&m_ok);
+        else
+            std::destroy_at(&m_err);
+    }
+
+    union
+    {
+        std::array<unsigned char, storage_size> m_storage;
+        ok_type m_ok;
+        err_type m_err;
+    };
+    bool m_is_ok;
 };
 
 } // namespace t_ut
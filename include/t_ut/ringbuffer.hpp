@@ -2,10 +2,15 @@
 #define CPP_UTILITY_RINGBUFFER_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
 #include <optional>
 #include <type_traits>
 #include <stdexcept>
 
+#include "cache_line.hpp"
+
 namespace t_ut {
 
 /// Simple ringbuffer class with a static size
@@ -171,14 +176,14 @@ public:
         // Check if we need to update the read position in case of overrun
         if((m_write + 1) % buffer_size == m_read)
         {
-            // Overrun
-            new(&m_buffer[m_write]) value_type{std::move(in)};
-            advance();
-            m_write = (m_write + 1) % buffer_size;
+            // Overrun, drop the oldest element
             if constexpr(!std::is_trivially_destructible<value_type>())
             {
                 reinterpret_cast<reference>(m_buffer[m_read]).~value_type();
             }
+            advance();
+            new(&m_buffer[m_write]) value_type{in};
+            m_write = (m_write + 1) % buffer_size;
             return true;
         }
         else
@@ -195,20 +200,20 @@ public:
         // Check if we need to update the read position in case of overrun
         if((m_write + 1) % buffer_size == m_read)
         {
-            // Overrun
-            new(&m_buffer[m_write]) value_type{std::forward<construction_types>(args)...};
-            advance();
-            m_write = (m_write + 1) % buffer_size;
+            // Overrun, drop the oldest element
             if constexpr(!std::is_trivially_destructible<value_type>())
             {
                 reinterpret_cast<reference>(m_buffer[m_read]).~value_type();
             }
+            advance();
+            new(&m_buffer[m_write]) value_type{std::forward<construction_types>(args)...};
+            m_write = (m_write + 1) % buffer_size;
             return true;
         }
         else
         {
             // No overrun
-            emplace(std::forward<construction_types>(args)...);
+            emplace_back(std::forward<construction_types>(args)...);
             return false;
         }
     }
@@ -262,6 +267,126 @@ private:
     std::aligned_storage_t<sizeof(value_type), alignof(value_type)> m_buffer[buffer_size];
 };
 
+/// Lock-free ringbuffer for exactly one producer and one consumer thread
+/// Buffer can store up to SIZE - 1 elements, try_push fails instead of throwing when the buffer is full
+template <typename value_type, size_t buffer_size>
+class spsc_ringbuffer
+{
+    static_assert(buffer_size > 1, "spsc_ringbuffer needs room for at least one element");
+
+public:
+    using size_type = size_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+
+    spsc_ringbuffer() = default;
+
+    spsc_ringbuffer(const spsc_ringbuffer&) = delete;
+    spsc_ringbuffer& operator=(const spsc_ringbuffer&) = delete;
+
+    ~spsc_ringbuffer()
+    {
+        if constexpr(!std::is_trivially_destructible<value_type>())
+        {
+            size_type read = m_read.load(std::memory_order_relaxed);
+            const size_type write = m_write.load(std::memory_order_relaxed);
+            while(read != write)
+            {
+                element(read)->~value_type();
+                read = (read + 1) % buffer_size;
+            }
+        }
+    }
+
+    constexpr size_type capacity() const
+    {
+        return buffer_size - 1;
+    }
+
+    /// Only exact when called from the producer or consumer thread while the other side is idle
+    size_type size() const
+    {
+        const size_type write = m_write.load(std::memory_order_acquire);
+        const size_type read = m_read.load(std::memory_order_acquire);
+        return (write + buffer_size - read) % buffer_size;
+    }
+
+    bool empty() const
+    {
+        return m_read.load(std::memory_order_acquire) == m_write.load(std::memory_order_acquire);
+    }
+
+    /// Producer side
+    bool try_push(const_reference in)
+    {
+        return try_emplace(in);
+    }
+
+    bool try_push(value_type&& in)
+    {
+        return try_emplace(std::move(in));
+    }
+
+    template<typename ... construction_types>
+    bool try_emplace(construction_types&& ... args)
+    {
+        const size_type write = m_write.load(std::memory_order_relaxed);
+        const size_type next = (write + 1) % buffer_size;
+        if(next == m_cached_read)
+        {
+            m_cached_read = m_read.load(std::memory_order_acquire);
+            if(next == m_cached_read)
+            {
+                return false;
+            }
+        }
+
+        new(&m_buffer[write]) value_type{std::forward<construction_types>(args)...};
+        m_write.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer side
+    std::optional<value_type> try_pop()
+    {
+        const size_type read = m_read.load(std::memory_order_relaxed);
+        if(read == m_cached_write)
+        {
+            m_cached_write = m_write.load(std::memory_order_acquire);
+            if(read == m_cached_write)
+            {
+                return std::nullopt;
+            }
+        }
+
+        value_type elem = std::move(*element(read));
+        if constexpr(!std::is_trivially_destructible<value_type>())
+        {
+            element(read)->~value_type();
+        }
+        m_read.store((read + 1) % buffer_size, std::memory_order_release);
+        return elem;
+    }
+
+private:
+    pointer element(size_type index)
+    {
+        return std::launder(reinterpret_cast<pointer>(std::addressof(m_buffer[index])));
+    }
+
+    // Producer owned: the write position and the last read position it has seen
+    alignas(internal::cache_line_size) std::atomic<size_type> m_write = 0;
+    size_type m_cached_read = 0;
+
+    // Consumer owned: the read position and the last write position it has seen
+    alignas(internal::cache_line_size) std::atomic<size_type> m_read = 0;
+    size_type m_cached_write = 0;
+
+    alignas(internal::cache_line_size) std::aligned_storage_t<sizeof(value_type), alignof(value_type)>
+        m_buffer[buffer_size];
+};
+
 } // namespace t_ut
 
 #endif
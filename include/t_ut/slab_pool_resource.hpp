@@ -0,0 +1,235 @@
+#ifndef CPP_UTILITY_SLAB_POOL_RESOURCE_HPP
+#define CPP_UTILITY_SLAB_POOL_RESOURCE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "thread_cache.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+inline constexpr size_t slab_min_block = 8;
+inline constexpr size_t slab_class_count = 8;
+inline constexpr size_t slab_max_block = slab_min_block << (slab_class_count - 1);
+inline constexpr size_t slab_size = size_t{64} * 1024;
+/// Blocks moved between a thread and the depot at once, a thread keeps at most twice as many per size class
+inline constexpr size_t slab_batch = 32;
+
+/// Blocks of size class c are 8 << c bytes and aligned to their size
+inline size_t slab_size_class(size_t bytes, size_t alignment) noexcept
+{
+    const size_t size = std::max({bytes, alignment, slab_min_block});
+    return static_cast<size_t>(std::bit_width(size - 1)) - std::bit_width(slab_min_block - 1);
+}
+
+struct slab_block
+{
+    slab_block* next;
+};
+
+struct slab_free_list
+{
+    void push(slab_block* block) noexcept
+    {
+        block->next = head;
+        head = block;
+        ++count;
+    }
+
+    slab_block* pop() noexcept
+    {
+        slab_block* block = head;
+        head = block->next;
+        --count;
+        return block;
+    }
+
+    slab_block* head = nullptr;
+    size_t count = 0;
+};
+
+/// Memory shared by all threads of a slab_pool_resource: the slabs taken from upstream and the blocks threads gave back
+/// Thread caches keep it alive, so blocks that are still cached when the resource is destroyed stay valid
+class slab_depot : public cached_depot
+{
+public:
+    explicit slab_depot(std::pmr::memory_resource* upstream) noexcept
+        : m_upstream{upstream}
+    {}
+
+    slab_depot(const slab_depot&) = delete;
+    slab_depot& operator=(const slab_depot&) = delete;
+
+    ~slab_depot()
+    {
+        for(void* slab : m_slabs)
+            m_upstream->deallocate(slab, slab_size, slab_max_block);
+    }
+
+    std::pmr::memory_resource* upstream() const noexcept
+    {
+        return m_upstream;
+    }
+
+    /// Moves up to slab_batch blocks of size_class into list, carving new ones from a slab if none were given back
+    void refill(size_t size_class, slab_free_list& list)
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        slab_free_list& free = m_free[size_class];
+        if(free.count > 0)
+        {
+            for(size_t i = 0; i < slab_batch && free.count > 0; ++i)
+                list.push(free.pop());
+            return;
+        }
+
+        const size_t block_size = slab_min_block << size_class;
+        m_bump += (block_size - reinterpret_cast<uintptr_t>(m_bump)) & (block_size - 1);
+        if(m_bump + block_size > m_bump_end)
+        {
+            // Make room first so that push_back can not throw and leak the slab, doubling keeps the growth linear
+            if(m_slabs.size() == m_slabs.capacity())
+                m_slabs.reserve(std::max<size_t>(8, 2 * m_slabs.capacity()));
+            m_bump = static_cast<std::byte*>(m_upstream->allocate(slab_size, slab_max_block));
+            m_bump_end = m_bump + slab_size;
+            m_slabs.push_back(m_bump);
+        }
+
+        for(size_t i = 0; i < slab_batch && m_bump + block_size <= m_bump_end; ++i, m_bump += block_size)
+            list.push(reinterpret_cast<slab_block*>(m_bump));
+    }
+
+    /// Takes count blocks from the front of list
+    void give_back(size_t size_class, slab_free_list& list, size_t count) noexcept
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        for(size_t i = 0; i < count; ++i)
+            m_free[size_class].push(list.pop());
+    }
+
+private:
+    std::pmr::memory_resource* m_upstream;
+
+    std::mutex m_mutex;
+    std::array<slab_free_list, slab_class_count> m_free;
+    std::vector<void*> m_slabs;
+    std::byte* m_bump = nullptr;
+    std::byte* m_bump_end = nullptr;
+};
+
+/// Free blocks of one slab_pool_resource held by a thread
+struct slab_thread_cache
+{
+    explicit slab_thread_cache(slab_depot&) noexcept
+    {}
+
+    void flush(slab_depot& depot) noexcept
+    {
+        for(size_t c = 0; c < slab_class_count; ++c)
+            depot.give_back(c, lists[c], lists[c].count);
+    }
+
+    std::array<slab_free_list, slab_class_count> lists;
+};
+
+using slab_thread_caches = thread_caches<slab_depot, slab_thread_cache>;
+
+} // namespace internal
+
+/// Pool of small blocks in power of two size classes from 8 to 1024 bytes, carved from 64 KiB slabs
+/// Every thread keeps its own free lists, so allocations and deallocations normally take no lock and threads do not
+///     contend on the heap. Blocks move between threads and the shared depot in batches, so memory allocated on one
+///     thread and freed on another, e.g. jobs of a thread_pool, flows back instead of piling up
+/// Larger or more strictly aligned requests go to the upstream resource, which has to be thread safe
+/// The slabs are returned upstream once the resource is gone and every thread that used it exited or used any
+///     slab_pool_resource again
+class slab_pool_resource final : public std::pmr::memory_resource
+{
+public:
+    slab_pool_resource()
+        : slab_pool_resource{std::pmr::get_default_resource()}
+    {}
+
+    explicit slab_pool_resource(std::pmr::memory_resource* upstream)
+        : m_depot{std::make_shared<internal::slab_depot>(upstream)}
+    {}
+
+    slab_pool_resource(const slab_pool_resource&) = delete;
+    slab_pool_resource& operator=(const slab_pool_resource&) = delete;
+
+    ~slab_pool_resource() override
+    {
+        m_depot->close();
+        if(auto* caches = internal::slab_thread_caches::local())
+            caches->drop(m_depot.get());
+    }
+
+    std::pmr::memory_resource* upstream_resource() const noexcept
+    {
+        return m_depot->upstream();
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        if(bytes > internal::slab_max_block || alignment > internal::slab_max_block)
+            return m_depot->upstream()->allocate(bytes, alignment);
+
+        const size_t size_class = internal::slab_size_class(bytes, alignment);
+        auto* caches = internal::slab_thread_caches::local();
+        if(!caches)
+        {
+            internal::slab_free_list list;
+            m_depot->refill(size_class, list);
+            void* result = list.pop();
+            m_depot->give_back(size_class, list, list.count);
+            return result;
+        }
+
+        auto& list = caches->find(m_depot).lists[size_class];
+        if(list.count == 0)
+            m_depot->refill(size_class, list);
+        return list.pop();
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+    {
+        if(bytes > internal::slab_max_block || alignment > internal::slab_max_block)
+            return m_depot->upstream()->deallocate(ptr, bytes, alignment);
+
+        const size_t size_class = internal::slab_size_class(bytes, alignment);
+        auto* caches = internal::slab_thread_caches::local();
+        if(!caches)
+        {
+            internal::slab_free_list list;
+            list.push(static_cast<internal::slab_block*>(ptr));
+            m_depot->give_back(size_class, list, 1);
+            return;
+        }
+
+        auto& list = caches->find(m_depot).lists[size_class];
+        list.push(static_cast<internal::slab_block*>(ptr));
+        if(list.count > 2 * internal::slab_batch)
+            m_depot->give_back(size_class, list, internal::slab_batch);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::shared_ptr<internal::slab_depot> m_depot;
+};
+
+} // namespace t_ut
+
+#endif
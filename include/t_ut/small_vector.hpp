@@ -0,0 +1,640 @@
+#ifndef CPP_UTILITY_SMALL_VECTOR_HPP
+#define CPP_UTILITY_SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include "static_vector.hpp"
+
+namespace t_ut {
+
+/// Vector that stores up to N elements inline and moves them to a heap buffer with geometric growth afterwards
+/// Has the same interface as static_vector and only allocates once more than N elements are stored
+/// Like std::vector, growing invalidates all iterators and moving a heap backed vector keeps them valid
+/// The allocator is only used for the heap buffer, elements are constructed in place
+template <typename T, size_t N, typename Allocator = std::allocator<T>>
+class small_vector
+{
+    static_assert(N > 0, "small_vector with inline capacity 0 is not allowed, use std::vector instead");
+
+    static constexpr bool trivially_copyable = std::is_trivially_copyable_v<T>;
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+public:
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    small_vector() noexcept(std::is_nothrow_default_constructible_v<allocator_type>)
+    {}
+
+    explicit small_vector(const allocator_type& alloc) noexcept
+        : m_alloc{alloc}
+    {}
+
+    small_vector(size_type count, const_reference val = value_type{}, const allocator_type& alloc = allocator_type{})
+        : m_alloc{alloc}
+    {
+        assign(count, val);
+    }
+
+    template <std::input_iterator input_it>
+    small_vector(input_it first, input_it last, const allocator_type& alloc = allocator_type{})
+        : m_alloc{alloc}
+    {
+        assign(first, last);
+    }
+
+    small_vector(std::initializer_list<value_type> init, const allocator_type& alloc = allocator_type{})
+        : m_alloc{alloc}
+    {
+        assign(init.begin(), init.end());
+    }
+
+    small_vector(const small_vector& rhs)
+        : m_alloc{alloc_traits::select_on_container_copy_construction(rhs.m_alloc)}
+    {
+        assign(rhs.begin(), rhs.end());
+    }
+
+    small_vector(small_vector&& rhs) noexcept(std::is_nothrow_move_constructible_v<value_type>)
+        : m_alloc{std::move(rhs.m_alloc)}
+    {
+        take(rhs);
+    }
+
+    small_vector& operator=(const small_vector& rhs)
+    {
+        if(this != &rhs)
+        {
+            if constexpr(alloc_traits::propagate_on_container_copy_assignment::value)
+            {
+                if(m_alloc != rhs.m_alloc)
+                {
+                    release();
+                }
+                m_alloc = rhs.m_alloc;
+            }
+            assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    /// Allocates, and is not noexcept, if the allocators are unequal and rhs keeps its own, like std::vector
+    small_vector& operator=(small_vector&& rhs) noexcept(std::is_nothrow_move_constructible_v<value_type>
+        && (alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value))
+    {
+        if(this != &rhs)
+        {
+            if constexpr(alloc_traits::propagate_on_container_move_assignment::value)
+            {
+                release();
+                m_alloc = std::move(rhs.m_alloc);
+                take(rhs);
+            }
+            else if(m_alloc == rhs.m_alloc)
+            {
+                release();
+                take(rhs);
+            }
+            else
+            {
+                // Buffers of unequal allocators can not be stolen
+                assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+                rhs.clear();
+            }
+        }
+        return *this;
+    }
+
+    ~small_vector()
+    {
+        release();
+    }
+
+    void assign(size_type count, const_reference val)
+    {
+        // val might be an element of this vector
+        const value_type copy = val;
+        clear();
+        reserve(count);
+        std::uninitialized_fill_n(m_begin, count, copy);
+        m_size = count;
+    }
+
+    template <std::input_iterator input_it>
+    void assign(input_it first, input_it last)
+    {
+        clear();
+        if constexpr(std::forward_iterator<input_it>)
+        {
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            reserve(count);
+            copy_to(m_begin, first, count);
+            m_size = count;
+        }
+        else
+        {
+            while(first != last)
+            {
+                emplace_back(*first++);
+            }
+        }
+    }
+
+    void assign(std::initializer_list<value_type> init)
+    {
+        assign(init.begin(), init.end());
+    }
+
+    allocator_type get_allocator() const
+    {
+        return m_alloc;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    size_type max_size() const
+    {
+        return std::min<size_type>(alloc_traits::max_size(m_alloc), std::numeric_limits<difference_type>::max());
+    }
+
+    size_type capacity() const
+    {
+        return m_capacity;
+    }
+
+    static constexpr size_type inline_capacity()
+    {
+        return N;
+    }
+
+    /// True as long as the elements are stored in the inline buffer
+    bool is_inline() const
+    {
+        return m_begin == m_storage.data;
+    }
+
+    void reserve(size_type new_capacity)
+    {
+        if(new_capacity > m_capacity)
+        {
+            reallocate(new_capacity);
+        }
+    }
+
+    /// Moves the elements back to the inline buffer if they fit or to a heap buffer of exactly size() elements
+    void shrink_to_fit()
+    {
+        if(is_inline() || m_size == m_capacity)
+        {
+            return;
+        }
+
+        if(m_size <= N)
+        {
+            pointer heap = m_begin;
+            const size_type heap_capacity = m_capacity;
+            relocate(heap, m_size, m_storage.data);
+            alloc_traits::deallocate(m_alloc, heap, heap_capacity);
+            m_begin = m_storage.data;
+            m_capacity = N;
+        }
+        else
+        {
+            reallocate(m_size);
+        }
+    }
+
+    void push_back(const_reference in)
+    {
+        emplace_back(in);
+    }
+
+    void push_back(value_type&& in)
+    {
+        emplace_back(std::move(in));
+    }
+
+    template <typename... T_ARGS>
+    reference emplace_back(T_ARGS&&... args)
+    {
+        if(m_size == m_capacity)
+        {
+            return grow_emplace_back(std::forward<T_ARGS>(args)...);
+        }
+        std::construct_at(m_begin + m_size, std::forward<T_ARGS>(args)...);
+        return m_begin[m_size++];
+    }
+
+    template <typename... T_ARGS>
+    iterator emplace(const_iterator position, T_ARGS&&... args)
+    {
+        const auto index = static_cast<size_type>(position - begin());
+        if(index == m_size)
+        {
+            emplace_back(std::forward<T_ARGS>(args)...);
+            return m_begin + index;
+        }
+
+        // Construct first, the arguments might refer to elements that get shifted or reallocated
+        value_type to_insert(std::forward<T_ARGS>(args)...);
+        if(m_size == m_capacity)
+        {
+            reallocate(next_capacity(m_size + 1));
+        }
+
+        const pointer pos = m_begin + index;
+        if constexpr(trivially_copyable)
+        {
+            std::memmove(static_cast<void*>(pos + 1), pos, (end() - pos) * sizeof(value_type));
+            std::construct_at(pos, std::move(to_insert));
+        }
+        else
+        {
+            std::construct_at(end(), std::move(back()));
+            std::move_backward(pos, end() - 1, end());
+            *pos = std::move(to_insert);
+        }
+        ++m_size;
+        return pos;
+    }
+
+    iterator insert(const_iterator input, const_reference to_insert)
+    {
+        return emplace(input, to_insert);
+    }
+
+    iterator insert(const_iterator input, value_type&& to_insert)
+    {
+        return emplace(input, std::move(to_insert));
+    }
+
+    template <std::forward_iterator input_it>
+    iterator insert(const_iterator input, input_it first, input_it last)
+    {
+        const auto index = static_cast<size_type>(input - begin());
+        const auto count = static_cast<size_type>(std::distance(first, last));
+        if(m_size + count > m_capacity)
+        {
+            reallocate(next_capacity(m_size + count));
+        }
+
+        const pointer pos = m_begin + index;
+        if constexpr(trivially_copyable)
+        {
+            std::memmove(static_cast<void*>(pos + count), pos, (end() - pos) * sizeof(value_type));
+            copy_to(pos, first, count);
+            m_size += count;
+        }
+        else
+        {
+            // Append the new elements and rotate them into place
+            const pointer old_end = end();
+            for(; first != last; ++first)
+            {
+                std::construct_at(m_begin + m_size, *first);
+                ++m_size;
+            }
+            std::rotate(pos, old_end, end());
+        }
+        return pos;
+    }
+
+    iterator insert(const_iterator input, std::initializer_list<value_type> init)
+    {
+        return insert(input, init.begin(), init.end());
+    }
+
+    void pop_back()
+    {
+        if(m_size > 0)
+        {
+            std::destroy_at(m_begin + --m_size);
+        }
+    }
+
+    iterator erase(const_iterator to_remove)
+    {
+        return erase(to_remove, to_remove + 1);
+    }
+
+    iterator erase(const_iterator to_remove, const_iterator end_remove)
+    {
+        const pointer first = m_begin + (to_remove - begin());
+        const pointer last = m_begin + (end_remove - begin());
+        const auto count = static_cast<size_type>(last - first);
+        if(count == 0)
+        {
+            return first;
+        }
+
+        if constexpr(trivially_copyable)
+        {
+            std::memmove(static_cast<void*>(first), last, (end() - last) * sizeof(value_type));
+        }
+        else
+        {
+            std::move(last, end(), first);
+            std::destroy(end() - count, end());
+        }
+        m_size -= count;
+        return first;
+    }
+
+    void clear()
+    {
+        std::destroy(begin(), end());
+        m_size = 0;
+    }
+
+    const_reference at(size_type index) const
+    {
+        if(index >= m_size)
+        {
+            throw std::out_of_range{""};
+        }
+        return operator[](index);
+    }
+
+    reference at(size_type index)
+    {
+        if(index >= m_size)
+        {
+            throw std::out_of_range{""};
+        }
+        return operator[](index);
+    }
+
+    const_reference operator[](size_type index) const
+    {
+        return m_begin[index];
+    }
+
+    reference operator[](size_type index)
+    {
+        return m_begin[index];
+    }
+
+    void swap(small_vector& other)
+    {
+        if(!is_inline() && !other.is_inline())
+        {
+            if constexpr(alloc_traits::propagate_on_container_swap::value)
+            {
+                std::swap(m_alloc, other.m_alloc);
+            }
+            std::swap(m_begin, other.m_begin);
+            std::swap(m_size, other.m_size);
+            std::swap(m_capacity, other.m_capacity);
+            return;
+        }
+
+        small_vector tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    const_reference front() const
+    {
+        return operator[](0);
+    }
+    reference front()
+    {
+        return operator[](0);
+    }
+
+    const_reference back() const
+    {
+        return operator[](m_size - 1);
+    }
+    reference back()
+    {
+        return operator[](m_size - 1);
+    }
+
+    const_iterator begin() const
+    {
+        return m_begin;
+    }
+    iterator begin()
+    {
+        return m_begin;
+    }
+
+    const_iterator end() const
+    {
+        return m_begin + m_size;
+    }
+    iterator end()
+    {
+        return m_begin + m_size;
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator{end()};
+    }
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator{end()};
+    }
+
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator{begin()};
+    }
+    reverse_iterator rend()
+    {
+        return reverse_iterator{begin()};
+    }
+
+    const_pointer data() const
+    {
+        return m_begin;
+    }
+    pointer data()
+    {
+        return m_begin;
+    }
+
+private:
+    size_type next_capacity(size_type required) const
+    {
+        if(required > max_size())
+        {
+            throw std::length_error{"small_vector exceeds max_size"};
+        }
+        return std::max(required, std::min(m_capacity * 2, max_size()));
+    }
+
+    /// Moves count elements from src to the uninitialized dst and destroys them in src
+    /// Elements whose move could throw are copied, so src is unchanged and dst empty if that throws, unless they
+    ///     cannot be copied either
+    static void relocate(pointer src, size_type count, pointer dst)
+    {
+        if constexpr(trivially_copyable)
+        {
+            if(count > 0)
+            {
+                std::memcpy(static_cast<void*>(dst), src, count * sizeof(value_type));
+            }
+        }
+        else
+        {
+            if constexpr(std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            {
+                std::uninitialized_move_n(src, count, dst);
+            }
+            else
+            {
+                std::uninitialized_copy_n(src, count, dst);
+            }
+            std::destroy_n(src, count);
+        }
+    }
+
+    /// Creates count elements from first at the uninitialized position dst
+    template <typename input_it>
+    static void copy_to(pointer dst, input_it first, size_type count)
+    {
+        if constexpr(trivially_copyable && std::contiguous_iterator<input_it>
+            && std::is_same_v<std::iter_value_t<input_it>, value_type>)
+        {
+            if(count > 0)
+            {
+                std::memcpy(static_cast<void*>(dst), std::to_address(first), count * sizeof(value_type));
+            }
+        }
+        else
+        {
+            std::uninitialized_copy_n(first, count, dst);
+        }
+    }
+
+    void reallocate(size_type new_capacity)
+    {
+        const pointer buffer = alloc_traits::allocate(m_alloc, new_capacity);
+        try
+        {
+            relocate(m_begin, m_size, buffer);
+        }
+        catch(...)
+        {
+            alloc_traits::deallocate(m_alloc, buffer, new_capacity);
+            throw;
+        }
+        if(!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_begin, m_capacity);
+        }
+        m_begin = buffer;
+        m_capacity = new_capacity;
+    }
+
+    template <typename... T_ARGS>
+    reference grow_emplace_back(T_ARGS&&... args)
+    {
+        // The new element is constructed before the old ones are moved since the arguments might refer to them
+        const size_type new_capacity = next_capacity(m_size + 1);
+        const pointer buffer = alloc_traits::allocate(m_alloc, new_capacity);
+        try
+        {
+            std::construct_at(buffer + m_size, std::forward<T_ARGS>(args)...);
+        }
+        catch(...)
+        {
+            alloc_traits::deallocate(m_alloc, buffer, new_capacity);
+            throw;
+        }
+
+        try
+        {
+            relocate(m_begin, m_size, buffer);
+        }
+        catch(...)
+        {
+            std::destroy_at(buffer + m_size);
+            alloc_traits::deallocate(m_alloc, buffer, new_capacity);
+            throw;
+        }
+        if(!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_begin, m_capacity);
+        }
+        m_begin = buffer;
+        m_capacity = new_capacity;
+        return m_begin[m_size++];
+    }
+
+    /// Destroys all elements and frees the heap buffer, leaves an empty inline vector
+    void release()
+    {
+        clear();
+        if(!is_inline())
+        {
+            alloc_traits::deallocate(m_alloc, m_begin, m_capacity);
+            m_begin = m_storage.data;
+            m_capacity = N;
+        }
+    }
+
+    /// Takes over the elements of rhs, whose allocator must be able to free its buffer, and leaves it empty
+    void take(small_vector& rhs)
+    {
+        if(rhs.is_inline())
+        {
+            relocate(rhs.m_begin, rhs.m_size, m_storage.data);
+            m_size = rhs.m_size;
+        }
+        else
+        {
+            m_begin = rhs.m_begin;
+            m_size = rhs.m_size;
+            m_capacity = rhs.m_capacity;
+            rhs.m_begin = rhs.m_storage.data;
+            rhs.m_capacity = N;
+        }
+        rhs.m_size = 0;
+    }
+
+    [[no_unique_address]] allocator_type m_alloc;
+    pointer m_begin = m_storage.data;
+    size_type m_size = 0;
+    size_type m_capacity = N;
+    internal::uninitialized_array<value_type, N> m_storage;
+};
+
+template <typename T, size_t N, typename Allocator>
+void swap(small_vector<T, N, Allocator>& lhs, small_vector<T, N, Allocator>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace t_ut
+
+#endif
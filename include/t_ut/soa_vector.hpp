@@ -0,0 +1,760 @@
+#ifndef CPP_UTILITY_SOA_VECTOR_HPP
+#define CPP_UTILITY_SOA_VECTOR_HPP
+
+#include <algorithm>
+#include <compare>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "cache_line.hpp"
+#include "span.hpp"
+#include "static_vector.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Every field array starts on its own cache line
+template <typename T>
+inline constexpr size_t soa_field_alignment = alignof(T) > cache_line_size ? alignof(T) : cache_line_size;
+
+/// Fixed capacity storage with one inline array per field
+template <size_t N, typename ... FIELDS>
+class soa_inline_storage
+{
+    static_assert(N > 0, "static_soa_vector with capacity 0 is not allowed");
+
+    template <typename T>
+    struct alignas(soa_field_alignment<T>) field_array
+    {
+        uninitialized_array<T, N> array;
+    };
+
+public:
+    static constexpr bool can_grow = false;
+
+    template <size_t I>
+    auto* data()
+    {
+        return std::get<I>(m_fields).array.data;
+    }
+
+    template <size_t I>
+    const auto* data() const
+    {
+        return std::get<I>(m_fields).array.data;
+    }
+
+    size_t capacity() const
+    {
+        return N;
+    }
+
+private:
+    std::tuple<field_array<FIELDS>...> m_fields;
+};
+
+/// Heap storage with one separately allocated and cache line aligned array per field
+template <typename ... FIELDS>
+class soa_heap_storage
+{
+public:
+    static constexpr bool can_grow = true;
+
+    soa_heap_storage() = default;
+    soa_heap_storage(const soa_heap_storage&) = delete;
+    soa_heap_storage& operator=(const soa_heap_storage&) = delete;
+
+    ~soa_heap_storage()
+    {
+        deallocate(m_fields, m_capacity);
+    }
+
+    template <size_t I>
+    auto* data()
+    {
+        return std::get<I>(m_fields);
+    }
+
+    template <size_t I>
+    const auto* data() const
+    {
+        return std::get<I>(m_fields);
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    /// Moves the first size elements of every field into new arrays with room for new_capacity elements
+    /// Fields whose move could throw are copied first, so the storage is unchanged if an allocation or copy throws
+    void reallocate(size_t new_capacity, size_t size)
+    {
+        std::tuple<FIELDS*...> fields{};
+        bool relocated[sizeof...(FIELDS)] = {};
+        [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            try
+            {
+                (allocate(std::get<Is>(fields), new_capacity), ...);
+                (relocate<false>(std::get<Is>(m_fields), size, std::get<Is>(fields), relocated[Is]), ...);
+            }
+            catch(...)
+            {
+                ((relocated[Is] ? void(std::destroy_n(std::get<Is>(fields), size)) : void()), ...);
+                deallocate(fields, new_capacity);
+                throw;
+            }
+            // Nothing can throw anymore, so the old elements are only moved from now
+            (relocate<true>(std::get<Is>(m_fields), size, std::get<Is>(fields), relocated[Is]), ...);
+            (std::destroy_n(std::get<Is>(m_fields), size), ...);
+        }(std::index_sequence_for<FIELDS...>{});
+
+        deallocate(m_fields, m_capacity);
+        m_fields = fields;
+        m_capacity = new_capacity;
+    }
+
+    void swap(soa_heap_storage& other) noexcept
+    {
+        std::swap(m_fields, other.m_fields);
+        std::swap(m_capacity, other.m_capacity);
+    }
+
+private:
+    template <typename T>
+    static void allocate(T*& field, size_t capacity)
+    {
+        field = static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t{soa_field_alignment<T>}));
+    }
+
+    template <typename T>
+    static constexpr bool nothrow_relocatable =
+        std::is_trivially_copyable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    /// Constructs the elements of the fields that are nothrow relocatable or not in dst, the source is destroyed later
+    template <bool NOTHROW, typename T>
+    static void relocate(T* src, size_t count, T* dst, bool& relocated)
+    {
+        if constexpr(nothrow_relocatable<T> != NOTHROW)
+        {
+            return;
+        }
+        else if constexpr(std::is_trivially_copyable_v<T>)
+        {
+            if(count > 0)
+            {
+                std::memcpy(static_cast<void*>(dst), src, count * sizeof(T));
+            }
+        }
+        else if constexpr(NOTHROW || !std::is_copy_constructible_v<T>)
+        {
+            // Only the basic guarantee for move only types whose move can throw
+            std::uninitialized_move_n(src, count, dst);
+        }
+        else
+        {
+            std::uninitialized_copy_n(src, count, dst);
+        }
+        relocated = true;
+    }
+
+    static void deallocate(std::tuple<FIELDS*...>& fields, size_t capacity)
+    {
+        if(capacity == 0)
+        {
+            return;
+        }
+
+        [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            (::operator delete(std::get<Is>(fields),
+                 capacity * sizeof(FIELDS),
+                 std::align_val_t{soa_field_alignment<FIELDS>}),
+                ...);
+        }(std::index_sequence_for<FIELDS...>{});
+    }
+
+    std::tuple<FIELDS*...> m_fields{};
+    size_t m_capacity = 0;
+};
+
+/// Random access iterator over a soa vector that yields tuples of references to the fields of one element
+template <typename CONTAINER, typename REFERENCE>
+class soa_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename std::remove_const_t<CONTAINER>::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = REFERENCE;
+    using pointer = void;
+
+    soa_iterator() = default;
+
+    soa_iterator(CONTAINER* container, size_t index)
+        : m_container{container}
+        , m_index{index}
+    {}
+
+    /// Conversion from iterator to const_iterator
+    template <typename OTHER, typename OTHER_REFERENCE,
+        typename = std::enable_if_t<std::is_same_v<const OTHER, CONTAINER> && !std::is_same_v<OTHER, CONTAINER>>>
+    soa_iterator(const soa_iterator<OTHER, OTHER_REFERENCE>& other)
+        : m_container{other.container()}
+        , m_index{other.index()}
+    {}
+
+    CONTAINER* container() const
+    {
+        return m_container;
+    }
+
+    size_t index() const
+    {
+        return m_index;
+    }
+
+    reference operator*() const
+    {
+        return (*m_container)[m_index];
+    }
+
+    reference operator[](difference_type n) const
+    {
+        return (*m_container)[m_index + n];
+    }
+
+    soa_iterator& operator++()
+    {
+        ++m_index;
+        return *this;
+    }
+
+    soa_iterator operator++(int)
+    {
+        soa_iterator tmp = *this;
+        ++m_index;
+        return tmp;
+    }
+
+    soa_iterator& operator--()
+    {
+        --m_index;
+        return *this;
+    }
+
+    soa_iterator operator--(int)
+    {
+        soa_iterator tmp = *this;
+        --m_index;
+        return tmp;
+    }
+
+    soa_iterator& operator+=(difference_type n)
+    {
+        m_index += n;
+        return *this;
+    }
+
+    soa_iterator& operator-=(difference_type n)
+    {
+        m_index -= n;
+        return *this;
+    }
+
+    friend soa_iterator operator+(soa_iterator it, difference_type n)
+    {
+        return it += n;
+    }
+
+    friend soa_iterator operator+(difference_type n, soa_iterator it)
+    {
+        return it += n;
+    }
+
+    friend soa_iterator operator-(soa_iterator it, difference_type n)
+    {
+        return it -= n;
+    }
+
+    friend difference_type operator-(const soa_iterator& lhs, const soa_iterator& rhs)
+    {
+        return static_cast<difference_type>(lhs.m_index) - static_cast<difference_type>(rhs.m_index);
+    }
+
+    friend bool operator==(const soa_iterator& lhs, const soa_iterator& rhs)
+    {
+        return lhs.m_index == rhs.m_index;
+    }
+
+    friend auto operator<=>(const soa_iterator& lhs, const soa_iterator& rhs)
+    {
+        return lhs.m_index <=> rhs.m_index;
+    }
+
+private:
+    CONTAINER* m_container = nullptr;
+    size_t m_index = 0;
+};
+
+} // namespace internal
+
+/// Structure of arrays container, every field is stored in its own contiguous and cache line aligned array
+/// Elements are accessed through tuples of references, e.g. auto [price, quantity] = vec[i];
+/// field<I>() returns a span over one field that loops can scan without touching the other fields
+/// Use static_soa_vector or soa_vector instead of naming this type directly
+template <typename STORAGE, typename ... FIELDS>
+class basic_soa_vector
+{
+    static_assert(sizeof...(FIELDS) > 0, "soa vector needs at least one field");
+
+    template <size_t I>
+    using field_type = std::tuple_element_t<I, std::tuple<FIELDS...>>;
+
+    using indices = std::index_sequence_for<FIELDS...>;
+
+public:
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::tuple<FIELDS...>;
+    using reference = std::tuple<FIELDS&...>;
+    using const_reference = std::tuple<const FIELDS&...>;
+    using iterator = internal::soa_iterator<basic_soa_vector, reference>;
+    using const_iterator = internal::soa_iterator<const basic_soa_vector, const_reference>;
+
+    basic_soa_vector() = default;
+
+    basic_soa_vector(std::initializer_list<value_type> init)
+    {
+        reserve(init.size());
+        for(const auto& values : init)
+        {
+            push_back(values);
+        }
+    }
+
+    basic_soa_vector(const basic_soa_vector& rhs)
+    {
+        copy_from(rhs);
+    }
+
+    basic_soa_vector(basic_soa_vector&& rhs) noexcept((std::is_nothrow_move_constructible_v<FIELDS> && ...))
+    {
+        move_from(rhs);
+    }
+
+    basic_soa_vector& operator=(const basic_soa_vector& rhs)
+    {
+        if(this != &rhs)
+        {
+            clear();
+            copy_from(rhs);
+        }
+        return *this;
+    }
+
+    basic_soa_vector& operator=(basic_soa_vector&& rhs) noexcept((std::is_nothrow_move_constructible_v<FIELDS> && ...))
+    {
+        if(this != &rhs)
+        {
+            clear();
+            move_from(rhs);
+        }
+        return *this;
+    }
+
+    ~basic_soa_vector()
+    {
+        clear();
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    size_type max_size() const
+    {
+        if constexpr(STORAGE::can_grow)
+        {
+            return static_cast<size_type>(std::numeric_limits<difference_type>::max()) / std::max({sizeof(FIELDS)...});
+        }
+        else
+        {
+            return m_storage.capacity();
+        }
+    }
+
+    size_type capacity() const
+    {
+        return m_storage.capacity();
+    }
+
+    /// Throws std::bad_alloc if the storage has a fixed capacity below new_capacity
+    void reserve(size_type new_capacity)
+    {
+        if(new_capacity <= capacity())
+        {
+            return;
+        }
+
+        if constexpr(STORAGE::can_grow)
+        {
+            m_storage.reallocate(new_capacity, m_size);
+        }
+        else
+        {
+            throw std::bad_alloc{};
+        }
+    }
+
+    /// Contiguous array of field I of all elements
+    template <size_t I>
+    field_type<I>* data()
+    {
+        return std::assume_aligned<internal::soa_field_alignment<field_type<I>>>(m_storage.template data<I>());
+    }
+
+    template <size_t I>
+    const field_type<I>* data() const
+    {
+        return std::assume_aligned<internal::soa_field_alignment<field_type<I>>>(m_storage.template data<I>());
+    }
+
+    template <size_t I>
+    span<field_type<I>> field()
+    {
+        return span<field_type<I>>{data<I>(), m_size};
+    }
+
+    template <size_t I>
+    span<const field_type<I>> field() const
+    {
+        return span<const field_type<I>>{data<I>(), m_size};
+    }
+
+    void push_back(const value_type& values)
+    {
+        std::apply([this](const FIELDS& ... fields) { emplace_back(fields...); }, values);
+    }
+
+    void push_back(value_type&& values)
+    {
+        std::apply([this](FIELDS& ... fields) { emplace_back(std::move(fields)...); }, values);
+    }
+
+    /// Takes one constructor argument per field
+    template <typename ... ARGS>
+    reference emplace_back(ARGS&& ... args)
+    {
+        static_assert(sizeof...(ARGS) == sizeof...(FIELDS), "emplace_back takes exactly one value per field");
+
+        if(m_size == capacity())
+        {
+            // The arguments might refer to elements of this vector, so create the values before growing
+            value_type values{std::forward<ARGS>(args)...};
+            reserve(next_capacity());
+            construct_at_end(std::move(values));
+        }
+        else
+        {
+            construct_at_end(std::forward_as_tuple(std::forward<ARGS>(args)...));
+        }
+        return (*this)[m_size++];
+    }
+
+    iterator insert(const_iterator position, const value_type& values)
+    {
+        return insert(position, value_type{values});
+    }
+
+    iterator insert(const_iterator position, value_type&& values)
+    {
+        const size_type index = position.index();
+        if(m_size == capacity())
+        {
+            reserve(next_capacity());
+        }
+
+        build_fields(
+            [&]<size_t I>(std::integral_constant<size_t, I>) {
+                insert_field(data<I>(), index, std::move(std::get<I>(values)));
+            },
+            [&]<size_t I>(std::integral_constant<size_t, I>) { erase_field(data<I>(), index, index + 1, m_size + 1); });
+        ++m_size;
+        return iterator{this, index};
+    }
+
+    void pop_back()
+    {
+        if(m_size > 0)
+        {
+            --m_size;
+            for_each_field([this](auto* field) { std::destroy_at(field + m_size); });
+        }
+    }
+
+    iterator erase(const_iterator to_remove)
+    {
+        return erase(to_remove, to_remove + 1);
+    }
+
+    iterator erase(const_iterator to_remove, const_iterator end_remove)
+    {
+        const size_type first = to_remove.index();
+        const size_type last = end_remove.index();
+        if(first != last)
+        {
+            for_each_field([&](auto* field) { erase_field(field, first, last, m_size); });
+            m_size -= last - first;
+        }
+        return iterator{this, first};
+    }
+
+    void clear()
+    {
+        for_each_field([this](auto* field) { std::destroy_n(field, m_size); });
+        m_size = 0;
+    }
+
+    const_reference at(size_type index) const
+    {
+        if(index >= m_size)
+        {
+            throw std::out_of_range{""};
+        }
+        return operator[](index);
+    }
+
+    reference at(size_type index)
+    {
+        if(index >= m_size)
+        {
+            throw std::out_of_range{""};
+        }
+        return operator[](index);
+    }
+
+    const_reference operator[](size_type index) const
+    {
+        return [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            return const_reference{data<Is>()[index]...};
+        }(indices{});
+    }
+
+    reference operator[](size_type index)
+    {
+        return [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            return reference{data<Is>()[index]...};
+        }(indices{});
+    }
+
+    void swap(basic_soa_vector& other)
+    {
+        if constexpr(STORAGE::can_grow)
+        {
+            m_storage.swap(other.m_storage);
+            std::swap(m_size, other.m_size);
+        }
+        else
+        {
+            basic_soa_vector tmp{std::move(other)};
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+
+    const_reference front() const
+    {
+        return operator[](0);
+    }
+    reference front()
+    {
+        return operator[](0);
+    }
+
+    const_reference back() const
+    {
+        return operator[](m_size - 1);
+    }
+    reference back()
+    {
+        return operator[](m_size - 1);
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator{this, 0};
+    }
+    iterator begin()
+    {
+        return iterator{this, 0};
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator{this, m_size};
+    }
+    iterator end()
+    {
+        return iterator{this, m_size};
+    }
+
+private:
+    template <typename FUNC>
+    void for_each_field(FUNC&& func)
+    {
+        [&]<size_t ... Is>(std::index_sequence<Is...>) {
+            (func(data<Is>()), ...);
+        }(indices{});
+    }
+
+    size_type next_capacity() const
+    {
+        if constexpr(STORAGE::can_grow)
+        {
+            return std::max<size_type>(capacity() * 2, 8);
+        }
+        else
+        {
+            return capacity() + 1;
+        }
+    }
+
+    /// Calls build for the index of every field in order, if one throws, undo is called for the fields built before
+    ///     so that all fields keep the same size
+    template <typename BUILD, typename UNDO>
+    void build_fields(BUILD&& build, UNDO&& undo)
+    {
+        size_type built = 0;
+        try
+        {
+            [&]<size_t ... Is>(std::index_sequence<Is...>) {
+                ((build(std::integral_constant<size_t, Is>{}), ++built), ...);
+            }(indices{});
+        }
+        catch(...)
+        {
+            [&]<size_t ... Is>(std::index_sequence<Is...>) {
+                ((Is < built ? undo(std::integral_constant<size_t, Is>{}) : void()), ...);
+            }(indices{});
+            throw;
+        }
+    }
+
+    /// Constructs the element at m_size from one value per field, the size is not changed
+    template <typename TUPLE>
+    void construct_at_end(TUPLE&& values)
+    {
+        build_fields(
+            [&]<size_t I>(std::integral_constant<size_t, I>) {
+                std::construct_at(data<I>() + m_size, std::get<I>(std::forward<TUPLE>(values)));
+            },
+            [&]<size_t I>(std::integral_constant<size_t, I>) { std::destroy_at(data<I>() + m_size); });
+    }
+
+    template <typename T>
+    void insert_field(T* field, size_type index, T&& value)
+    {
+        if(index == m_size)
+        {
+            std::construct_at(field + index, std::move(value));
+        }
+        else if constexpr(std::is_trivially_copyable_v<T>)
+        {
+            std::memmove(static_cast<void*>(field + index + 1), field + index, (m_size - index) * sizeof(T));
+            std::construct_at(field + index, std::move(value));
+        }
+        else
+        {
+            std::construct_at(field + m_size, std::move(field[m_size - 1]));
+            try
+            {
+                std::move_backward(field + index, field + m_size - 1, field + m_size);
+                field[index] = std::move(value);
+            }
+            catch(...)
+            {
+                // The field keeps its size, the elements after index may be left moved from
+                std::destroy_at(field + m_size);
+                throw;
+            }
+        }
+    }
+
+    /// Removes the elements in [first, last) of a field that holds size elements
+    template <typename T>
+    void erase_field(T* field, size_type first, size_type last, size_type size)
+    {
+        if constexpr(std::is_trivially_copyable_v<T>)
+        {
+            std::memmove(static_cast<void*>(field + first), field + last, (size - last) * sizeof(T));
+        }
+        else
+        {
+            std::move(field + last, field + size, field + first);
+            std::destroy(field + size - (last - first), field + size);
+        }
+    }
+
+    void copy_from(const basic_soa_vector& rhs)
+    {
+        reserve(rhs.m_size);
+        build_fields(
+            [&]<size_t I>(std::integral_constant<size_t, I>) {
+                std::uninitialized_copy_n(rhs.template data<I>(), rhs.m_size, data<I>());
+            },
+            [&]<size_t I>(std::integral_constant<size_t, I>) { std::destroy_n(data<I>(), rhs.m_size); });
+        m_size = rhs.m_size;
+    }
+
+    void move_from(basic_soa_vector& rhs)
+    {
+        if constexpr(STORAGE::can_grow)
+        {
+            m_storage.swap(rhs.m_storage);
+            std::swap(m_size, rhs.m_size);
+        }
+        else
+        {
+            [&]<size_t ... Is>(std::index_sequence<Is...>) {
+                (std::uninitialized_move_n(rhs.template data<Is>(), rhs.m_size, data<Is>()), ...);
+            }(indices{});
+            m_size = rhs.m_size;
+            rhs.clear();
+        }
+    }
+
+    STORAGE m_storage;
+    size_type m_size = 0;
+};
+
+/// Structure of arrays with a fixed capacity of N elements stored inline, throws std::bad_alloc when it is full
+template <size_t N, typename ... FIELDS>
+using static_soa_vector = basic_soa_vector<internal::soa_inline_storage<N, FIELDS...>, FIELDS...>;
+
+/// Structure of arrays that grows its field arrays on the heap
+template <typename ... FIELDS>
+using soa_vector = basic_soa_vector<internal::soa_heap_storage<FIELDS...>, FIELDS...>;
+
+template <typename STORAGE, typename ... FIELDS>
+void swap(basic_soa_vector<STORAGE, FIELDS...>& lhs, basic_soa_vector<STORAGE, FIELDS...>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+} // namespace t_ut
+
+#endif
@@ -1,17 +1,65 @@
 #ifndef CPP_UTILITY_SPAN_HPP
 #define CPP_UTILITY_SPAN_HPP
 
-#include <memory>
+#include <array>
+#include <compare>
+#include <cstddef>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
 
 namespace t_ut
 {
 
+/// Extent of a span whose size is only known at runtime
+inline constexpr size_t dynamic_extent = std::numeric_limits<size_t>::max();
+
+namespace internal
+{
+
+/// Size of a span, only stored if it is not known at compile time
+template <size_t EXTENT>
+class span_extent
+{
+public:
+    constexpr span_extent(size_t) noexcept
+    {}
+
+    constexpr size_t size() const { return EXTENT; }
+};
+
+template <>
+class span_extent<dynamic_extent>
+{
+public:
+    constexpr span_extent(size_t size) noexcept
+        : m_size{size}
+    {}
+
+    constexpr size_t size() const { return m_size; }
+
+private:
+    size_t m_size;
+};
+
+template <typename CONTAINER, typename T>
+concept span_compatible_container = requires(CONTAINER& con)
+{
+    { con.size() } -> std::convertible_to<size_t>;
+    { con.data() } -> std::convertible_to<T*>;
+};
+
+} // namespace internal
+
 /// Generic non-owning buffer type inspired by golangs slices
 /// Used as a generic buffer class to send data from and receive data to
-template <typename T>
-class span
+/// With a fixed EXTENT the size is part of the type and the span is a single pointer
+template <typename T, size_t EXTENT = dynamic_extent>
+class span : private internal::span_extent<EXTENT>
 {
+    using extent_type = internal::span_extent<EXTENT>;
+
 public:
     using value_type = T;
     using reference = value_type&;
@@ -21,6 +69,8 @@ public:
     using iterator = pointer;
     using const_iterator = const_pointer;
 
+    static constexpr size_t extent = EXTENT;
+
     span() = delete;
     constexpr span(const span&) noexcept = default;
     constexpr span& operator=(const span&) noexcept = default;
@@ -28,32 +78,61 @@ public:
     constexpr span& operator=(span&&) noexcept = default;
     ~span() noexcept = default;
 
-    constexpr span(pointer start, size_t length) noexcept
-        : m_start{start}
-        , m_size{length}
+    /// For a fixed extent length has to match EXTENT, which is why the constructor is explicit then
+    constexpr explicit(EXTENT != dynamic_extent) span(pointer start, size_t length) noexcept
+        : extent_type{length}
+        , m_start{start}
     {}
 
-    constexpr span(pointer start, pointer end) noexcept
-        : m_start{start}
-        , m_size{static_cast<size_t>(std::distance(start, end) + 1)}
+    /// end points one past the last element
+    constexpr explicit(EXTENT != dynamic_extent) span(pointer start, pointer end) noexcept
+        : extent_type{static_cast<size_t>(end - start)}
+        , m_start{start}
     {}
 
     template <size_t S>
+        requires (EXTENT == dynamic_extent || EXTENT == S)
     constexpr span(value_type (&buffer)[S]) noexcept
-        : m_start{buffer}
-        , m_size{S}
+        : extent_type{S}
+        , m_start{buffer}
+    {}
+
+    template <typename U, size_t S>
+        requires (EXTENT == dynamic_extent || EXTENT == S) && std::is_convertible_v<U(*)[], T(*)[]>
+    constexpr span(std::array<U, S>& buffer) noexcept
+        : extent_type{S}
+        , m_start{buffer.data()}
+    {}
+
+    template <typename U, size_t S>
+        requires (EXTENT == dynamic_extent || EXTENT == S) && std::is_convertible_v<const U(*)[], T(*)[]>
+    constexpr span(const std::array<U, S>& buffer) noexcept
+        : extent_type{S}
+        , m_start{buffer.data()}
+    {}
+
+    /// Fixed extent spans convert to dynamic ones and to spans of const elements, a dynamic span can only be turned
+    ///     into a fixed one explicitly
+    template <typename U, size_t S>
+        requires (EXTENT == dynamic_extent || S == dynamic_extent || EXTENT == S)
+            && std::is_convertible_v<U(*)[], T(*)[]>
+    constexpr explicit(EXTENT != dynamic_extent && S == dynamic_extent) span(span<U, S> other) noexcept
+        : extent_type{other.size()}
+        , m_start{other.data()}
     {}
 
     template <typename ITER>
-    constexpr span(ITER start, ITER end) noexcept
-        : m_start{&(*start)}
-        , m_size{static_cast<size_t>(std::distance(std::addressof(*start), std::addressof(*end)))}
+        requires (!std::is_convertible_v<ITER, pointer>)
+    constexpr explicit(EXTENT != dynamic_extent) span(ITER start, ITER end) noexcept
+        : extent_type{static_cast<size_t>(std::distance(std::addressof(*start), std::addressof(*end)))}
+        , m_start{&(*start)}
     {}
 
     template <typename CONTAINER>
-    constexpr span(CONTAINER&& con) noexcept
-        : m_start{con.data()}
-        , m_size{con.size()}
+        requires internal::span_compatible_container<CONTAINER, T>
+    constexpr explicit(EXTENT != dynamic_extent) span(CONTAINER&& con) noexcept
+        : extent_type{con.size()}
+        , m_start{con.data()}
     {}
 
     constexpr pointer get() { return m_start; }
@@ -61,34 +140,249 @@ public:
     constexpr pointer data() { return m_start; }
     constexpr const_pointer data() const { return m_start; }
 
-    constexpr size_t size() const { return m_size; }
+    constexpr size_t size() const { return extent_type::size(); }
+    constexpr size_t size_bytes() const { return size() * sizeof(value_type); }
 
-    constexpr bool empty() const { return m_size == 0; }
+    constexpr bool empty() const { return size() == 0; }
+
+    /// Views of the first or last COUNT elements, COUNT must not exceed size()
+    template <size_t COUNT>
+        requires (EXTENT == dynamic_extent || COUNT <= EXTENT)
+    constexpr span<T, COUNT> first() const
+    {
+        return span<T, COUNT>{m_start, COUNT};
+    }
+
+    constexpr span<T> first(size_t count) const
+    {
+        return {m_start, count};
+    }
+
+    template <size_t COUNT>
+        requires (EXTENT == dynamic_extent || COUNT <= EXTENT)
+    constexpr span<T, COUNT> last() const
+    {
+        return span<T, COUNT>{m_start + (size() - COUNT), COUNT};
+    }
+
+    constexpr span<T> last(size_t count) const
+    {
+        return {m_start + (size() - count), count};
+    }
+
+    /// View of COUNT elements starting at OFFSET, or of everything after OFFSET if COUNT is dynamic_extent
+    template <size_t OFFSET, size_t COUNT = dynamic_extent>
+        requires (EXTENT == dynamic_extent || (OFFSET <= EXTENT && (COUNT == dynamic_extent || COUNT <= EXTENT - OFFSET)))
+    constexpr auto subspan() const
+    {
+        if constexpr(COUNT != dynamic_extent)
+            return span<T, COUNT>{m_start + OFFSET, COUNT};
+        else if constexpr(EXTENT != dynamic_extent)
+            return span<T, EXTENT - OFFSET>{m_start + OFFSET, EXTENT - OFFSET};
+        else
+            return span<T>{m_start + OFFSET, size() - OFFSET};
+    }
+
+    constexpr span<T> subspan(size_t offset, size_t count = dynamic_extent) const
+    {
+        return {m_start + offset, count == dynamic_extent ? size() - offset : count};
+    }
 
     constexpr reference operator[](size_t index) { return m_start[index]; }
     constexpr const_reference operator[](size_t index) const { return m_start[index]; }
 
     constexpr iterator begin() { return m_start; }
     constexpr const_iterator begin() const { return m_start; }
-    constexpr iterator end() { return std::addressof(m_start[m_size]); }
-    constexpr const_iterator end() const { return std::addressof(m_start[m_size]); }
+    constexpr iterator end() { return m_start + size(); }
+    constexpr const_iterator end() const { return m_start + size(); }
 
     constexpr reference front() { return m_start[0]; }
     constexpr const_reference front() const { return m_start[0]; }
-    constexpr reference back() { return m_start[m_size - 1]; }
-    constexpr const_reference back() const { return m_start[m_size - 1]; }
+    constexpr reference back() { return m_start[size() - 1]; }
+    constexpr const_reference back() const { return m_start[size() - 1]; }
+
+private:
+    pointer m_start;
+};
+
+static_assert(sizeof(span<int, 4>) == sizeof(int*), "A fixed extent span must not store its size");
+
+namespace internal
+{
+
+template <typename T, size_t EXTENT>
+inline constexpr size_t bytes_extent = EXTENT == dynamic_extent ? dynamic_extent : EXTENT * sizeof(T);
+
+} // namespace internal
+
+/// Object representation of the elements of a span, e.g. to hand them to a byte_reader or a socket
+template <typename T, size_t EXTENT>
+span<const std::byte, internal::bytes_extent<T, EXTENT>> as_bytes(span<T, EXTENT> buffer) noexcept
+{
+    return span<const std::byte, internal::bytes_extent<T, EXTENT>>{
+        reinterpret_cast<const std::byte*>(buffer.data()), buffer.size_bytes()};
+}
+
+template <typename T, size_t EXTENT>
+    requires (!std::is_const_v<T>)
+span<std::byte, internal::bytes_extent<T, EXTENT>> as_writable_bytes(span<T, EXTENT> buffer) noexcept
+{
+    return span<std::byte, internal::bytes_extent<T, EXTENT>>{
+        reinterpret_cast<std::byte*>(buffer.data()), buffer.size_bytes()};
+}
+
+namespace internal
+{
+
+/// Random access iterator over every stride-th element of a buffer
+/// Keeps the start of the buffer and an index so that end() never points outside of it
+template <typename T>
+class strided_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    constexpr strided_iterator() noexcept = default;
+
+    constexpr strided_iterator(pointer start, difference_type index, difference_type stride) noexcept
+        : m_start{start}
+        , m_index{index}
+        , m_stride{stride}
+    {}
+
+    constexpr operator strided_iterator<const T>() const noexcept requires (!std::is_const_v<T>)
+    {
+        return {m_start, m_index, m_stride};
+    }
+
+    constexpr reference operator*() const { return m_start[m_index * m_stride]; }
+    constexpr pointer operator->() const { return std::addressof(**this); }
+    constexpr reference operator[](difference_type n) const { return m_start[(m_index + n) * m_stride]; }
+
+    constexpr strided_iterator& operator++() { ++m_index; return *this; }
+    constexpr strided_iterator operator++(int) { auto tmp = *this; ++m_index; return tmp; }
+    constexpr strided_iterator& operator--() { --m_index; return *this; }
+    constexpr strided_iterator operator--(int) { auto tmp = *this; --m_index; return tmp; }
+    constexpr strided_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+    constexpr strided_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+
+    friend constexpr strided_iterator operator+(strided_iterator it, difference_type n) { return it += n; }
+    friend constexpr strided_iterator operator+(difference_type n, strided_iterator it) { return it += n; }
+    friend constexpr strided_iterator operator-(strided_iterator it, difference_type n) { return it -= n; }
+
+    friend constexpr difference_type operator-(const strided_iterator& lhs, const strided_iterator& rhs)
+    {
+        return lhs.m_index - rhs.m_index;
+    }
+
+    friend constexpr bool operator==(const strided_iterator& lhs, const strided_iterator& rhs)
+    {
+        return lhs.m_index == rhs.m_index;
+    }
+
+    friend constexpr auto operator<=>(const strided_iterator& lhs, const strided_iterator& rhs)
+    {
+        return lhs.m_index <=> rhs.m_index;
+    }
+
+private:
+    pointer m_start = nullptr;
+    difference_type m_index = 0;
+    difference_type m_stride = 1;
+};
+
+} // namespace internal
+
+/// Non-owning view over every stride-th element of a buffer, e.g. a column of a row major matrix or one channel
+///     of interleaved image data
+/// The stride is counted in elements and may be negative to walk a buffer backwards
+template <typename T>
+class strided_span
+{
+public:
+    using value_type = T;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using pointer = value_type*;
+    using const_pointer = const value_type*;
+    using iterator = internal::strided_iterator<T>;
+    using const_iterator = internal::strided_iterator<const T>;
+
+    strided_span() = delete;
+
+    constexpr strided_span(pointer start, size_t length, std::ptrdiff_t stride) noexcept
+        : m_start{start}
+        , m_size{length}
+        , m_stride{stride}
+    {}
+
+    template <size_t EXTENT>
+    constexpr strided_span(span<T, EXTENT> contiguous) noexcept
+        : strided_span{contiguous.data(), contiguous.size(), 1}
+    {}
+
+    template <typename U>
+        requires std::is_convertible_v<U(*)[], T(*)[]>
+    constexpr strided_span(const strided_span<U>& other) noexcept
+        : strided_span{other.data(), other.size(), other.stride()}
+    {}
+
+    constexpr pointer data() const { return m_start; }
+    constexpr size_t size() const { return m_size; }
+    constexpr std::ptrdiff_t stride() const { return m_stride; }
+    constexpr bool empty() const { return m_size == 0; }
+
+    constexpr reference operator[](size_t index) { return m_start[static_cast<std::ptrdiff_t>(index) * m_stride]; }
+    constexpr const_reference operator[](size_t index) const
+    {
+        return m_start[static_cast<std::ptrdiff_t>(index) * m_stride];
+    }
+
+    constexpr iterator begin() { return {m_start, 0, m_stride}; }
+    constexpr const_iterator begin() const { return {m_start, 0, m_stride}; }
+    constexpr iterator end() { return {m_start, static_cast<std::ptrdiff_t>(m_size), m_stride}; }
+    constexpr const_iterator end() const { return {m_start, static_cast<std::ptrdiff_t>(m_size), m_stride}; }
+
+    constexpr reference front() { return (*this)[0]; }
+    constexpr const_reference front() const { return (*this)[0]; }
+    constexpr reference back() { return (*this)[m_size - 1]; }
+    constexpr const_reference back() const { return (*this)[m_size - 1]; }
 
 private:
     pointer m_start;
     size_t m_size;
+    std::ptrdiff_t m_stride;
 };
 
 /// Template deduction guides for class span
+template <typename T, size_t S>
+span(T (&)[S]) -> span<T, S>;
+
+template <typename T, size_t S>
+span(std::array<T, S>&) -> span<T, S>;
+
+template <typename T, size_t S>
+span(const std::array<T, S>&) -> span<const T, S>;
+
+template <typename T>
+span(T*, size_t) -> span<T>;
+
 template <typename ITERATOR>
-span(ITERATOR, ITERATOR) -> span<typename std::iterator_traits<ITERATOR>::value_type>;
+span(ITERATOR, ITERATOR) -> span<std::remove_reference_t<std::iter_reference_t<ITERATOR>>>;
 
 template <typename CONTAINER_TYPE>
-span(const CONTAINER_TYPE&) -> span<typename std::remove_reference<decltype(std::declval<CONTAINER_TYPE>().front())>::type>;
+span(CONTAINER_TYPE&&) -> span<std::remove_pointer_t<decltype(std::declval<CONTAINER_TYPE&>().data())>>;
+
+/// Template deduction guides for class strided_span
+template <typename T>
+strided_span(T*, size_t, std::ptrdiff_t) -> strided_span<T>;
+
+template <typename T, size_t EXTENT>
+strided_span(span<T, EXTENT>) -> strided_span<T>;
 
 } // namespace t_ut
 
@@ -0,0 +1,926 @@
+#ifndef CPP_UTILITY_SPAN_ALGORITHM_HPP
+#define CPP_UTILITY_SPAN_ALGORITHM_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+#include "span.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define T_UT_SIMD_X86 1
+#include <immintrin.h>
+#define T_UT_TARGET(ISA) __attribute__((target(ISA)))
+#else
+#define T_UT_SIMD_X86 0
+#endif
+
+namespace t_ut {
+
+/// Instruction set used by the span algorithms, ordered from least to most capable
+enum class simd_level : uint8_t
+{
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+/// Best instruction set supported by the cpu and operating system, queried through CPUID
+inline simd_level detect_simd_level() noexcept
+{
+#if T_UT_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return simd_level::avx512;
+    if(__builtin_cpu_supports("avx2"))
+        return simd_level::avx2;
+    if(__builtin_cpu_supports("sse2"))
+        return simd_level::sse2;
+#endif
+    return simd_level::scalar;
+}
+
+/// detect_simd_level() evaluated once per process
+inline simd_level supported_simd_level() noexcept
+{
+    static const simd_level level = detect_simd_level();
+    return level;
+}
+
+namespace internal {
+
+struct scalar_tag {};
+struct sse2_tag {};
+struct avx2_tag {};
+struct avx512_tag {};
+
+/// Calls func with the tag of the requested level, capped to what the cpu supports
+template <typename FUNC>
+decltype(auto) simd_dispatch(simd_level level, FUNC&& func)
+{
+#if T_UT_SIMD_X86
+    if(level > supported_simd_level())
+        level = supported_simd_level();
+
+    switch(level)
+    {
+    case simd_level::avx512:
+        return func(avx512_tag{});
+    case simd_level::avx2:
+        return func(avx2_tag{});
+    case simd_level::sse2:
+        return func(sse2_tag{});
+    default:
+        break;
+    }
+#else
+    (void)level;
+#endif
+    return func(scalar_tag{});
+}
+
+/// Float sums and min/max depend on the order of the operations, so every kernel uses the same layout:
+///     element i is accumulated into lane i % float_lanes and the lanes are folded in a fixed order at the end.
+///     That makes the results of all instruction sets bit identical to the scalar version.
+inline constexpr size_t float_lanes = 32;
+
+inline float min_op(float value, float acc)
+{
+    return value < acc ? value : acc;
+}
+
+inline float max_op(float value, float acc)
+{
+    return value > acc ? value : acc;
+}
+
+template <typename OP>
+float fold_lanes(float (&lanes)[float_lanes], OP op)
+{
+    for(size_t half = float_lanes / 2; half > 0; half /= 2)
+    {
+        for(size_t j = 0; j < half; ++j)
+            lanes[j] = op(lanes[j + half], lanes[j]);
+    }
+    return lanes[0];
+}
+
+inline float add_op(float value, float acc)
+{
+    return acc + value;
+}
+
+/// Adds the elements after the last full block to the lanes
+inline void sum_tail(float (&lanes)[float_lanes], const float* data, size_t begin, size_t size)
+{
+    for(size_t i = begin; i < size; ++i)
+        lanes[i % float_lanes] += data[i];
+}
+
+inline void minmax_tail(float (&min)[float_lanes], float (&max)[float_lanes], const float* data, size_t begin,
+    size_t size)
+{
+    for(size_t i = begin; i < size; ++i)
+    {
+        min[i % float_lanes] = min_op(data[i], min[i % float_lanes]);
+        max[i % float_lanes] = max_op(data[i], max[i % float_lanes]);
+    }
+}
+
+// Scalar kernels, also used for the tails of the vectorized ones
+
+inline size_t find_kernel(scalar_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    for(size_t i = 0; i < size; ++i)
+    {
+        if(data[i] == value)
+            return i;
+    }
+    return size;
+}
+
+inline size_t find_kernel(scalar_tag, const float* data, size_t size, float value)
+{
+    for(size_t i = 0; i < size; ++i)
+    {
+        if(data[i] == value)
+            return i;
+    }
+    return size;
+}
+
+template <typename T>
+size_t count_kernel(scalar_tag, const T* data, size_t size, T value)
+{
+    size_t result = 0;
+    for(size_t i = 0; i < size; ++i)
+        result += data[i] == value;
+    return result;
+}
+
+inline std::pair<uint8_t, uint8_t> minmax_kernel(scalar_tag, const uint8_t* data, size_t size)
+{
+    uint8_t min = std::numeric_limits<uint8_t>::max();
+    uint8_t max = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        min = data[i] < min ? data[i] : min;
+        max = data[i] > max ? data[i] : max;
+    }
+    return {min, max};
+}
+
+inline std::pair<float, float> minmax_kernel(scalar_tag, const float* data, size_t size)
+{
+    float min[float_lanes];
+    float max[float_lanes];
+    for(size_t j = 0; j < float_lanes; ++j)
+    {
+        min[j] = std::numeric_limits<float>::infinity();
+        max[j] = -std::numeric_limits<float>::infinity();
+    }
+    minmax_tail(min, max, data, 0, size);
+    return {fold_lanes(min, min_op), fold_lanes(max, max_op)};
+}
+
+inline uint64_t sum_kernel(scalar_tag, const uint8_t* data, size_t size)
+{
+    uint64_t result = 0;
+    for(size_t i = 0; i < size; ++i)
+        result += data[i];
+    return result;
+}
+
+inline float sum_kernel(scalar_tag, const float* data, size_t size)
+{
+    float lanes[float_lanes] = {};
+    sum_tail(lanes, data, 0, size);
+    return fold_lanes(lanes, add_op);
+}
+
+template <typename T>
+bool equal_kernel(scalar_tag, const T* lhs, const T* rhs, size_t size)
+{
+    for(size_t i = 0; i < size; ++i)
+    {
+        if(!(lhs[i] == rhs[i]))
+            return false;
+    }
+    return true;
+}
+
+#if T_UT_SIMD_X86
+
+// SSE2 kernels, 16 bytes or 4 floats per register
+
+T_UT_TARGET("sse2")
+inline size_t find_kernel(sse2_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + find_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("sse2")
+inline size_t find_kernel(sse2_tag, const float* data, size_t size, float value)
+{
+    const __m128 needle = _mm_set1_ps(value);
+    size_t i = 0;
+    for(; i + 4 <= size; i += 4)
+    {
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), needle)));
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + find_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("sse2")
+inline size_t count_kernel(sse2_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    size_t result = 0;
+    size_t i = 0;
+    while(i + 16 <= size)
+    {
+        // Byte counters overflow after 255 blocks, so they are summed up with psadbw in between
+        __m128i counters = _mm_setzero_si128();
+        const size_t blocks = std::min<size_t>((size - i) / 16, 255);
+        for(size_t b = 0; b < blocks; ++b, i += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(block, needle));
+        }
+        const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        result += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+    return result + count_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("sse2")
+inline size_t count_kernel(sse2_tag, const float* data, size_t size, float value)
+{
+    const __m128 needle = _mm_set1_ps(value);
+    size_t result = 0;
+    size_t i = 0;
+    for(; i + 4 <= size; i += 4)
+    {
+        const int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), needle));
+        result += static_cast<size_t>((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+    }
+    return result + count_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("sse2")
+inline std::pair<uint8_t, uint8_t> minmax_kernel(sse2_tag, const uint8_t* data, size_t size)
+{
+    __m128i min = _mm_set1_epi8(static_cast<char>(0xFF));
+    __m128i max = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        min = _mm_min_epu8(min, block);
+        max = _mm_max_epu8(max, block);
+    }
+
+    alignas(16) uint8_t min_lanes[16];
+    alignas(16) uint8_t max_lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(min_lanes), min);
+    _mm_store_si128(reinterpret_cast<__m128i*>(max_lanes), max);
+    auto result = minmax_kernel(scalar_tag{}, data + i, size - i);
+    for(size_t j = 0; j < 16; ++j)
+    {
+        result.first = min_lanes[j] < result.first ? min_lanes[j] : result.first;
+        result.second = max_lanes[j] > result.second ? max_lanes[j] : result.second;
+    }
+    return result;
+}
+
+T_UT_TARGET("sse2")
+inline std::pair<float, float> minmax_kernel(sse2_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 4;
+    __m128 min[registers];
+    __m128 max[registers];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        min[r] = _mm_set1_ps(std::numeric_limits<float>::infinity());
+        max[r] = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+        {
+            const __m128 block = _mm_loadu_ps(data + i + 4 * r);
+            min[r] = _mm_min_ps(block, min[r]);
+            max[r] = _mm_max_ps(block, max[r]);
+        }
+    }
+
+    float min_lanes[float_lanes];
+    float max_lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        _mm_storeu_ps(min_lanes + 4 * r, min[r]);
+        _mm_storeu_ps(max_lanes + 4 * r, max[r]);
+    }
+    minmax_tail(min_lanes, max_lanes, data, i, size);
+    return {fold_lanes(min_lanes, min_op), fold_lanes(max_lanes, max_op)};
+}
+
+T_UT_TARGET("sse2")
+inline uint64_t sum_kernel(sse2_tag, const uint8_t* data, size_t size)
+{
+    __m128i sums = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(block, _mm_setzero_si128()));
+    }
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    return lanes[0] + lanes[1] + sum_kernel(scalar_tag{}, data + i, size - i);
+}
+
+T_UT_TARGET("sse2")
+inline float sum_kernel(sse2_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 4;
+    __m128 sums[registers];
+    for(size_t r = 0; r < registers; ++r)
+        sums[r] = _mm_setzero_ps();
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+            sums[r] = _mm_add_ps(sums[r], _mm_loadu_ps(data + i + 4 * r));
+    }
+
+    float lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+        _mm_storeu_ps(lanes + 4 * r, sums[r]);
+    sum_tail(lanes, data, i, size);
+    return fold_lanes(lanes, add_op);
+}
+
+T_UT_TARGET("sse2")
+inline bool equal_kernel(sse2_tag, const uint8_t* lhs, const uint8_t* rhs, size_t size)
+{
+    size_t i = 0;
+    for(; i + 16 <= size; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + i));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF)
+            return false;
+    }
+    return equal_kernel(scalar_tag{}, lhs + i, rhs + i, size - i);
+}
+
+T_UT_TARGET("sse2")
+inline bool equal_kernel(sse2_tag, const float* lhs, const float* rhs, size_t size)
+{
+    size_t i = 0;
+    for(; i + 4 <= size; i += 4)
+    {
+        if(_mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i))) != 0xF)
+            return false;
+    }
+    return equal_kernel(scalar_tag{}, lhs + i, rhs + i, size - i);
+}
+
+// AVX2 kernels, 32 bytes or 8 floats per register
+
+T_UT_TARGET("avx2,bmi")
+inline size_t find_kernel(avx2_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    size_t i = 0;
+    // Four registers are compared per iteration and only checked together, the match is located afterwards
+    for(; i + 128 <= size; i += 128)
+    {
+        const __m256i* blocks = reinterpret_cast<const __m256i*>(data + i);
+        const __m256i any = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(blocks), needle),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(blocks + 1), needle)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(blocks + 2), needle),
+                _mm256_cmpeq_epi8(_mm256_loadu_si256(blocks + 3), needle)));
+        if(!_mm256_testz_si256(any, any))
+            break;
+    }
+    for(; i + 32 <= size; i += 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)));
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + find_kernel(sse2_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("avx2,bmi")
+inline size_t find_kernel(avx2_tag, const float* data, size_t size, float value)
+{
+    const __m256 needle = _mm256_set1_ps(value);
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+        const __m256 block = _mm256_loadu_ps(data + i);
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(block, needle, _CMP_EQ_OQ)));
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + find_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("avx2")
+inline size_t count_kernel(avx2_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    __m256i sums = _mm256_setzero_si256();
+    size_t i = 0;
+    while(i + 32 <= size)
+    {
+        // Byte counters overflow after 255 blocks, so they are summed up with vpsadbw in between
+        __m256i counters = _mm256_setzero_si256();
+        const size_t blocks = std::min<size_t>((size - i) / 32, 255);
+        for(size_t b = 0; b < blocks; ++b, i += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(block, needle));
+        }
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counters, _mm256_setzero_si256()));
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + count_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("avx2,popcnt")
+inline size_t count_kernel(avx2_tag, const float* data, size_t size, float value)
+{
+    const __m256 needle = _mm256_set1_ps(value);
+    size_t result = 0;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+        const __m256 block = _mm256_loadu_ps(data + i);
+        result += static_cast<size_t>(__builtin_popcount(
+            static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(block, needle, _CMP_EQ_OQ)))));
+    }
+    return result + count_kernel(scalar_tag{}, data + i, size - i, value);
+}
+
+T_UT_TARGET("avx2")
+inline std::pair<uint8_t, uint8_t> minmax_kernel(avx2_tag, const uint8_t* data, size_t size)
+{
+    __m256i min = _mm256_set1_epi8(static_cast<char>(0xFF));
+    __m256i max = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        min = _mm256_min_epu8(min, block);
+        max = _mm256_max_epu8(max, block);
+    }
+
+    alignas(32) uint8_t min_lanes[32];
+    alignas(32) uint8_t max_lanes[32];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(min_lanes), min);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(max_lanes), max);
+    auto result = minmax_kernel(scalar_tag{}, data + i, size - i);
+    for(size_t j = 0; j < 32; ++j)
+    {
+        result.first = min_lanes[j] < result.first ? min_lanes[j] : result.first;
+        result.second = max_lanes[j] > result.second ? max_lanes[j] : result.second;
+    }
+    return result;
+}
+
+T_UT_TARGET("avx2")
+inline std::pair<float, float> minmax_kernel(avx2_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 8;
+    __m256 min[registers];
+    __m256 max[registers];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        min[r] = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+        max[r] = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+        {
+            const __m256 block = _mm256_loadu_ps(data + i + 8 * r);
+            min[r] = _mm256_min_ps(block, min[r]);
+            max[r] = _mm256_max_ps(block, max[r]);
+        }
+    }
+
+    float min_lanes[float_lanes];
+    float max_lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        _mm256_storeu_ps(min_lanes + 8 * r, min[r]);
+        _mm256_storeu_ps(max_lanes + 8 * r, max[r]);
+    }
+    minmax_tail(min_lanes, max_lanes, data, i, size);
+    return {fold_lanes(min_lanes, min_op), fold_lanes(max_lanes, max_op)};
+}
+
+T_UT_TARGET("avx2")
+inline uint64_t sum_kernel(avx2_tag, const uint8_t* data, size_t size)
+{
+    __m256i sums = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32)
+    {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(block, _mm256_setzero_si256()));
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_kernel(scalar_tag{}, data + i, size - i);
+}
+
+T_UT_TARGET("avx2")
+inline float sum_kernel(avx2_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 8;
+    __m256 sums[registers];
+    for(size_t r = 0; r < registers; ++r)
+        sums[r] = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+            sums[r] = _mm256_add_ps(sums[r], _mm256_loadu_ps(data + i + 8 * r));
+    }
+
+    float lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+        _mm256_storeu_ps(lanes + 8 * r, sums[r]);
+    sum_tail(lanes, data, i, size);
+    return fold_lanes(lanes, add_op);
+}
+
+T_UT_TARGET("avx2")
+inline bool equal_kernel(avx2_tag, const uint8_t* lhs, const uint8_t* rhs, size_t size)
+{
+    size_t i = 0;
+    for(; i + 32 <= size; i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs + i));
+        if(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) != -1)
+            return false;
+    }
+    return equal_kernel(sse2_tag{}, lhs + i, rhs + i, size - i);
+}
+
+T_UT_TARGET("avx2")
+inline bool equal_kernel(avx2_tag, const float* lhs, const float* rhs, size_t size)
+{
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8)
+    {
+        const __m256 equal = _mm256_cmp_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i), _CMP_EQ_OQ);
+        if(_mm256_movemask_ps(equal) != 0xFF)
+            return false;
+    }
+    return equal_kernel(scalar_tag{}, lhs + i, rhs + i, size - i);
+}
+
+// AVX-512 kernels, 64 bytes or 16 floats per register, tails are handled with masked loads
+
+#define T_UT_AVX512 "avx512f,avx512bw,bmi,popcnt"
+
+// GCC 12 reports the _mm512_undefined_* placeholders inside its own intrinsics as uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+T_UT_TARGET(T_UT_AVX512)
+inline __mmask64 avx512_tail_mask(size_t count)
+{
+    return count >= 64 ? ~__mmask64{0} : (__mmask64{1} << count) - 1;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline size_t find_kernel(avx512_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+    size_t i = 0;
+    // Four registers are compared per iteration and only checked together, the match is located afterwards
+    for(; i + 256 <= size; i += 256)
+    {
+        const __m512i* blocks = reinterpret_cast<const __m512i*>(data + i);
+        const __mmask64 any = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(blocks), needle)
+            | _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(blocks + 1), needle)
+            | _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(blocks + 2), needle)
+            | _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(blocks + 3), needle);
+        if(any != 0)
+            break;
+    }
+    for(; i < size; i += 64)
+    {
+        const __mmask64 load = avx512_tail_mask(size - i);
+        const __m512i block = _mm512_maskz_loadu_epi8(load, data + i);
+        const __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(load, block, needle);
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctzll(mask));
+    }
+    return size;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline size_t find_kernel(avx512_tag, const float* data, size_t size, float value)
+{
+    const __m512 needle = _mm512_set1_ps(value);
+    for(size_t i = 0; i < size; i += 16)
+    {
+        const __mmask16 load = static_cast<__mmask16>(avx512_tail_mask(size - i));
+        const __m512 block = _mm512_maskz_loadu_ps(load, data + i);
+        const unsigned mask = _mm512_mask_cmp_ps_mask(load, block, needle, _CMP_EQ_OQ);
+        if(mask != 0)
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return size;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline size_t count_kernel(avx512_tag, const uint8_t* data, size_t size, uint8_t value)
+{
+    const __m512i needle = _mm512_set1_epi8(static_cast<char>(value));
+    size_t result = 0;
+    for(size_t i = 0; i < size; i += 64)
+    {
+        const __mmask64 load = avx512_tail_mask(size - i);
+        const __m512i block = _mm512_maskz_loadu_epi8(load, data + i);
+        result += static_cast<size_t>(__builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(load, block, needle)));
+    }
+    return result;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline size_t count_kernel(avx512_tag, const float* data, size_t size, float value)
+{
+    const __m512 needle = _mm512_set1_ps(value);
+    size_t result = 0;
+    for(size_t i = 0; i < size; i += 16)
+    {
+        const __mmask16 load = static_cast<__mmask16>(avx512_tail_mask(size - i));
+        const __m512 block = _mm512_maskz_loadu_ps(load, data + i);
+        result += static_cast<size_t>(__builtin_popcount(_mm512_mask_cmp_ps_mask(load, block, needle, _CMP_EQ_OQ)));
+    }
+    return result;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline std::pair<uint8_t, uint8_t> minmax_kernel(avx512_tag, const uint8_t* data, size_t size)
+{
+    __m512i min = _mm512_set1_epi8(static_cast<char>(0xFF));
+    __m512i max = _mm512_setzero_si512();
+    for(size_t i = 0; i < size; i += 64)
+    {
+        // Lanes past the end load the neutral element of the respective reduction
+        const __mmask64 load = avx512_tail_mask(size - i);
+        min = _mm512_min_epu8(min, _mm512_mask_loadu_epi8(_mm512_set1_epi8(static_cast<char>(0xFF)), load, data + i));
+        max = _mm512_max_epu8(max, _mm512_maskz_loadu_epi8(load, data + i));
+    }
+
+    alignas(64) uint8_t min_lanes[64];
+    alignas(64) uint8_t max_lanes[64];
+    _mm512_store_si512(min_lanes, min);
+    _mm512_store_si512(max_lanes, max);
+    std::pair<uint8_t, uint8_t> result{std::numeric_limits<uint8_t>::max(), 0};
+    for(size_t j = 0; j < 64; ++j)
+    {
+        result.first = min_lanes[j] < result.first ? min_lanes[j] : result.first;
+        result.second = max_lanes[j] > result.second ? max_lanes[j] : result.second;
+    }
+    return result;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline std::pair<float, float> minmax_kernel(avx512_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 16;
+    __m512 min[registers];
+    __m512 max[registers];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        min[r] = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+        max[r] = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+    }
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+        {
+            const __m512 block = _mm512_loadu_ps(data + i + 16 * r);
+            min[r] = _mm512_min_ps(block, min[r]);
+            max[r] = _mm512_max_ps(block, max[r]);
+        }
+    }
+
+    float min_lanes[float_lanes];
+    float max_lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+    {
+        _mm512_storeu_ps(min_lanes + 16 * r, min[r]);
+        _mm512_storeu_ps(max_lanes + 16 * r, max[r]);
+    }
+    minmax_tail(min_lanes, max_lanes, data, i, size);
+    return {fold_lanes(min_lanes, min_op), fold_lanes(max_lanes, max_op)};
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline uint64_t sum_kernel(avx512_tag, const uint8_t* data, size_t size)
+{
+    __m512i sums = _mm512_setzero_si512();
+    for(size_t i = 0; i < size; i += 64)
+    {
+        const __m512i block = _mm512_maskz_loadu_epi8(avx512_tail_mask(size - i), data + i);
+        sums = _mm512_add_epi64(sums, _mm512_sad_epu8(block, _mm512_setzero_si512()));
+    }
+    return static_cast<uint64_t>(_mm512_reduce_add_epi64(sums));
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline float sum_kernel(avx512_tag, const float* data, size_t size)
+{
+    constexpr size_t registers = float_lanes / 16;
+    __m512 sums[registers];
+    for(size_t r = 0; r < registers; ++r)
+        sums[r] = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for(; i + float_lanes <= size; i += float_lanes)
+    {
+        for(size_t r = 0; r < registers; ++r)
+            sums[r] = _mm512_add_ps(sums[r], _mm512_loadu_ps(data + i + 16 * r));
+    }
+
+    float lanes[float_lanes];
+    for(size_t r = 0; r < registers; ++r)
+        _mm512_storeu_ps(lanes + 16 * r, sums[r]);
+    sum_tail(lanes, data, i, size);
+    return fold_lanes(lanes, add_op);
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline bool equal_kernel(avx512_tag, const uint8_t* lhs, const uint8_t* rhs, size_t size)
+{
+    for(size_t i = 0; i < size; i += 64)
+    {
+        const __mmask64 load = avx512_tail_mask(size - i);
+        const __m512i a = _mm512_maskz_loadu_epi8(load, lhs + i);
+        const __m512i b = _mm512_maskz_loadu_epi8(load, rhs + i);
+        if(_mm512_cmpneq_epi8_mask(a, b) != 0)
+            return false;
+    }
+    return true;
+}
+
+T_UT_TARGET(T_UT_AVX512)
+inline bool equal_kernel(avx512_tag, const float* lhs, const float* rhs, size_t size)
+{
+    for(size_t i = 0; i < size; i += 16)
+    {
+        const __mmask16 load = static_cast<__mmask16>(avx512_tail_mask(size - i));
+        const __m512 a = _mm512_maskz_loadu_ps(load, lhs + i);
+        const __m512 b = _mm512_maskz_loadu_ps(load, rhs + i);
+        if(_mm512_mask_cmp_ps_mask(load, a, b, _CMP_EQ_OQ) != load)
+            return false;
+    }
+    return true;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#undef T_UT_AVX512
+
+#endif
+
+} // namespace internal
+
+/// Vectorized algorithms over spans of bytes and floats
+/// The best kernel for the cpu is picked at runtime, level can lower it e.g. to compare against the scalar version
+/// All instruction sets return exactly the same results as the scalar code, including the rounding of float sums
+/// Float comparisons follow operator==, so NaN is never found or equal and -0.0f equals 0.0f
+
+/// Index of the first element equal to value, data.size() if there is none
+inline size_t find(span<const uint8_t> data, uint8_t value, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::find_kernel(tag, data.data(), data.size(), value);
+    });
+}
+
+inline size_t find(span<const float> data, float value, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::find_kernel(tag, data.data(), data.size(), value);
+    });
+}
+
+/// Number of elements equal to value
+inline size_t count(span<const uint8_t> data, uint8_t value, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::count_kernel(tag, data.data(), data.size(), value);
+    });
+}
+
+inline size_t count(span<const float> data, float value, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::count_kernel(tag, data.data(), data.size(), value);
+    });
+}
+
+/// Smallest and biggest element, NaNs are skipped
+/// An empty span yields the neutral elements {max, lowest}, i.e. {255, 0} and {inf, -inf}
+inline std::pair<uint8_t, uint8_t> minmax(span<const uint8_t> data, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::minmax_kernel(tag, data.data(), data.size());
+    });
+}
+
+inline std::pair<float, float> minmax(span<const float> data, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::minmax_kernel(tag, data.data(), data.size());
+    });
+}
+
+/// Sum of all bytes, which cannot overflow
+inline uint64_t sum(span<const uint8_t> data, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::sum_kernel(tag, data.data(), data.size());
+    });
+}
+
+/// Sum of all floats, accumulated pairwise over 32 lanes which is also more accurate than a sequential sum
+inline float sum(span<const float> data, simd_level level = supported_simd_level())
+{
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::sum_kernel(tag, data.data(), data.size());
+    });
+}
+
+/// True if both spans have the same size and equal elements
+inline bool equal(span<const uint8_t> lhs, span<const uint8_t> rhs, simd_level level = supported_simd_level())
+{
+    if(lhs.size() != rhs.size())
+        return false;
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::equal_kernel(tag, lhs.data(), rhs.data(), lhs.size());
+    });
+}
+
+inline bool equal(span<const float> lhs, span<const float> rhs, simd_level level = supported_simd_level())
+{
+    if(lhs.size() != rhs.size())
+        return false;
+    return internal::simd_dispatch(level, [&](auto tag) {
+        return internal::equal_kernel(tag, lhs.data(), rhs.data(), lhs.size());
+    });
+}
+
+} // namespace t_ut
+
+#undef T_UT_TARGET
+#undef T_UT_SIMD_X86
+
+#endif
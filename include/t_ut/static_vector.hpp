@@ -2,22 +2,77 @@
 #define CPP_UTILITY_STATIC_VECTOR_HPP
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
 
 namespace t_ut {
 
 namespace internal {
-// TODO size_type_helper
+
+/// Smallest unsigned integer type that can store values up to S
+template <size_t S>
+struct size_type_helper
+{
+    using type = std::conditional_t<S <= UINT8_MAX, uint8_t,
+        std::conditional_t<S <= UINT16_MAX, uint16_t, std::conditional_t<S <= UINT32_MAX, uint32_t, uint64_t>>>;
+};
+
+template <size_t S>
+using size_type_helper_t = typename size_type_helper<S>::type;
+
+/// Inline storage for up to S elements that are only constructed on demand
+/// Trivially copyable if T is, so containers built on it can be as well
+/// Constant evaluation does not allow an object with uninitialized parts as the value of a constexpr variable, so
+///     there all elements are value-initialized first, which costs nothing at run time
+template <typename T, size_t S>
+union uninitialized_array
+{
+    constexpr uninitialized_array() noexcept
+    {
+        if constexpr(std::is_default_constructible_v<T> && std::is_trivially_destructible_v<T>)
+        {
+            if(std::is_constant_evaluated())
+            {
+                for(T& element : data)
+                    std::construct_at(&element, T{});
+            }
+        }
+    }
+
+    constexpr ~uninitialized_array() requires std::is_trivially_destructible_v<T> = default;
+
+    constexpr ~uninitialized_array()
+    {}
+
+    T data[S];
+};
+
 } // namespace internal
 
+/// Vector with a fixed capacity of S elements that are stored inline
+/// static_vector is trivially copyable and usable in constant expressions if T is trivially copyable, constexpr
+///     variables also need T to be default constructible
+/// Throws std::bad_alloc when more than S elements are added
+/// The size is stored in the smallest type that can hold S directly after the elements, so e.g. a
+///     static_vector<uint8_t, 63> fills exactly one cache line
 template <typename T, size_t S>
 class static_vector
 {
     static_assert(S > 0, "static_vector with capacity 0 is not allowed");
 
+    static constexpr bool trivially_copyable = std::is_trivially_copyable_v<T>;
+
+    using stored_size_type = internal::size_type_helper_t<S>;
+
 public:
     using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
     using value_type = T;
     using reference = value_type&;
     using const_reference = const value_type&;
@@ -28,241 +83,280 @@ public:
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    static_vector() = default;
+    constexpr static_vector() noexcept
+    {}
 
-    static_vector(size_type count, const_reference val = value_type{})
+    /// There is no initializer_list constructor, so static_vector<int, N>{3, 5} holds three 5s as well, lists of
+    ///     elements go through assign({...})
+    constexpr static_vector(size_type count, const_reference val = value_type{})
     {
-        if(count > S)
-        {
-            throw std::bad_alloc{};
-        }
-
-        // TODO Optimize for trivially copyable types?
-        for(size_type i = 0; i < count; ++i)
-        {
-            push_back(val);
-        }
+        assign(count, val);
     }
 
-    template <typename input_it>
-    static_vector(input_it first, input_it last)
+    template <std::input_iterator input_it>
+    constexpr static_vector(input_it first, input_it last)
     {
-        if(std::distance(first, last) > S)
-        {
-            throw std::bad_alloc{};
-        }
-
-        // TODO Optimize this?
-        while(first != last)
-        {
-            push_back(*first++);
-        }
+        assign(first, last);
     }
 
-    static_vector(const static_vector<value_type, S>& rhs)
+    constexpr static_vector(const static_vector&) requires trivially_copyable = default;
+
+    constexpr static_vector(const static_vector& rhs)
     {
-        *this = rhs;
+        construct_from(rhs.begin(), rhs.m_size);
     }
 
-    static_vector(static_vector<value_type, S>&& rhs)
+    constexpr static_vector(static_vector&&) requires trivially_copyable = default;
+
+    constexpr static_vector(static_vector&& rhs) noexcept(std::is_nothrow_move_constructible_v<value_type>)
     {
-        *this = std::move(rhs);
+        construct_from(std::make_move_iterator(rhs.begin()), rhs.m_size);
     }
 
-    static_vector operator=(const static_vector<value_type, S>& rhs)
+    constexpr static_vector& operator=(const static_vector&) requires trivially_copyable = default;
+
+    constexpr static_vector& operator=(const static_vector& rhs)
     {
         if(this != &rhs)
         {
-            m_size = rhs.m_size;
-            if constexpr(!std::is_trivially_copyable<value_type>())
-            {
-                std::copy_n(rhs.m_buffer, m_size, m_buffer);
-            }
-            else
-            {
-                for(size_type i = 0; i < m_size; ++i)
-                {
-                    new(&m_buffer[i]) value_type{reinterpret_cast<const_reference>(rhs.m_buffer[i])};
-                }
-            }
+            clear();
+            construct_from(rhs.begin(), rhs.m_size);
         }
         return *this;
     }
 
-    static_vector operator=(static_vector<value_type, S>&& rhs)
+    constexpr static_vector& operator=(static_vector&&) requires trivially_copyable = default;
+
+    constexpr static_vector& operator=(static_vector&& rhs) noexcept(std::is_nothrow_move_constructible_v<value_type>)
     {
         if(this != &rhs)
         {
-            m_size = rhs.m_size;
-            if constexpr(!std::is_trivially_copyable<value_type>())
-            {
-                std::copy_n(rhs.m_buffer, m_size, m_buffer);
-            }
-            else
-            {
-                for(size_type i = 0; i < m_size; ++i)
-                {
-                    new(&m_buffer) value_type{std::move(reinterpret_cast<reference>(rhs.m_buffer[i]))};
-                }
-            }
+            clear();
+            construct_from(std::make_move_iterator(rhs.begin()), rhs.m_size);
         }
         return *this;
     }
 
-    ~static_vector()
+    constexpr ~static_vector() requires std::is_trivially_destructible_v<value_type> = default;
+
+    constexpr ~static_vector()
     {
-        if constexpr(!std::is_trivially_destructible<value_type>())
+        std::destroy(begin(), end());
+    }
+
+    constexpr void assign(size_type count, const_reference val)
+    {
+        if(count > S)
+        {
+            throw std::bad_alloc{};
+        }
+
+        clear();
+        for(size_type i = 0; i < count; ++i)
+        {
+            std::construct_at(m_storage.data + i, val);
+        }
+        m_size = static_cast<stored_size_type>(count);
+    }
+
+    template <std::input_iterator input_it>
+    constexpr void assign(input_it first, input_it last)
+    {
+        clear();
+        if constexpr(std::forward_iterator<input_it>)
         {
-            for(size_t i = 0; i < m_size; ++i)
+            const auto count = static_cast<size_type>(std::distance(first, last));
+            if(count > S)
             {
-                reinterpret_cast<reference>(m_buffer[i]).~value_type();
+                throw std::bad_alloc{};
+            }
+            construct_from(first, count);
+        }
+        else
+        {
+            while(first != last)
+            {
+                push_back(*first++);
             }
         }
     }
 
-    bool empty() const
+    constexpr void assign(std::initializer_list<value_type> init)
+    {
+        assign(init.begin(), init.end());
+    }
+
+    constexpr bool empty() const
     {
         return m_size == 0;
     }
 
-    size_type size() const
+    constexpr size_type size() const
     {
         return m_size;
     }
 
-    size_type max_size() const
+    constexpr size_type max_size() const
     {
         return S;
     }
 
-    size_type capacity() const
+    constexpr size_type capacity() const
     {
         return S;
     }
 
-    void push_back(const_reference in)
+    constexpr void push_back(const_reference in)
     {
-        if(m_size == S)
-        {
-            throw std::bad_alloc{};
-        }
-        new(&m_buffer[m_size++]) value_type{in};
+        emplace_back(in);
     }
 
-    void push_back(value_type&& in)
+    constexpr void push_back(value_type&& in)
     {
-        if(m_size == S)
-        {
-            throw std::bad_alloc{};
-        }
-        new(&m_buffer[m_size++]) value_type{std::move(in)};
+        emplace_back(std::move(in));
     }
 
     template <typename... T_ARGS>
-    void emplace_back(T_ARGS&&... args)
+    constexpr reference emplace_back(T_ARGS&&... args)
     {
-        if(m_size <= S)
+        if(m_size == S)
         {
             throw std::bad_alloc{};
         }
-        new(&m_buffer[m_size++]) value_type{std::forward<T_ARGS>(args)...};
+        std::construct_at(m_storage.data + m_size, std::forward<T_ARGS>(args)...);
+        return m_storage.data[m_size++];
     }
 
-    iterator insert(iterator input, const_reference to_insert)
+    template <typename... T_ARGS>
+    constexpr iterator emplace(const_iterator position, T_ARGS&&... args)
     {
         if(m_size == S)
         {
             throw std::bad_alloc{};
         }
 
-        std::move_backward(input, end(), end() + 1);
-
-        if constexpr(!std::is_trivially_destructible<value_type>())
+        const pointer pos = m_storage.data + (position - begin());
+        if(pos == end())
         {
-            input->~value_type();
+            std::construct_at(pos, std::forward<T_ARGS>(args)...);
+        }
+        else
+        {
+            // Construct first, the arguments might refer to elements that get shifted
+            value_type to_insert(std::forward<T_ARGS>(args)...);
+            if(use_memmove())
+            {
+                std::memmove(static_cast<void*>(pos + 1), pos, (end() - pos) * sizeof(value_type));
+                std::construct_at(pos, std::move(to_insert));
+            }
+            else
+            {
+                std::construct_at(end(), std::move(back()));
+                std::move_backward(pos, end() - 1, end());
+                *pos = std::move(to_insert);
+            }
         }
+        ++m_size;
+        return pos;
+    }
 
-        *input = to_insert;
-        m_size++;
-        return input;
+    constexpr iterator insert(const_iterator input, const_reference to_insert)
+    {
+        return emplace(input, to_insert);
     }
 
-    iterator insert(iterator input, value_type&& to_insert)
+    constexpr iterator insert(const_iterator input, value_type&& to_insert)
     {
-        if(m_size == S)
+        return emplace(input, std::move(to_insert));
+    }
+
+    template <std::forward_iterator input_it>
+    constexpr iterator insert(const_iterator input, input_it first, input_it last)
+    {
+        const auto count = static_cast<size_type>(std::distance(first, last));
+        if(count > S - m_size)
         {
             throw std::bad_alloc{};
         }
 
-        std::move_backward(input, end(), end() + 1);
-
-        if constexpr(!std::is_trivially_destructible<value_type>())
+        const pointer pos = m_storage.data + (input - begin());
+        if(use_memmove())
+        {
+            std::memmove(static_cast<void*>(pos + count), pos, (end() - pos) * sizeof(value_type));
+            copy_to(pos, first, count);
+            m_size = static_cast<stored_size_type>(m_size + count);
+        }
+        else
         {
-            input->~value_type();
+            // Append the new elements and rotate them into place
+            const pointer old_end = end();
+            for(; first != last; ++first)
+            {
+                std::construct_at(m_storage.data + m_size, *first);
+                ++m_size;
+            }
+            std::rotate(pos, old_end, end());
         }
+        return pos;
+    }
 
-        *input = std::move(to_insert);
-        m_size++;
-        return input;
+    constexpr iterator insert(const_iterator input, std::initializer_list<value_type> init)
+    {
+        return insert(input, init.begin(), init.end());
     }
 
-    void pop_back()
+    constexpr void pop_back()
     {
         if(m_size > 0)
         {
-            reinterpret_cast<reference>(m_buffer[m_size--]).~value_type();
+            std::destroy_at(m_storage.data + --m_size);
         }
     }
 
-    iterator erase(iterator to_remove)
+    constexpr iterator erase(const_iterator to_remove)
     {
-        if constexpr(!std::is_trivially_destructible<value_type>())
-        {
-            to_remove->~value_type();
-        }
-
-        std::move(to_remove + 1, end(), to_remove);
-        m_size--;
-        return to_remove;
+        return erase(to_remove, to_remove + 1);
     }
 
-    iterator erase(iterator to_remove, iterator end_remove)
+    constexpr iterator erase(const_iterator to_remove, const_iterator end_remove)
     {
-        if constexpr(!std::is_trivially_destructible<value_type>())
+        const pointer first = m_storage.data + (to_remove - begin());
+        const pointer last = m_storage.data + (end_remove - begin());
+        const auto count = static_cast<size_type>(last - first);
+        if(count == 0)
         {
-            for(iterator pos = to_remove; pos != end_remove; ++pos)
-            {
-                pos->~value_type();
-            }
+            return first;
         }
 
-        std::move(end_remove, end(), to_remove);
-        m_size -= std::distance(to_remove, end_remove);
-        return to_remove;
+        if(use_memmove())
+        {
+            std::memmove(static_cast<void*>(first), last, (end() - last) * sizeof(value_type));
+        }
+        else
+        {
+            std::move(last, end(), first);
+            std::destroy(end() - count, end());
+        }
+        m_size = static_cast<stored_size_type>(m_size - count);
+        return first;
     }
 
-    void clear()
+    constexpr void clear()
     {
-        if constexpr(!std::is_trivially_destructible<value_type>())
-        {
-            for(size_type i = 0; i < m_size; ++i)
-            {
-                operator[](i).~value_type();
-            }
-        }
+        std::destroy(begin(), end());
         m_size = 0;
     }
 
-    const_reference at(size_type index) const
+    constexpr const_reference at(size_type index) const
     {
-        if(index > m_size)
+        if(index >= m_size)
         {
             throw std::out_of_range{""};
         }
         return operator[](index);
     }
 
-    reference at(size_type index)
+    constexpr reference at(size_type index)
     {
         if(index >= m_size)
         {
@@ -271,89 +365,146 @@ public:
         return operator[](index);
     }
 
-    const_reference operator[](size_type index) const
+    constexpr const_reference operator[](size_type index) const
     {
-        return *std::launder(reinterpret_cast<const_pointer>(std::addressof(m_buffer[index])));
+        return m_storage.data[index];
     }
 
-    reference operator[](size_t index)
+    constexpr reference operator[](size_type index)
     {
-        return *std::launder(reinterpret_cast<pointer>(std::addressof(m_buffer[index])));
+        return m_storage.data[index];
     }
 
-    void swap(static_vector<T, S>& other)
+    constexpr void swap(static_vector& other)
     {
-        other = std::move(*this);
+        static_vector& shorter = m_size < other.m_size ? *this : other;
+        static_vector& longer = m_size < other.m_size ? other : *this;
+
+        std::swap_ranges(shorter.begin(), shorter.end(), longer.begin());
+        for(size_type i = shorter.m_size; i < longer.m_size; ++i)
+        {
+            std::construct_at(shorter.m_storage.data + i, std::move(longer.m_storage.data[i]));
+        }
+        std::destroy(longer.begin() + shorter.m_size, longer.end());
+        std::swap(m_size, other.m_size);
     }
 
-    const_reference front() const
+    constexpr const_reference front() const
     {
         return operator[](0);
     }
-    reference front()
+    constexpr reference front()
     {
         return operator[](0);
     }
 
-    const_reference back() const
+    constexpr const_reference back() const
     {
         return operator[](m_size - 1);
     }
-    reference back()
+    constexpr reference back()
     {
         return operator[](m_size - 1);
     }
 
-    const_iterator begin() const
+    constexpr const_iterator begin() const
     {
-        return &operator[](0);
+        return m_storage.data;
     }
-    iterator begin()
+    constexpr iterator begin()
     {
-        return &operator[](0);
+        return m_storage.data;
     }
 
-    const_iterator end() const
+    constexpr const_iterator end() const
     {
-        return &operator[](m_size);
+        return m_storage.data + m_size;
     }
-    iterator end()
+    constexpr iterator end()
     {
-        return &operator[](m_size);
+        return m_storage.data + m_size;
     }
 
-    const_iterator rbegin() const
+    constexpr const_reverse_iterator rbegin() const
     {
-        return std::reverse_iterator{&operator[](m_size)};
+        return const_reverse_iterator{end()};
     }
-    iterator rbegin()
+    constexpr reverse_iterator rbegin()
     {
-        return std::reverse_iterator{&operator[](m_size)};
+        return reverse_iterator{end()};
     }
 
-    const_iterator rend() const
+    constexpr const_reverse_iterator rend() const
     {
-        return std::reverse_iterator{&operator[](0)};
+        return const_reverse_iterator{begin()};
     }
-    iterator rend()
+    constexpr reverse_iterator rend()
     {
-        return std::reverse_iterator{&operator[](0)};
+        return reverse_iterator{begin()};
     }
 
-    const_pointer data() const
+    constexpr const_pointer data() const
     {
-        return begin();
+        return m_storage.data;
     }
-    pointer data()
+    constexpr pointer data()
     {
-        return begin();
+        return m_storage.data;
     }
 
 private:
-    std::aligned_storage_t<sizeof(value_type), alignof(value_type)> m_buffer[S];
-    size_type m_size = 0;
+    /// Trivially copyable elements are shifted with memmove, except in constant evaluation
+    static constexpr bool use_memmove()
+    {
+        return trivially_copyable && !std::is_constant_evaluated();
+    }
+
+    /// Constructs count elements from first into the empty vector
+    template <typename input_it>
+    constexpr void construct_from(input_it first, size_type count)
+    {
+        copy_to(m_storage.data, first, count);
+        m_size = static_cast<stored_size_type>(count);
+    }
+
+    /// Creates count elements from first at the uninitialized position dst
+    /// Lowers to memcpy for trivially copyable elements from contiguous memory
+    template <typename input_it>
+    constexpr void copy_to(pointer dst, input_it first, size_type count)
+    {
+        if constexpr(trivially_copyable && std::contiguous_iterator<input_it>
+            && std::is_same_v<std::iter_value_t<input_it>, value_type>)
+        {
+            if(!std::is_constant_evaluated())
+            {
+                if(count > 0)
+                {
+                    std::memcpy(dst, std::to_address(first), count * sizeof(value_type));
+                }
+                return;
+            }
+        }
+
+        for(size_type i = 0; i < count; ++i, ++first)
+        {
+            std::construct_at(dst + i, *first);
+        }
+    }
+
+    internal::uninitialized_array<value_type, S> m_storage;
+    stored_size_type m_size = 0;
 };
 
+template <typename T, size_t S>
+constexpr void swap(static_vector<T, S>& lhs, static_vector<T, S>& rhs)
+{
+    lhs.swap(rhs);
+}
+
+static_assert(sizeof(static_vector<uint8_t, 15>) == 16, "small byte vectors must not carry a size_t");
+static_assert(sizeof(static_vector<uint8_t, 63>) == 64, "static_vector<uint8_t, 63> must fill one cache line");
+static_assert(sizeof(static_vector<uint16_t, 300>) == 602, "size must be stored in a uint16_t");
+
 } // namespace t_ut
 
 #endif
@@ -8,10 +8,33 @@
 #include <condition_variable>
 #include <vector>
 #include <chrono>
+#include <optional>
+#include <string_view>
+
+#include "metrics.hpp"
+#include "move_only_function.hpp"
+#include "object_pool.hpp"
+#include "trace.hpp"
 
 namespace t_ut
 {
 
+/// Metrics a task_runner reports to, durations are in nanoseconds
+struct task_runner_metrics
+{
+    /// Metrics of the t_ut_task_runner_* families in registry, labels tell tasks apart, e.g. task="flush"
+    static task_runner_metrics registered(metrics_registry& registry = metrics_registry::global(),
+        std::string_view labels = {})
+    {
+        return {
+            &registry.get_counter("t_ut_task_runner_runs_total", "Times the task was run", labels),
+            &registry.get_histogram("t_ut_task_runner_run_duration_nanoseconds", "Time one run took", labels)};
+    }
+
+    counter* runs;
+    histogram* duration;
+};
+
 /// Runs a given function periodically with a given delay in a background thread until stop function is called
 /// Automatically stops background task immediately when object gets out of scope
 class task_runner
@@ -26,6 +49,12 @@ class task_runner
 public:
 
     task_runner() = default;
+
+    /// Reports every run of the task and how long it took to metrics
+    explicit task_runner(const task_runner_metrics& metrics)
+        : m_metrics {metrics}
+    {}
+
     task_runner(const task_runner&) = delete;
     task_runner& operator=(const task_runner&) = delete;
     task_runner(task_runner&&) = default;
@@ -36,7 +65,7 @@ public:
         stop();
     }
 
-    void start(const std::function<void()>& func,
+    void start(move_only_function<void()> func,
         const std::chrono::duration<int64_t, std::milli>& delay = std::chrono::milliseconds(100))
     {
         if(m_holder->condition && m_runner.joinable())
@@ -48,10 +77,23 @@ public:
 
         m_holder->condition = true;
 
-        m_runner = std::thread([ptr = m_holder.get(), func, delay]() {
+        m_runner = std::thread([ptr = m_holder.get(), func = std::move(func), delay, metrics = m_metrics]() {
             while(ptr->condition)
             {
-                func();
+                const trace_span span {"task_runner::run"};
+                if(metrics)
+                {
+                    const auto started = std::chrono::steady_clock::now();
+                    func();
+                    const auto took = std::chrono::steady_clock::now() - started;
+                    metrics->runs->add();
+                    metrics->duration->record(
+                        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(took).count()));
+                }
+                else
+                {
+                    func();
+                }
                 std::unique_lock<std::mutex> lock {ptr->mutex};
                 ptr->cv.wait_for(lock, delay, [ptr]() { return !ptr->condition; });
             }
@@ -72,8 +114,9 @@ public:
     }
 
 private:
-    std::unique_ptr<condition_holder> m_holder = std::make_unique<condition_holder>();
+    pooled_ptr<condition_holder> m_holder = make_pooled<condition_holder>();
     std::thread m_runner;
+    std::optional<task_runner_metrics> m_metrics;
 };
 
 /// Manages several task_runner objects with their own condition_variable
@@ -87,11 +130,11 @@ public:
         stop_all();
     }
 
-    size_t add(const std::function<void()>& func,
+    size_t add(move_only_function<void()> func,
         const std::chrono::duration<int64_t, std::milli>& delay = std::chrono::milliseconds(100))
     {
         task_runner& runner = m_runners.emplace_back();
-        runner.start(func, delay);
+        runner.start(std::move(func), delay);
         return m_runners.size() - 1;
     }
 
@@ -0,0 +1,172 @@
+#ifndef CPP_UTILITY_THREAD_CACHE_HPP
+#define CPP_UTILITY_THREAD_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "small_vector.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Number of depots closed so far, thread caches look for closed depots only when it changed
+inline std::atomic<uint64_t> closed_depot_count = 0;
+
+/// Base of the depots of thread_caches, the resource owning the depot closes it when it is destroyed so that the
+///     caches of other threads drop the depot on their next lookup instead of keeping it alive until they exit
+class cached_depot
+{
+public:
+    void close() noexcept
+    {
+        m_closed.store(true, std::memory_order_relaxed);
+        closed_depot_count.fetch_add(1, std::memory_order_release);
+    }
+
+    bool closed() const noexcept
+    {
+        return m_closed.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<bool> m_closed = false;
+};
+
+/// Per thread state of every pooled resource a thread used, looked up by the depot the resource shares with all threads
+/// DEPOT derives from cached_depot. CACHE is constructed from the depot and gives everything back to it in flush(),
+///     which happens when the resource is destroyed on this thread, on the next lookup of this thread after the depot
+///     was closed, or when the thread exits. Holding the depot keeps it alive, so caches of other threads stay valid
+///     after the resource itself is gone
+template <typename DEPOT, typename CACHE>
+class thread_caches
+{
+public:
+    thread_caches() = default;
+    thread_caches(const thread_caches&) = delete;
+    thread_caches& operator=(const thread_caches&) = delete;
+
+    ~thread_caches()
+    {
+        last() = {};
+        for(auto& e : m_entries)
+            e.cache.flush(*e.depot);
+        alive() = false;
+    }
+
+    /// Caches of the calling thread, null once they were destroyed, e.g. for calls from other thread_local destructors
+    static thread_caches* local()
+    {
+        if(!alive())
+            return nullptr;
+        thread_local thread_caches caches;
+        return &caches;
+    }
+
+    /// Cache of the calling thread for depot, null once the thread caches were destroyed
+    /// The cache used last is remembered outside of the thread caches, which makes repeated calls for the same depot
+    ///     cheaper than local() and find()
+    static CACHE* local(const std::shared_ptr<DEPOT>& depot)
+    {
+        const uint64_t closed = closed_depot_count.load(std::memory_order_acquire);
+        if(const auto& l = last(); l.depot == depot.get() && l.cache && l.closed == closed)
+            return l.cache;
+
+        auto* caches = local();
+        if(!caches)
+            return nullptr;
+        CACHE* cache = &caches->find(depot);
+        last() = {depot.get(), cache, closed};
+        return cache;
+    }
+
+    CACHE& find(const std::shared_ptr<DEPOT>& depot)
+    {
+        if(const uint64_t closed = closed_depot_count.load(std::memory_order_acquire); closed != m_closed)
+        {
+            m_closed = closed;
+            prune();
+        }
+
+        if(m_last < m_entries.size() && m_entries[m_last].depot == depot)
+            return m_entries[m_last].cache;
+
+        for(m_last = 0; m_last < m_entries.size(); ++m_last)
+        {
+            if(m_entries[m_last].depot == depot)
+                return m_entries[m_last].cache;
+        }
+
+        prune();
+        last() = {};
+        m_entries.push_back({depot, CACHE{*depot}});
+        m_last = m_entries.size() - 1;
+        return m_entries.back().cache;
+    }
+
+    void drop(const DEPOT* depot) noexcept
+    {
+        for(size_t i = 0; i < m_entries.size(); ++i)
+        {
+            if(m_entries[i].depot.get() == depot)
+                return erase(i);
+        }
+    }
+
+private:
+    struct entry
+    {
+        std::shared_ptr<DEPOT> depot;
+        CACHE cache;
+    };
+
+    /// closed is the closed_depot_count the entry was looked up with, the entry is not used once a depot was closed
+    struct last_entry
+    {
+        const DEPOT* depot = nullptr;
+        CACHE* cache = nullptr;
+        uint64_t closed = 0;
+    };
+
+    /// Entries move when others are added or erased, so this is reset on both
+    static last_entry& last() noexcept
+    {
+        thread_local last_entry value;
+        return value;
+    }
+
+    static bool& alive() noexcept
+    {
+        thread_local bool value = true;
+        return value;
+    }
+
+    /// Drops the entries of resources that are closed or no longer exist anywhere but in thread caches
+    void prune() noexcept
+    {
+        for(size_t i = m_entries.size(); i-- > 0;)
+        {
+            if(m_entries[i].depot->closed() || m_entries[i].depot.use_count() == 1)
+                erase(i);
+        }
+    }
+
+    void erase(size_t index) noexcept
+    {
+        last() = {};
+        m_entries[index].cache.flush(*m_entries[index].depot);
+        m_entries.erase(m_entries.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
+    small_vector<entry, 4> m_entries;
+    size_t m_last = 0;
+    uint64_t m_closed = 0;
+};
+
+} // namespace internal
+
+} // namespace t_ut
+
+#endif
@@ -1,44 +1,105 @@
 #ifndef CPP_UTILITY_THREAD_POOL_HPP
 #define CPP_UTILITY_THREAD_POOL_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 #include <vector>
-#include <queue>
 #include <thread>
 #include <mutex>
+#include <utility>
 #include <condition_variable>
 
+#include "metrics.hpp"
+#include "move_only_function.hpp"
+#include "object_pool.hpp"
+#include "trace.hpp"
+
 namespace t_ut
 {
 
+/// Metrics a thread_pool reports to, durations are in nanoseconds
+struct thread_pool_metrics
+{
+    /// Metrics of the t_ut_thread_pool_* families in registry, labels tell pools apart, e.g. pool="io"
+    static thread_pool_metrics registered(metrics_registry& registry = metrics_registry::global(),
+        std::string_view labels = {})
+    {
+        return {
+            &registry.get_counter("t_ut_thread_pool_jobs_submitted_total", "Jobs added to the queue", labels),
+            &registry.get_counter("t_ut_thread_pool_jobs_completed_total", "Jobs that were run", labels),
+            &registry.get_gauge("t_ut_thread_pool_queue_length", "Jobs waiting in the queue", labels),
+            &registry.get_histogram("t_ut_thread_pool_queue_wait_nanoseconds", "Time jobs waited in the queue", labels),
+            &registry.get_histogram("t_ut_thread_pool_job_duration_nanoseconds", "Time jobs ran", labels)};
+    }
+
+    counter* submitted;
+    counter* completed;
+    gauge* queued;
+    histogram* queue_wait;
+    histogram* duration;
+};
+
 /// Simple implementation of a thread pool that just runs tasks without preemption
 class thread_pool
 {
-public:
+    using job_type = move_only_function<void()>;
+    using clock = std::chrono::steady_clock;
 
-    thread_pool()
-        : m_pool_size {std::thread::hardware_concurrency()}
+    /// Pending jobs form a list whose nodes all have the same size, so by default they come from an object_pool
+    struct job_node
     {
-        m_workers.reserve(m_pool_size);
-        m_running = true;
+        job_node(job_type&& func, clock::time_point added, trace_flow flow) noexcept
+            : job {std::move(func)}
+            , added {added}
+            , flow {flow}
+        {}
+
+        job_type job;
+        job_node* next = nullptr;
+        /// Only taken when the pool reports metrics
+        clock::time_point added;
+        /// Links the job to the thread that added it while tracing
+        trace_flow flow;
+    };
 
-        for(size_t i = 0; i < m_pool_size; ++i)
-            m_workers.emplace_back(&thread_pool::loop, this);
-    }
-
-    thread_pool(size_t size)
-        : m_pool_size {size}
-    {
-        m_workers.reserve(m_pool_size);
-        m_running = true;
+public:
 
-        for(size_t i = 0; i < m_pool_size; ++i)
-            m_workers.emplace_back(&thread_pool::loop, this);
-    }
+    thread_pool()
+        : thread_pool {std::thread::hardware_concurrency()}
+    {}
+
+    /// The nodes of the queue of pending jobs are allocated from resource, which is only used while the queue is
+    ///     locked so it does not have to be thread safe, jobs up to the inline size of move_only_function do not
+    ///     allocate on their own, so the default pool runs without malloc once it has grown to the queue length
+    thread_pool(size_t size, std::pmr::memory_resource* resource = &object_pool<job_node>::shared().resource())
+        : thread_pool {size, resource, std::nullopt}
+    {}
+
+    /// Reports the jobs that are added and run, how long they waited and how long they ran to metrics
+    thread_pool(size_t size, const thread_pool_metrics& metrics,
+        std::pmr::memory_resource* resource = &object_pool<job_node>::shared().resource())
+        : thread_pool {size, resource, std::optional<thread_pool_metrics> {metrics}}
+    {}
 
     ~thread_pool()
     {
         if(m_running)
             stop();
+
+        // Jobs added after stop() are never run
+        while(m_head)
+            m_alloc.delete_object(std::exchange(m_head, m_head->next));
+    }
+
+    /// Pool of hardware_concurrency threads for work the t_ut types run in the background, it is never destroyed
+    static thread_pool& shared()
+    {
+        static auto* pool = new thread_pool {std::max(std::thread::hardware_concurrency(), 1u)};
+        return *pool;
     }
 
     bool running() const
@@ -51,20 +112,36 @@ public:
         return m_pool_size;
     }
 
-    void add_job(std::function<void()> func)
+    void add_job(job_type func)
     {
+        const trace_span span {"thread_pool::add_job"};
+        const trace_flow flow = trace_flow::begin("thread_pool::job");
+        const clock::time_point added = m_metrics ? clock::now() : clock::time_point {};
         {
             const std::lock_guard<std::mutex> lock {m_qmutex};
-            m_queue.push(std::move(func));
+            job_node* node = m_alloc.new_object<job_node>(std::move(func), added, flow);
+            if(m_tail)
+                m_tail->next = node;
+            else
+                m_head = node;
+            m_tail = node;
+            // Under the lock, a worker could take the job and subtract it before it was added otherwise
+            if(m_metrics)
+                m_metrics->queued->add();
         }
+        if(m_metrics)
+            m_metrics->submitted->add();
         m_cv.notify_one();
     }
 
     void stop()
     {
-        if(!m_running)
-            return;
-        m_running = false;
+        {
+            const std::lock_guard<std::mutex> lock {m_qmutex};
+            if(!m_running)
+                return;
+            m_running = false;
+        }
 
         m_cv.notify_all();
 
@@ -80,35 +157,78 @@ public:
 
 private:
 
+    thread_pool(size_t size, std::pmr::memory_resource* resource, std::optional<thread_pool_metrics> metrics)
+        : m_pool_size {size}
+        , m_alloc {resource}
+        , m_metrics {metrics}
+    {
+        m_workers.reserve(m_pool_size);
+        m_running = true;
+
+        for(size_t i = 0; i < m_pool_size; ++i)
+            m_workers.emplace_back(&thread_pool::loop, this);
+    }
+
+    static uint64_t elapsed_ns(clock::time_point from, clock::time_point to)
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
     void loop()
     {
-        std::function<void()> func;
+        job_type func;
+        clock::time_point added;
+        trace_flow flow;
 
-        while(m_running || !m_queue.empty())
+        while(true)
         {
             {
                 std::unique_lock<std::mutex> lock {m_qmutex};
-                m_cv.wait(lock, [this]() { return (!m_queue.empty() || !m_running); });
-                if(!m_running && m_queue.empty())
+                m_cv.wait(lock, [this]() { return (m_head || !m_running); });
+                // Remaining jobs are still processed after stop was called
+                if(!m_head)
                     return;
-                else if(m_queue.empty())
-                    continue;
 
-                func = m_queue.front();
-                m_queue.pop();
+                job_node* node = std::exchange(m_head, m_head->next);
+                if(!m_head)
+                    m_tail = nullptr;
+                func = std::move(node->job);
+                added = node->added;
+                flow = node->flow;
+                m_alloc.delete_object(node);
+                if(m_metrics)
+                    m_metrics->queued->sub();
             }
 
+            const trace_span span {"thread_pool::run"};
+            flow.end();
+            if(!m_metrics)
+            {
+                func();
+                continue;
+            }
+
+            const clock::time_point started = clock::now();
+            m_metrics->queue_wait->record(elapsed_ns(added, started));
             func();
+            m_metrics->completed->add();
+            m_metrics->duration->record(elapsed_ns(started, clock::now()));
         }
     }
 
-    bool m_running = false;
+    std::atomic<bool> m_running = false;
 
     size_t m_pool_size;
 
     std::vector<std::thread> m_workers;
 
-    std::queue<std::function<void()>> m_queue;
+    std::pmr::polymorphic_allocator<job_node> m_alloc;
+
+    std::optional<thread_pool_metrics> m_metrics;
+
+    job_node* m_head = nullptr;
+
+    job_node* m_tail = nullptr;
 
     std::mutex m_qmutex;
 
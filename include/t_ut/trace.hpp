@@ -0,0 +1,414 @@
+#ifndef CPP_UTILITY_TRACE_HPP
+#define CPP_UTILITY_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "ringbuffer.hpp"
+
+namespace t_ut {
+
+namespace internal {
+
+/// Events a thread can record before they are collected, further events are dropped and counted
+inline constexpr size_t trace_buffer_size = size_t{1} << 14;
+
+/// Checked by every span, so a disabled span costs one load and a branch
+inline std::atomic<bool> trace_enabled = false;
+
+/// Time stamp counter where there is one, it is converted to microseconds when the trace is collected
+inline uint64_t trace_clock() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+enum class trace_phase : uint8_t
+{
+    complete,
+    flow_begin,
+    flow_end
+};
+
+struct trace_event
+{
+    uint64_t time;
+    /// Names are not copied, so they have to outlive the trace, e.g. string literals
+    const char* name;
+    /// Duration of a complete event, id of a flow event
+    uint64_t value;
+    trace_phase phase;
+};
+
+/// Written only by its thread and read only by the collector, which holds the lock of the trace_state
+struct trace_buffer
+{
+    explicit trace_buffer(uint32_t tid)
+        : tid{tid}
+    {}
+
+    spsc_ringbuffer<trace_event, trace_buffer_size> events;
+    std::atomic<uint64_t> dropped = 0;
+    const uint32_t tid;
+    /// Guarded by the lock of the trace_state
+    std::string name;
+};
+
+class trace_state
+{
+public:
+    static trace_state& instance()
+    {
+        static auto* state = new trace_state;
+        return *state;
+    }
+
+    std::shared_ptr<trace_buffer> add_buffer(std::string_view name)
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        auto buffer = std::make_shared<trace_buffer>(m_next_tid++);
+        buffer->name = name;
+        m_buffers.push_back(buffer);
+        return buffer;
+    }
+
+    void set_name(trace_buffer& buffer, std::string_view name)
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        buffer.name = name;
+    }
+
+    void start()
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        if(trace_enabled.load(std::memory_order_relaxed))
+            return;
+
+        // Drop what was recorded since the last collection
+        for(auto& buffer : m_buffers)
+        {
+            while(buffer->events.try_pop())
+            {}
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+        drop_exited();
+
+        m_start_ticks = trace_clock();
+        m_start_time = std::chrono::steady_clock::now();
+        trace_enabled.store(true, std::memory_order_release);
+    }
+
+    void stop() noexcept
+    {
+        trace_enabled.store(false, std::memory_order_release);
+    }
+
+    std::string collect_json()
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+
+        // Ticks per microsecond from the clock rates since start()
+        const double elapsed_us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - m_start_time).count();
+        const uint64_t ticks = trace_clock() - m_start_ticks;
+        const double ticks_per_us = elapsed_us > 0 && ticks > 0 ? static_cast<double>(ticks) / elapsed_us : 1;
+
+        std::string out = "{\"traceEvents\":[";
+        bool first = true;
+        uint64_t dropped = 0;
+        for(auto& buffer : m_buffers)
+        {
+            if(!buffer->name.empty())
+            {
+                separate(out, first);
+                out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":");
+                append_number(out, buffer->tid);
+                out.append(",\"args\":{\"name\":");
+                append_string(out, buffer->name);
+                out.append("}}");
+            }
+            while(auto event = buffer->events.try_pop())
+            {
+                separate(out, first);
+                append_event(out, *event, buffer->tid, ticks_per_us);
+            }
+            dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        }
+        drop_exited();
+
+        out.append("],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":\"");
+        append_number(out, dropped);
+        out.append("\"}}");
+        return out;
+    }
+
+private:
+    trace_state() = default;
+
+    /// Buffers that only the state still holds belong to threads that exited
+    void drop_exited()
+    {
+        std::erase_if(m_buffers, [](const auto& buffer) { return buffer.use_count() == 1 && buffer->events.empty(); });
+    }
+
+    void append_event(std::string& out, const trace_event& event, uint32_t tid, double ticks_per_us) const
+    {
+        // Events of spans that started before start() are clamped to it
+        const uint64_t since_start = event.time > m_start_ticks ? event.time - m_start_ticks : 0;
+        constexpr const char* phases[] = {"X", "s", "f"};
+
+        out.append("{\"ph\":\"").append(phases[static_cast<size_t>(event.phase)]).append("\",\"name\":");
+        append_string(out, event.name);
+        out.append(",\"pid\":1,\"tid\":");
+        append_number(out, tid);
+        out.append(",\"ts\":");
+        append_number(out, static_cast<double>(since_start) / ticks_per_us);
+        if(event.phase == trace_phase::complete)
+        {
+            out.append(",\"dur\":");
+            append_number(out, static_cast<double>(event.value) / ticks_per_us);
+        }
+        else
+        {
+            // Flow events are matched by category, name and id, the end binds to the span that encloses it
+            out.append(",\"cat\":\"t_ut\",\"id\":");
+            append_number(out, event.value);
+            if(event.phase == trace_phase::flow_end)
+                out.append(",\"bp\":\"e\"");
+        }
+        out.append("}");
+    }
+
+    static void separate(std::string& out, bool& first)
+    {
+        if(!first)
+            out.append(",\n");
+        first = false;
+    }
+
+    template <typename T>
+    static void append_number(std::string& out, T value)
+    {
+        char buffer[32];
+        std::to_chars_result result;
+        if constexpr(std::is_floating_point_v<T>)
+            result = std::to_chars(std::begin(buffer), std::end(buffer), value, std::chars_format::fixed, 3);
+        else
+            result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    static void append_string(std::string& out, std::string_view value)
+    {
+        constexpr char hex[] = "0123456789abcdef";
+        out.push_back('"');
+        for(char c : value)
+        {
+            if(c == '"' || c == '\\')
+            {
+                out.push_back('\\');
+                out.push_back(c);
+            }
+            else if(static_cast<unsigned char>(c) < 0x20)
+            {
+                out.append("\\u00");
+                out.push_back(hex[(c >> 4) & 0xF]);
+                out.push_back(hex[c & 0xF]);
+            }
+            else
+            {
+                out.push_back(c);
+            }
+        }
+        out.push_back('"');
+    }
+
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<trace_buffer>> m_buffers;
+    uint32_t m_next_tid = 1;
+    uint64_t m_start_ticks = 0;
+    std::chrono::steady_clock::time_point m_start_time;
+};
+
+/// Buffer of the calling thread, created on its first event and kept by the trace_state after the thread exits until
+///     its events were collected
+struct trace_thread
+{
+    trace_thread() = default;
+    trace_thread(const trace_thread&) = delete;
+    trace_thread& operator=(const trace_thread&) = delete;
+
+    ~trace_thread()
+    {
+        alive() = false;
+    }
+
+    /// Null once the thread is exiting and its trace_thread was destroyed, or if there was no memory for the buffer
+    static trace_thread* local() noexcept
+    {
+        if(!alive())
+            return nullptr;
+        thread_local trace_thread thread;
+        if(!thread.buffer)
+        {
+            try
+            {
+                thread.buffer = trace_state::instance().add_buffer({});
+            }
+            catch(...)
+            {
+                return nullptr;
+            }
+        }
+        return &thread;
+    }
+
+    static bool& alive() noexcept
+    {
+        thread_local bool value = true;
+        return value;
+    }
+
+    std::shared_ptr<trace_buffer> buffer;
+    uint64_t flows = 0;
+};
+
+inline void record_trace(const trace_event& event) noexcept
+{
+    if(trace_thread* thread = trace_thread::local())
+    {
+        if(!thread->buffer->events.try_push(event))
+            thread->buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace internal
+
+/// Process wide recording of trace_span and trace_flow events into per thread buffers
+/// The collected trace is in the Chrome trace event format, which chrome://tracing and Perfetto open
+class tracer
+{
+public:
+    /// Starts recording, events that were recorded but not collected yet are dropped
+    static void start()
+    {
+        internal::trace_state::instance().start();
+    }
+
+    /// Spans that are open keep recording until they end
+    static void stop() noexcept
+    {
+        internal::trace_state::instance().stop();
+    }
+
+    static bool enabled() noexcept
+    {
+        return internal::trace_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Moves the recorded events of all threads into a JSON trace, can be called while recording to keep the buffers
+    ///     from overflowing, every call returns the events since the previous one
+    static std::string collect_json()
+    {
+        return internal::trace_state::instance().collect_json();
+    }
+
+    /// Name the calling thread has in the trace
+    static void set_thread_name(std::string_view name)
+    {
+        if(auto* thread = internal::trace_thread::local())
+            internal::trace_state::instance().set_name(*thread->buffer, name);
+    }
+};
+
+/// Records the time from its construction to its destruction as a slice of the calling thread
+/// name is not copied and has to outlive the trace, e.g. a string literal
+class trace_span
+{
+public:
+    explicit trace_span(const char* name) noexcept
+        : m_name{tracer::enabled() ? name : nullptr}
+        , m_begin{m_name ? internal::trace_clock() : 0}
+    {}
+
+    trace_span(const trace_span&) = delete;
+    trace_span& operator=(const trace_span&) = delete;
+
+    ~trace_span()
+    {
+        if(m_name)
+        {
+            const uint64_t duration = internal::trace_clock() - m_begin;
+            internal::record_trace({m_begin, m_name, duration, internal::trace_phase::complete});
+        }
+    }
+
+private:
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+/// Arrow from the span a flow begins in to the span it ends in, usually on another thread, e.g. from the thread that
+///     submits a job to the one that runs it. A flow that began while tracing was disabled is empty and ends nowhere
+class trace_flow
+{
+public:
+    trace_flow() = default;
+
+    /// name is not copied and has to outlive the trace, e.g. a string literal
+    static trace_flow begin(const char* name) noexcept
+    {
+        if(!tracer::enabled())
+            return {};
+        internal::trace_thread* thread = internal::trace_thread::local();
+        if(!thread)
+            return {};
+
+        // Unique without a shared counter, the thread id is in the upper bits
+        const uint64_t id = (uint64_t{thread->buffer->tid} << 40) | ++thread->flows;
+        internal::record_trace({internal::trace_clock(), name, id, internal::trace_phase::flow_begin});
+        return trace_flow{name, id};
+    }
+
+    /// Call inside the span the flow leads to
+    void end() const noexcept
+    {
+        if(m_id != 0 && tracer::enabled())
+            internal::record_trace({internal::trace_clock(), m_name, m_id, internal::trace_phase::flow_end});
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return m_id != 0;
+    }
+
+private:
+    trace_flow(const char* name, uint64_t id) noexcept
+        : m_name{name}
+        , m_id{id}
+    {}
+
+    const char* m_name = nullptr;
+    uint64_t m_id = 0;
+};
+
+} // namespace t_ut
+
+#endif
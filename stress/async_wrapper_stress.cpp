@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <t_ut/arena_resource.hpp>
+#include <t_ut/async_wrapper.hpp>
+#include <t_ut/thread_pool.hpp>
+
+#include "stress.hpp"
+
+namespace t_ut::stress
+{
+
+namespace
+{
+
+/// Steps chained with then() run in order, also when the value is ready before they are chained
+void check_continuation_order(report& rep)
+{
+    async_wrapper<std::vector<int>> chain{[]() { return std::vector<int>{}; }};
+    for(int step = 0; step < 8; ++step)
+    {
+        if(step == 4)
+            chain.wait();
+        chain = chain.then([step](std::vector<int> steps) {
+            steps.push_back(step);
+            return steps;
+        });
+    }
+    chain.wait();
+    if(chain.get() != std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7})
+        rep.errors.push_back("continuations ran out of order");
+}
+
+/// An exception skips the continuations, reaches the end of the chain and fails when_all once all inputs are done
+void check_exception_propagation(report& rep)
+{
+    bool skipped = true;
+    async_wrapper<int> failing{[]() -> int { throw std::runtime_error{"failed"}; }};
+    auto chained = failing.then([&](int v) {
+        skipped = false;
+        return v;
+    });
+    chained.wait();
+    try
+    {
+        chained.get();
+        rep.errors.push_back("then() did not forward the exception");
+    }
+    catch(const std::runtime_error&)
+    {}
+    if(!skipped)
+        rep.errors.push_back("then() ran its function after an exception");
+
+    std::vector<async_wrapper<int>> inputs;
+    inputs.emplace_back([]() { return 1; });
+    inputs.emplace_back([]() -> int { throw std::runtime_error{"failed"}; });
+    auto all = when_all(std::move(inputs));
+    all.wait();
+    try
+    {
+        all.get();
+        rep.errors.push_back("when_all() did not forward the exception");
+    }
+    catch(const std::runtime_error&)
+    {}
+}
+
+/// when_any is ready with the first input while the other one is still blocked
+void check_when_any_first(report& rep)
+{
+    thread_pool pool{2};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    std::vector<async_wrapper<int>> inputs;
+    inputs.emplace_back(pool, [released]() {
+        released.wait();
+        return 0;
+    });
+    inputs.emplace_back(pool, []() { return 1; });
+    auto any = when_any(std::move(inputs));
+    any.wait();
+    if(any.get() != std::pair<size_t, int>{1, 1})
+        rep.errors.push_back("when_any() did not complete with the first input");
+    release.set_value();
+}
+
+} // namespace
+
+/// Every round allocates the states of a wrapper, its continuation and a when_all from an arena that is destroyed as
+///     soon as the values were taken, so a producer that still touches its state afterwards is a use after free under
+///     ASan
+/// Combinators without inputs have to be ready right away
+report run_async_wrapper(const options& opts)
+{
+    report rep{"async_wrapper arena", {}, {}};
+    latency_histogram latency;
+    latency_histogram all_latency;
+
+    const size_t rounds = std::max<size_t>(opts.operations / 100, 1);
+    for(size_t i = 0; i < rounds; ++i)
+    {
+        auto arena = std::make_unique<arena_resource>(256);
+        uint64_t start = now_ns();
+        std::optional<uint64_t> value;
+        {
+            async_wrapper<uint64_t> wrapper{std::allocator_arg, arena.get(), [i]() { return uint64_t{i}; }};
+            auto chained = wrapper.then([](uint64_t v) { return v + 1; });
+            chained.wait();
+            value = chained.get();
+        }
+        arena.reset();
+        latency.record(now_ns() - start);
+
+        if(value != i + 1)
+            rep.errors.push_back("round " + std::to_string(i) + " got a wrong value");
+
+        arena = std::make_unique<arena_resource>(1024);
+        start = now_ns();
+        std::optional<std::vector<uint64_t>> values;
+        {
+            std::vector<async_wrapper<uint64_t>> inputs;
+            for(uint64_t k = 0; k < 4; ++k)
+                inputs.emplace_back(std::allocator_arg, arena.get(), [i, k]() { return i + k; });
+            auto all = when_all(std::move(inputs));
+            all.wait();
+            values = all.get();
+        }
+        arena.reset();
+        all_latency.record(now_ns() - start);
+
+        if(values != std::vector<uint64_t>{i, i + 1, i + 2, i + 3})
+            rep.errors.push_back("round " + std::to_string(i) + " got wrong values from when_all()");
+    }
+
+    rep.histogram("then").merge(latency);
+    rep.histogram("when_all").merge(all_latency);
+
+    check_continuation_order(rep);
+    check_exception_propagation(rep);
+    check_when_any_first(rep);
+
+    if(!when_all().ready())
+        rep.errors.push_back("when_all() without wrappers is not ready");
+    if(!when_all(std::vector<async_wrapper<uint64_t>>{}).ready())
+        rep.errors.push_back("when_all() of an empty vector is not ready");
+
+    rep.print();
+    return rep;
+}
+
+} // namespace t_ut::stress
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <t_ut/chan.hpp>
+
+#include "stress.hpp"
+
+namespace t_ut::stress
+{
+
+namespace
+{
+
+/// Runs producers and consumers against one channel
+/// Channels drop the oldest value when they are full, so a value may be lost but never duplicated or reordered
+///     between one producer and one consumer
+template <typename CHAN>
+void run_topology(CHAN& ch, const options& opts, report& rep)
+{
+    std::mutex report_mutex;
+    std::vector<std::atomic<bool>> seen(opts.producers * opts.operations);
+    std::atomic<size_t> consumers_done = 0;
+    std::atomic<size_t> received = 0;
+
+    std::vector<std::thread> consumers;
+    for(size_t c = 0; c < opts.consumers; ++c)
+    {
+        consumers.emplace_back([&, ch]() mutable {
+            latency_histogram receive_latency;
+            latency_histogram end_to_end;
+            std::vector<int64_t> last_sequence(opts.producers, -1);
+            std::vector<std::string> errors;
+
+            while(true)
+            {
+                const uint64_t start = now_ns();
+                const message msg = ch.receive();
+                const uint64_t end = now_ns();
+                if(msg.producer == message::stop)
+                    break;
+
+                receive_latency.record(end - start);
+                end_to_end.record(end - msg.sent_ns);
+                received.fetch_add(1, std::memory_order_relaxed);
+
+                if(static_cast<int64_t>(msg.sequence) <= last_sequence[msg.producer])
+                    errors.push_back("consumer saw producer " + std::to_string(msg.producer) + " out of order");
+                last_sequence[msg.producer] = msg.sequence;
+
+                if(seen[msg.producer * opts.operations + msg.sequence].exchange(true))
+                    errors.push_back("duplicate message " + std::to_string(msg.sequence));
+            }
+
+            consumers_done.fetch_add(1);
+            const std::lock_guard<std::mutex> lock{report_mutex};
+            rep.histogram("receive").merge(receive_latency);
+            rep.histogram("end_to_end").merge(end_to_end);
+            rep.errors.insert(rep.errors.end(), errors.begin(), errors.end());
+        });
+    }
+
+    std::vector<std::thread> producers;
+    for(size_t p = 0; p < opts.producers; ++p)
+    {
+        producers.emplace_back([&, ch, p]() mutable {
+            latency_histogram send_latency;
+            for(size_t i = 0; i < opts.operations; ++i)
+            {
+                const uint64_t start = now_ns();
+                ch.send(message{start, static_cast<uint32_t>(p), static_cast<uint32_t>(i)});
+                send_latency.record(now_ns() - start);
+            }
+
+            const std::lock_guard<std::mutex> lock{report_mutex};
+            rep.histogram("send").merge(send_latency);
+        });
+    }
+
+    for(auto& producer : producers)
+        producer.join();
+
+    // Stop messages can be overwritten as well, so keep sending until every consumer left
+    while(consumers_done.load() != opts.consumers)
+    {
+        ch.send(message{0, message::stop, 0});
+        std::this_thread::yield();
+    }
+
+    for(auto& consumer : consumers)
+        consumer.join();
+
+    if(received.load() > opts.producers * opts.operations)
+        rep.errors.push_back("received more messages than were sent");
+}
+
+} // namespace
+
+report run_chan(const options& opts)
+{
+    report rep{"chan<message, 64> " + std::to_string(opts.producers) + "p/" + std::to_string(opts.consumers) + "c",
+        {},
+        {}};
+    t_ut::chan<message, 64> buffered;
+    run_topology(buffered, opts, rep);
+    rep.print();
+
+    report unbuffered_rep{
+        "chan<message> " + std::to_string(opts.producers) + "p/" + std::to_string(opts.consumers) + "c", {}, {}};
+    t_ut::chan<message> unbuffered;
+    run_topology(unbuffered, opts, unbuffered_rep);
+    unbuffered_rep.print();
+
+    rep.errors.insert(rep.errors.end(), unbuffered_rep.errors.begin(), unbuffered_rep.errors.end());
+    return rep;
+}
+
+} // namespace t_ut::stress
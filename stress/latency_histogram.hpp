@@ -0,0 +1,72 @@
+#ifndef T_UT_STRESS_LATENCY_HISTOGRAM_HPP
+#define T_UT_STRESS_LATENCY_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include <t_ut/metrics.hpp>
+
+namespace t_ut::stress
+{
+
+/// HDR style log-linear histogram of nanosecond latencies, values below 128 are recorded exactly, larger ones with a
+///     relative error below 1.6%
+/// Not thread safe, every thread records into its own histogram and they are merged afterwards
+class latency_histogram
+{
+    using buckets = internal::log_linear_buckets<7>;
+    static constexpr size_t bucket_count = buckets::count;
+
+public:
+    void record(uint64_t value)
+    {
+        ++m_counts[buckets::index_of(value)];
+        ++m_total;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    void merge(const latency_histogram& other)
+    {
+        for(size_t i = 0; i < bucket_count; ++i)
+            m_counts[i] += other.m_counts[i];
+        m_total += other.m_total;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    uint64_t count() const
+    {
+        return m_total;
+    }
+
+    uint64_t min() const
+    {
+        return m_total == 0 ? 0 : m_min;
+    }
+
+    uint64_t max() const
+    {
+        return m_max;
+    }
+
+    /// Highest value equivalent to the recorded value at the given percentile in [0, 100]
+    uint64_t percentile(double percent) const
+    {
+        if(m_total == 0)
+            return 0;
+        return std::min(buckets::highest_value_of(buckets::percentile_index(m_counts, m_total, percent)), m_max);
+    }
+
+private:
+    std::array<uint64_t, bucket_count> m_counts{};
+    uint64_t m_total = 0;
+    uint64_t m_min = std::numeric_limits<uint64_t>::max();
+    uint64_t m_max = 0;
+};
+
+} // namespace t_ut::stress
+
+#endif
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "stress.hpp"
+
+namespace
+{
+
+void usage(const char* name)
+{
+    std::printf("usage: %s [async_wrapper|chan|ringbuffer|thread_pool|all] [--producers N] [--consumers N] [--workers N] "
+                "[--operations N]\n",
+        name);
+}
+
+} // namespace
+
+/// Runs the selected stress targets and prints their latency percentiles
+/// Exits with a non zero status if any target detected lost, duplicated or reordered data
+int main(int argc, char** argv)
+{
+    t_ut::stress::options opts;
+    std::string target = "all";
+
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto next_value = [&]() -> size_t {
+            if(i + 1 >= argc)
+            {
+                usage(argv[0]);
+                std::exit(2);
+            }
+            return std::strtoull(argv[++i], nullptr, 10);
+        };
+
+        if(arg == "--producers")
+            opts.producers = next_value();
+        else if(arg == "--consumers")
+            opts.consumers = next_value();
+        else if(arg == "--workers")
+            opts.workers = next_value();
+        else if(arg == "--operations")
+            opts.operations = next_value();
+        else if(arg == "--help" || arg == "-h")
+        {
+            usage(argv[0]);
+            return 0;
+        }
+        else
+            target = arg;
+    }
+
+    if(opts.producers == 0 || opts.consumers == 0 || opts.workers == 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    size_t errors = 0;
+    bool ran = false;
+
+    if(target == "all" || target == "async_wrapper")
+    {
+        errors += t_ut::stress::run_async_wrapper(opts).errors.size();
+        ran = true;
+    }
+    if(target == "all" || target == "chan")
+    {
+        errors += t_ut::stress::run_chan(opts).errors.size();
+        ran = true;
+    }
+    if(target == "all" || target == "ringbuffer")
+    {
+        errors += t_ut::stress::run_spsc_ringbuffer(opts).errors.size();
+        ran = true;
+    }
+    if(target == "all" || target == "thread_pool")
+    {
+        errors += t_ut::stress::run_thread_pool(opts).errors.size();
+        ran = true;
+    }
+
+    if(!ran)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    return errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
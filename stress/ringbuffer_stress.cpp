@@ -0,0 +1,58 @@
+#include <thread>
+
+#include <t_ut/ringbuffer.hpp>
+
+#include "stress.hpp"
+
+namespace t_ut::stress
+{
+
+/// The spsc_ringbuffer only supports one producer and one consumer, the topology options are ignored
+/// Every message has to arrive exactly once and in order
+report run_spsc_ringbuffer(const options& opts)
+{
+    report rep{"spsc_ringbuffer<message, 1024> 1p/1c", {}, {}};
+    auto buffer = std::make_unique<t_ut::spsc_ringbuffer<message, 1024>>();
+
+    latency_histogram push_latency;
+    std::thread producer([&]() {
+        for(size_t i = 0; i < opts.operations; ++i)
+        {
+            const uint64_t start = now_ns();
+            while(!buffer->try_push(message{start, 0, static_cast<uint32_t>(i)}))
+                std::this_thread::yield();
+            push_latency.record(now_ns() - start);
+        }
+    });
+
+    latency_histogram pop_latency;
+    latency_histogram end_to_end;
+    for(size_t i = 0; i < opts.operations; ++i)
+    {
+        const uint64_t start = now_ns();
+        std::optional<message> msg;
+        while(!(msg = buffer->try_pop()))
+            std::this_thread::yield();
+        const uint64_t end = now_ns();
+
+        pop_latency.record(end - start);
+        end_to_end.record(end - msg->sent_ns);
+        if(msg->sequence != i)
+        {
+            rep.errors.push_back("expected message " + std::to_string(i) + " but got " + std::to_string(msg->sequence));
+            break;
+        }
+    }
+
+    producer.join();
+    if(!buffer->empty())
+        rep.errors.push_back("buffer not empty after all messages were received");
+
+    rep.histogram("push").merge(push_latency);
+    rep.histogram("pop").merge(pop_latency);
+    rep.histogram("end_to_end").merge(end_to_end);
+    rep.print();
+    return rep;
+}
+
+} // namespace t_ut::stress
@@ -0,0 +1,84 @@
+#ifndef T_UT_STRESS_STRESS_HPP
+#define T_UT_STRESS_STRESS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "latency_histogram.hpp"
+
+namespace t_ut::stress
+{
+
+/// Topology and size of one stress run
+struct options
+{
+    size_t producers = 4;
+    size_t consumers = 4;
+    size_t workers = 4;
+    size_t operations = 100000;
+};
+
+/// Message passed from producers to consumers
+struct message
+{
+    static constexpr uint32_t stop = UINT32_MAX;
+
+    uint64_t sent_ns;
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+inline uint64_t now_ns()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+/// Merged histograms and correctness errors of one stress target
+struct report
+{
+    std::string target;
+    std::vector<std::pair<std::string, latency_histogram>> latencies;
+    std::vector<std::string> errors;
+
+    latency_histogram& histogram(const std::string& name)
+    {
+        for(auto& [latency_name, histogram] : latencies)
+        {
+            if(latency_name == name)
+                return histogram;
+        }
+        return latencies.emplace_back(name, latency_histogram{}).second;
+    }
+
+    void print() const
+    {
+        std::printf("%s\n", target.c_str());
+        std::printf("  %-14s %10s %10s %10s %10s %12s\n", "latency [ns]", "count", "p50", "p99", "p99.9", "max");
+        for(const auto& [name, histogram] : latencies)
+        {
+            std::printf("  %-14s %10llu %10llu %10llu %10llu %12llu\n",
+                name.c_str(),
+                static_cast<unsigned long long>(histogram.count()),
+                static_cast<unsigned long long>(histogram.percentile(50.0)),
+                static_cast<unsigned long long>(histogram.percentile(99.0)),
+                static_cast<unsigned long long>(histogram.percentile(99.9)),
+                static_cast<unsigned long long>(histogram.max()));
+        }
+        for(const auto& error : errors)
+            std::printf("  ERROR: %s\n", error.c_str());
+    }
+};
+
+report run_async_wrapper(const options& opts);
+report run_chan(const options& opts);
+report run_spsc_ringbuffer(const options& opts);
+report run_thread_pool(const options& opts);
+
+} // namespace t_ut::stress
+
+#endif
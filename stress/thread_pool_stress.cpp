@@ -0,0 +1,89 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <t_ut/thread_pool.hpp>
+
+#include "stress.hpp"
+
+namespace t_ut::stress
+{
+
+namespace
+{
+
+std::mutex queue_latency_mutex;
+latency_histogram queue_latency;
+
+/// Every worker records into its own histogram, it is merged when the worker thread exits
+struct worker_histogram
+{
+    ~worker_histogram()
+    {
+        const std::lock_guard<std::mutex> lock{queue_latency_mutex};
+        queue_latency.merge(histogram);
+    }
+
+    latency_histogram histogram;
+};
+
+thread_local worker_histogram local_queue_latency;
+
+} // namespace
+
+/// Producers submit jobs concurrently, the jobs record the time between submission and execution
+/// stop() has to run every job that was submitted before it was called
+report run_thread_pool(const options& opts)
+{
+    report rep{"thread_pool(" + std::to_string(opts.workers) + ") " + std::to_string(opts.producers) + " submitters",
+        {},
+        {}};
+    queue_latency = latency_histogram{};
+
+    std::atomic<size_t> executed = 0;
+    std::mutex report_mutex;
+    {
+        t_ut::thread_pool pool{opts.workers};
+
+        std::vector<std::thread> producers;
+        for(size_t p = 0; p < opts.producers; ++p)
+        {
+            producers.emplace_back([&]() {
+                latency_histogram submit_latency;
+                for(size_t i = 0; i < opts.operations; ++i)
+                {
+                    const uint64_t start = now_ns();
+                    pool.add_job([&executed, start]() {
+                        local_queue_latency.histogram.record(now_ns() - start);
+                        executed.fetch_add(1, std::memory_order_relaxed);
+                    });
+                    submit_latency.record(now_ns() - start);
+                }
+
+                const std::lock_guard<std::mutex> lock{report_mutex};
+                rep.histogram("submit").merge(submit_latency);
+            });
+        }
+
+        for(auto& producer : producers)
+            producer.join();
+        pool.stop();
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock{queue_latency_mutex};
+        rep.histogram("queue").merge(queue_latency);
+    }
+
+    const size_t expected = opts.producers * opts.operations;
+    if(executed.load() != expected)
+    {
+        rep.errors.push_back(
+            "executed " + std::to_string(executed.load()) + " of " + std::to_string(expected) + " jobs");
+    }
+
+    rep.print();
+    return rep;
+}
+
+} // namespace t_ut::stress